@@ -68,10 +68,25 @@
 #include <winsock.h>
 #endif
 
+#include <string.h>
+
 #include <glib.h>
 #include <epan/tvbuff.h>
 #include "asn1.h"
 
+/*
+ * Most octets in a BER encoding are fetched from contiguous memory,
+ * with one bounds check for an entire header or value, rather than
+ * with a "tvb_get_guint8()" call per octet.  If what's wanted isn't
+ * all in the tvbuff, or is encoded in some way the in-memory routines
+ * don't handle, we fall back on decoding it an octet at a time, so that
+ * running past the end of the data throws the same exception, and
+ * leaves the socket at the same offset, as it always has.
+ */
+#define ASN1_MAX_TAG_OCTETS	5	/* enough for a 32-bit tag */
+#define ASN1_MAX_LEN_OCTETS	4	/* enough for a 32-bit length */
+#define ASN1_MAX_HEADER_LEN	(1 + ASN1_MAX_TAG_OCTETS + 1 + ASN1_MAX_LEN_OCTETS)
+
 /*
  * NAME:        asn1_open                                   [API]
  * SYNOPSIS:    void asn1_open
@@ -136,6 +151,110 @@ asn1_octet_decode(ASN1_SCK *asn1, guchar *ch)
     return ASN1_ERR_NOERROR;
 }
 
+/*
+ * NAME:        asn1_contig
+ * SYNOPSIS:    const guchar *asn1_contig
+ *                  (
+ *                      ASN1_SCK *asn1,
+ *                      int       want,
+ *                      int      *availp
+ *                  )
+ * DESCRIPTION: Gets a pointer to the octets at the current offset.
+ *              Parameters:
+ *              asn1:   pointer to ASN1 socket.
+ *              want:   number of octets wanted.
+ *              availp: pointer to variable into which the number of
+ *              octets available, which is no more than "want", is
+ *              to be put.
+ * RETURNS:     pointer to the octets, or NULL if there aren't any
+ */
+static const guchar *
+asn1_contig(ASN1_SCK *asn1, int want, int *availp)
+{
+    int avail;
+
+    avail = tvb_length_remaining(asn1->tvb, asn1->offset);
+    if (avail <= 0 || want <= 0) {
+	*availp = 0;
+	return NULL;
+    }
+    if (avail > want)
+	avail = want;
+    *availp = avail;
+    return tvb_get_ptr(asn1->tvb, asn1->offset, avail);
+}
+
+/*
+ * NAME:        asn1_raw_header_decode
+ * SYNOPSIS:    int asn1_raw_header_decode
+ *                  (
+ *                      const guchar *p,
+ *                      int           avail,
+ *                      guint        *cls,
+ *                      guint        *con,
+ *                      guint        *tag,
+ *                      gboolean     *defp,
+ *                      guint        *lenp
+ *                  )
+ * DESCRIPTION: Decodes an ASN1 header from memory.
+ *              Parameters:
+ *              p:     pointer to the header.
+ *              avail: number of octets at "p".
+ *              The other parameters are as for asn1_header_decode.
+ * RETURNS:     number of octets in the header, or 0 if the header
+ *              isn't all there or has a tag or length too long for
+ *              us to handle here
+ */
+static int
+asn1_raw_header_decode(const guchar *p, int avail, guint *cls, guint *con,
+			guint *tag, gboolean *defp, guint *lenp)
+{
+    int    i;
+    guint  cnt;
+    guchar ch;
+
+    if (avail < 2)
+	return 0;
+    ch = p[0];
+    *cls = (ch & 0xC0) >> 6;
+    *con = (ch & 0x20) >> 5;
+    *tag = (ch & 0x1F);
+    i = 1;
+    if (*tag == 0x1F) {
+	*tag = 0;
+	do {
+	    if (i >= avail || i > ASN1_MAX_TAG_OCTETS)
+		return 0;
+	    ch = p[i++];
+	    *tag <<= 7;
+	    *tag |= ch & 0x7F;
+	} while ((ch & 0x80) == 0x80);
+    }
+    if (i >= avail)
+	return 0;
+    ch = p[i++];
+    if (ch == 0x80) {
+	*defp = FALSE;		/* indefinite length */
+	*lenp = 0;
+    } else {
+	*defp = TRUE;		/* definite length */
+	if (ch < 0x80)
+	    *lenp = ch;
+	else {
+	    cnt = ch & 0x7F;
+	    if (cnt > ASN1_MAX_LEN_OCTETS || i + (int)cnt > avail)
+		return 0;
+	    *lenp = 0;
+	    while (cnt > 0) {
+		*lenp <<= 8;
+		*lenp |= p[i++];
+		cnt--;
+	    }
+	}
+    }
+    return i;
+}
+
 /*
  * NAME:        asn1_tag_decode
  * SYNOPSIS:    int asn1_tag_decode
@@ -267,8 +386,19 @@ int
 asn1_header_decode(ASN1_SCK *asn1, guint *cls, guint *con, guint *tag,
 			gboolean *defp, guint *lenp)
 {
-    int   ret;
-    guint def, len;
+    int          ret;
+    guint        def, len;
+    const guchar *p;
+    int          avail;
+
+    p = asn1_contig (asn1, ASN1_MAX_HEADER_LEN, &avail);
+    if (p != NULL) {
+	ret = asn1_raw_header_decode (p, avail, cls, con, tag, defp, lenp);
+	if (ret != 0) {
+	    asn1->offset += ret;
+	    return ASN1_ERR_NOERROR;
+	}
+    }
 
     ret = asn1_id_decode (asn1, cls, con, tag);
     if (ret != ASN1_ERR_NOERROR)
@@ -424,6 +554,22 @@ asn1_int32_value_decode ( ASN1_SCK *asn1, int enc_len, gint32 *integer)
     int          eoc;
     guchar       ch;
     guint        len;
+    const guchar *p;
+    int          avail;
+    int          i;
+
+    if (enc_len >= 1 && enc_len <= (int)sizeof (gint32)) {
+	p = asn1_contig (asn1, enc_len, &avail);
+	if (avail == enc_len) {
+	    *integer = (gint) p[0];
+	    for (i = 1; i < enc_len; i++) {
+		*integer <<= 8;
+		*integer |= p[i];
+	    }
+	    asn1->offset += enc_len;
+	    return ASN1_ERR_NOERROR;
+	}
+    }
 
     eoc = asn1->offset + enc_len;
     ret = asn1_octet_decode (asn1, &ch);
@@ -511,6 +657,27 @@ asn1_uint32_value_decode ( ASN1_SCK *asn1, int enc_len, guint *integer)
     int          eoc;
     guchar       ch;
     guint        len;
+    const guchar *p;
+    int          avail;
+    int          i;
+
+    /*
+     * An unsigned value with the top bit set has a leading zero
+     * octet, so it can take one more octet than a signed one.
+     */
+    if (enc_len >= 1 && enc_len <= (int)sizeof (guint32) + 1) {
+	p = asn1_contig (asn1, enc_len, &avail);
+	if (avail == enc_len &&
+	    (enc_len <= (int)sizeof (guint32) || p[0] == 0)) {
+	    *integer = p[0];
+	    for (i = 1; i < enc_len; i++) {
+		*integer <<= 8;
+		*integer |= p[i];
+	    }
+	    asn1->offset += enc_len;
+	    return ASN1_ERR_NOERROR;
+	}
+    }
 
     eoc = asn1->offset + enc_len;
     ret = asn1_octet_decode (asn1, &ch);
@@ -645,6 +812,18 @@ asn1_string_value_decode ( ASN1_SCK *asn1, int enc_len, guchar **octets)
     int          ret;
     int          eoc;
     guchar       *ptr;
+    const guchar *p;
+    int          avail;
+
+    if (enc_len > 0) {
+	p = asn1_contig (asn1, enc_len, &avail);
+	if (avail == enc_len) {
+	    *octets = g_malloc (enc_len);
+	    memcpy (*octets, p, enc_len);
+	    asn1->offset += enc_len;
+	    return ASN1_ERR_NOERROR;
+	}
+    }
 
     eoc = asn1->offset + enc_len;
     *octets = g_malloc (enc_len);
@@ -768,6 +947,63 @@ asn1_subid_decode ( ASN1_SCK *asn1, subid_t *subid)
     return ASN1_ERR_NOERROR;
 }
 
+/*
+ * NAME:        asn1_raw_oid_decode
+ * SYNOPSIS:    gboolean asn1_raw_oid_decode
+ *                  (
+ *                      const guchar *p,
+ *                      int           enc_len,
+ *                      subid_t      *optr,
+ *                      guint        *len
+ *                  )
+ * DESCRIPTION: Decodes value portion of Object Identifier from memory.
+ *              Parameters:
+ *              p:       pointer to the value.
+ *              enc_len: length of encoding of value; there must be
+ *              at least one octet.
+ *              optr:    buffer for the Sub Identifiers, with room for
+ *              at least enc_len + 1 of them.
+ *              len:     Length of Object Identifier in Sub Identifiers.
+ * RETURNS:     TRUE on success, FALSE if the last Sub Identifier runs
+ *              past the end of the value
+ */
+static gboolean
+asn1_raw_oid_decode(const guchar *p, int enc_len, subid_t *optr, guint *len)
+{
+    const guchar *end;
+    subid_t      subid;
+    guchar       ch;
+
+    end = p + enc_len;
+    *len = 0;
+    while (p < end) {
+	subid = 0;
+	do {
+	    if (p >= end)
+		return FALSE;
+	    ch = *p++;
+	    subid <<= 7;
+	    subid |= ch & 0x7F;
+	} while ((ch & 0x80) == 0x80);
+	if (*len != 0)
+	    optr[(*len)++] = subid;
+	else if (subid < 40) {
+	    optr[0] = 0;
+	    optr[1] = subid;
+	    *len = 2;
+	} else if (subid < 80) {
+	    optr[0] = 1;
+	    optr[1] = subid - 40;
+	    *len = 2;
+	} else {
+	    optr[0] = 2;
+	    optr[1] = subid - 80;
+	    *len = 2;
+	}
+    }
+    return TRUE;
+}
+
 /*
  * NAME:        asn1_oid_value_decode                                [API]
  * SYNOPSIS:    int asn1_oid_value_decode
@@ -793,11 +1029,21 @@ asn1_oid_value_decode ( ASN1_SCK *asn1, int enc_len, subid_t **oid, guint *len)
     subid_t      subid;
     guint        size;
     subid_t      *optr;
+    const guchar *p;
+    int          avail;
 
     eoc = asn1->offset + enc_len;
     size = enc_len + 1;
     *oid = g_malloc(size * sizeof(gulong));
     optr = *oid;
+
+    if (enc_len > 0) {
+	p = asn1_contig (asn1, enc_len, &avail);
+	if (avail == enc_len && asn1_raw_oid_decode (p, enc_len, optr, len)) {
+	    asn1->offset = eoc;
+	    return ASN1_ERR_NOERROR;
+	}
+    }
  
     ret = asn1_subid_decode (asn1, &subid);
     if (ret != ASN1_ERR_NOERROR) {
@@ -926,3 +1172,162 @@ done:
     *nbytes = asn1->offset - start;
     return ret;
 }
+
+/*
+ * NAME:        asn1_sequence_iter_init                          [API]
+ * SYNOPSIS:    void asn1_sequence_iter_init
+ *                  (
+ *                      ASN1_SEQ_ITER *iter,
+ *                      ASN1_SCK      *asn1,
+ *                      guint          seq_len
+ *                  )
+ * DESCRIPTION: Sets up an iterator over the elements of a SEQUENCE,
+ *              SET, or other constructed encoding whose header has
+ *              just been decoded.  If the contents are all in the
+ *              tvbuff, they're fetched once, and the elements' headers
+ *              are decoded from memory.
+ *              Parameters:
+ *              iter:    pointer to iterator.
+ *              asn1:    pointer to ASN1 socket, at the first element.
+ *              seq_len: length of the contents.
+ * RETURNS:     void
+ */
+void
+asn1_sequence_iter_init ( ASN1_SEQ_ITER *iter, ASN1_SCK *asn1, guint seq_len)
+{
+    int avail;
+
+    iter->asn1 = asn1;
+    iter->eoc = asn1->offset + seq_len;
+    iter->next = asn1->offset;
+    iter->data_offset = asn1->offset;
+    iter->data = asn1_contig (asn1, seq_len, &avail);
+    if (avail != (int)seq_len)
+	iter->data = NULL;
+}
+
+/*
+ * NAME:        asn1_sequence_iter_done                          [API]
+ * SYNOPSIS:    gboolean asn1_sequence_iter_done
+ *                  (
+ *                      ASN1_SEQ_ITER *iter
+ *                  )
+ * DESCRIPTION: Checks whether there are any more elements.
+ *              Parameters:
+ *              iter: pointer to iterator.
+ * RETURNS:     TRUE if there are no more elements
+ */
+gboolean
+asn1_sequence_iter_done ( ASN1_SEQ_ITER *iter)
+{
+    int offset;
+
+    offset = (iter->next != -1) ? iter->next : iter->asn1->offset;
+    return (offset >= iter->eoc);
+}
+
+/*
+ * NAME:        asn1_sequence_iter_next                          [API]
+ * SYNOPSIS:    int asn1_sequence_iter_next
+ *                  (
+ *                      ASN1_SEQ_ITER *iter,
+ *                      ASN1_ELEM     *elem
+ *                  )
+ * DESCRIPTION: Decodes the header of the next element, and leaves the
+ *              socket at the element's value, so that it can be decoded
+ *              with one of the "_value_decode" routines.  The value
+ *              needn't be decoded; if it's of definite length, the next
+ *              call skips past it.  A value of indefinite length must be
+ *              decoded, along with its End Of Contents, before the next
+ *              call.
+ *              Parameters:
+ *              iter: pointer to iterator.
+ *              elem: pointer to variable into which the element's
+ *              header is to be put.
+ * RETURNS:     ASN1_ERR value (ASN1_ERR_NOERROR on success)
+ */
+int
+asn1_sequence_iter_next ( ASN1_SEQ_ITER *iter, ASN1_ELEM *elem)
+{
+    ASN1_SCK *asn1 = iter->asn1;
+    int      ret;
+
+    if (iter->next != -1)
+	asn1->offset = iter->next;
+    if (asn1->offset >= iter->eoc)
+	return ASN1_ERR_LENGTH_MISMATCH;
+    elem->offset = asn1->offset;
+
+    ret = 0;
+    if (iter->data != NULL && asn1->offset >= iter->data_offset) {
+	ret = asn1_raw_header_decode (
+	    iter->data + (asn1->offset - iter->data_offset),
+	    iter->eoc - asn1->offset, &elem->cls, &elem->con, &elem->tag,
+	    &elem->def, &elem->len);
+    }
+    if (ret != 0)
+	asn1->offset += ret;
+    else {
+	ret = asn1_header_decode (asn1, &elem->cls, &elem->con, &elem->tag,
+	    &elem->def, &elem->len);
+	if (ret != ASN1_ERR_NOERROR)
+	    return ret;
+    }
+    elem->value_offset = asn1->offset;
+
+    if (elem->def) {
+	if (asn1->offset > iter->eoc
+	    || elem->len > (guint)(iter->eoc - asn1->offset))
+	    return ASN1_ERR_LENGTH_MISMATCH;
+	iter->next = asn1->offset + elem->len;
+    } else
+	iter->next = -1;
+    return ASN1_ERR_NOERROR;
+}
+
+/*
+ * NAME:        asn1_sequence_walk                               [API]
+ * SYNOPSIS:    int asn1_sequence_walk
+ *                  (
+ *                      ASN1_SCK  *asn1,
+ *                      guint      seq_len,
+ *                      ASN1_ELEM *elems,
+ *                      guint      max_elems,
+ *                      guint     *nelems
+ *                  )
+ * DESCRIPTION: Decodes the headers of all the elements of a SEQUENCE,
+ *              SET, or other constructed encoding whose header has
+ *              just been decoded, in one pass.  All the elements must
+ *              have definite lengths.
+ *              Parameters:
+ *              asn1:      pointer to ASN1 socket, at the first element;
+ *              on success, it's left after the last element decoded.
+ *              seq_len:   length of the contents.
+ *              elems:     array into which the headers are to be put.
+ *              max_elems: number of entries in "elems"; if there are
+ *              more elements than that, the rest aren't decoded.
+ *              nelems:    pointer to variable into which the number of
+ *              headers decoded is to be put.
+ * RETURNS:     ASN1_ERR value (ASN1_ERR_NOERROR on success)
+ */
+int
+asn1_sequence_walk ( ASN1_SCK *asn1, guint seq_len, ASN1_ELEM *elems,
+			guint max_elems, guint *nelems)
+{
+    ASN1_SEQ_ITER iter;
+    int           ret;
+
+    *nelems = 0;
+    asn1_sequence_iter_init (&iter, asn1, seq_len);
+    while (*nelems < max_elems && !asn1_sequence_iter_done (&iter)) {
+	ret = asn1_sequence_iter_next (&iter, &elems[*nelems]);
+	if (ret != ASN1_ERR_NOERROR)
+	    return ret;
+	if (!elems[*nelems].def)
+	    return ASN1_ERR_LENGTH_NOT_DEFINITE;
+	(*nelems)++;
+    }
+    if (iter.next != -1)
+	asn1->offset = iter.next;
+    return ASN1_ERR_NOERROR;
+}
@@ -111,6 +111,32 @@ struct _ASN1_SCK
     int offset;             /* Current offset in tvbuff            */
 };
 
+typedef struct _ASN1_ELEM ASN1_ELEM;
+
+struct _ASN1_ELEM
+{                           /* Header of an element of a SEQUENCE  */
+    guint cls;              /* Class                               */
+    guint con;              /* Primitive, Constructed              */
+    guint tag;              /* Tag                                 */
+    gboolean def;           /* TRUE if length definite             */
+    guint len;              /* Length of value, if definite        */
+    int offset;             /* Offset of header in tvbuff          */
+    int value_offset;       /* Offset of value in tvbuff           */
+};
+
+typedef struct _ASN1_SEQ_ITER ASN1_SEQ_ITER;
+
+struct _ASN1_SEQ_ITER
+{                           /* Iterator over a SEQUENCE            */
+    ASN1_SCK *asn1;         /* ASN1 socket                         */
+    int eoc;                /* Offset of end of SEQUENCE           */
+    int next;               /* Offset of next element, or -1 if
+                               it's wherever the socket is         */
+    const guchar *data;     /* Contents of SEQUENCE, or NULL if
+                               they're not all in the tvbuff       */
+    int data_offset;        /* Offset of "data" in tvbuff          */
+};
+
 void asn1_open (ASN1_SCK *asn1, tvbuff_t *tvb, int offset);
 void asn1_close (ASN1_SCK *asn1, int *offset);
 int asn1_octet_decode (ASN1_SCK *asn1, guchar *ch);
@@ -140,4 +166,10 @@ int asn1_oid_value_decode (ASN1_SCK *asn1, int enc_len, subid_t **oid,
 			guint *len);
 int asn1_oid_decode ( ASN1_SCK *asn1, subid_t **oid, guint *len, guint *nbytes);
 int asn1_sequence_decode ( ASN1_SCK *asn1, guint *seq_len, guint *nbytes);
+void asn1_sequence_iter_init ( ASN1_SEQ_ITER *iter, ASN1_SCK *asn1,
+			guint seq_len);
+gboolean asn1_sequence_iter_done ( ASN1_SEQ_ITER *iter);
+int asn1_sequence_iter_next ( ASN1_SEQ_ITER *iter, ASN1_ELEM *elem);
+int asn1_sequence_walk ( ASN1_SCK *asn1, guint seq_len, ASN1_ELEM *elems,
+			guint max_elems, guint *nelems);
 #endif
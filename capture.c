@@ -101,6 +101,10 @@
 
 #include <pcap.h>
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #ifdef NEED_SNPRINTF_H
 # include "snprintf.h"
 #endif
@@ -135,6 +139,17 @@
 # define MUST_DO_SELECT
 #endif
 
+/*
+ * In sync mode, the capture child copies each packet it writes to the
+ * capture file into a "live feed" ring, in memory it shares with us,
+ * so that we can process the packets it tells us about without reading
+ * them back from the capture file.  The memory is a mapping of an
+ * unlinked temporary file, to which the child inherits a descriptor.
+ */
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H) && !defined(_WIN32)
+# define USE_LIVE_FEED
+#endif
+
 #include "gtk/main.h"
 #include "gtk/gtkglobals.h"
 #include <epan/packet.h>
@@ -148,6 +163,7 @@
 #include "conditions.h"
 #include "capture_stop_conditions.h"
 #include "ringbuffer.h"
+#include "capture_ring.h"
 
 #include "wiretap/libpcap.h"
 #include "wiretap/wtap.h"
@@ -178,6 +194,23 @@ enum PIPES { READ, WRITE }; /* Constants 0 and 1 for READ and WRITE */
 int quit_after_cap; /* Makes a "capture only mode". Implies -k */
 gboolean capture_child;	/* if this is the child for "-S" */
 static int fork_child = -1;	/* If not -1, in parent, process ID of child */
+int live_feed_fd = -1;	/* In child, descriptor for the live feed, or -1 */
+
+#ifdef USE_LIVE_FEED
+/* Bytes of packet records in the live feed. */
+#define LIVE_FEED_SIZE	(4*1024*1024)
+
+static capture_ring_t *live_feed;	/* In parent, the live feed, or NULL */
+static long live_feed_end;	/* offset in the capture file just past the
+				   last packet we processed from the live
+				   feed, or -1 if we haven't processed any */
+
+static int create_live_feed(void);
+static void destroy_live_feed(void);
+static read_status_t skip_live_feed_packets(capture_file *, int *);
+#else
+#define destroy_live_feed()
+#endif
 static guint cap_input_id;
 
 /*
@@ -194,6 +227,7 @@ static int cap_timer_cb(gpointer); /* Win32 kludge to check for pipe input */
 #endif
 
 static void cap_file_input_cb(gpointer, gint, GdkInputCondition);
+static read_status_t read_tail_packets(capture_file *, int, int *);
 static void wait_for_child(gboolean);
 #ifndef _WIN32
 static char *signame(int);
@@ -219,6 +253,10 @@ typedef struct _loop_data {
   gboolean       byte_swapped; /* TRUE if data in the pipe is byte swapped */
   packet_counts  counts;
   wtap_dumper   *pdh;
+#ifdef USE_LIVE_FEED
+  capture_ring_t *feed;        /* live feed to our parent, if any */
+  size_t         feed_len;
+#endif
 } loop_data;
 
 #ifndef _WIN32
@@ -295,7 +333,8 @@ do_capture(char *capfile_name)
   if (capfile_name != NULL) {
     if (cfile.ringbuffer_on) {
       /* ringbuffer is enabled */
-      cfile.save_file_fd = ringbuf_init(capfile_name, cfile.ringbuffer_num_files);
+      cfile.save_file_fd = ringbuf_init(capfile_name, cfile.ringbuffer_num_files,
+        (long)cfile.autostop_filesize * 1000);
     } else {
       /* Try to open/create the specified file for use as a capture buffer. */
       cfile.save_file_fd = open(capfile_name, O_RDWR|O_BINARY|O_TRUNC|O_CREAT, 0600);
@@ -331,6 +370,10 @@ do_capture(char *capfile_name)
     char sautostop_filesize[24];	/* need a constant for len of numbers */
     char sautostop_duration[24];	/* need a constant for len of numbers */
     char save_file_fd[24];
+#ifdef USE_LIVE_FEED
+    char feed_fd_str[24];
+    int feed_fd;
+#endif
     char errmsg[1024+1];
     int error;
     int argc;
@@ -419,7 +462,6 @@ do_capture(char *capfile_name)
     /* Keep a copy for later evaluation by _cwait() */
     child_process = fork_child;
 #else
-    signal(SIGCHLD, SIG_IGN);
     if (pipe(sync_pipe) < 0) {
       /* Couldn't create the pipe between parent and child. */
       error = errno;
@@ -434,6 +476,17 @@ do_capture(char *capfile_name)
     argv = add_arg(argv, &argc, "-m");
     argv = add_arg(argv, &argc, prefs.gui_font_name);
 
+#ifdef USE_LIVE_FEED
+    /* If we can't set up the live feed, we just read the packets from
+       the capture file. */
+    feed_fd = create_live_feed();
+    if (feed_fd != -1) {
+      argv = add_arg(argv, &argc, "-Y");
+      sprintf(feed_fd_str,"%d",feed_fd);
+      argv = add_arg(argv, &argc, feed_fd_str);
+    }
+#endif
+
     if (cfile.cfilter != NULL && strlen(cfile.cfilter) != 0) {
       argv = add_arg(argv, &argc, "-f");
       argv = add_arg(argv, &argc, cfile.cfilter);
@@ -467,6 +520,12 @@ do_capture(char *capfile_name)
 	 our parent). */
       _exit(2);
     }
+#ifdef USE_LIVE_FEED
+    /* The child has the descriptor for the live feed; we just need
+       our mapping of it. */
+    if (feed_fd != -1)
+      close(feed_fd);
+#endif
 #endif
 
     /* Parent process - read messages from the child process over the
@@ -487,6 +546,7 @@ do_capture(char *capfile_name)
       /* We couldn't even create the child process. */
       error = errno;
       close(sync_pipe[READ]);
+      destroy_live_feed();
       unlink(cfile.save_file);
       g_free(cfile.save_file);
       cfile.save_file = NULL;
@@ -508,6 +568,7 @@ do_capture(char *capfile_name)
 	   Close the read side of the sync pipe, remove the capture file,
 	   and report the failure. */
 	close(sync_pipe[READ]);
+	destroy_live_feed();
 	unlink(cfile.save_file);
 	g_free(cfile.save_file);
 	cfile.save_file = NULL;
@@ -521,6 +582,7 @@ do_capture(char *capfile_name)
 	   Close the read side of the sync pipe, remove the capture file,
 	   and report the failure. */
 	close(sync_pipe[READ]);
+	destroy_live_feed();
 	unlink(cfile.save_file);
 	g_free(cfile.save_file);
 	cfile.save_file = NULL;
@@ -561,6 +623,7 @@ do_capture(char *capfile_name)
 
 	/* Close the sync pipe. */
 	close(sync_pipe[READ]);
+	destroy_live_feed();
 
 	/* Don't unlink the save file - leave it around, for debugging
 	   purposes. */
@@ -597,6 +660,7 @@ do_capture(char *capfile_name)
 
 	/* Close the sync pipe. */
 	close(sync_pipe[READ]);
+	destroy_live_feed();
 
 	/* Get rid of the save file - the capture never started. */
 	unlink(cfile.save_file);
@@ -741,6 +805,18 @@ cap_file_input_cb(gpointer data, gint source, GdkInputCondition condition)
        complain if it did anything other than exit with status 0. */
     wait_for_child(FALSE);
       
+#ifdef USE_LIVE_FEED
+    /* If we're still getting packets from the live feed, the child may
+       have written packets to the capture file that it never told us
+       about, if it died or gave up before sending its final packet
+       count; skip the packets we got from the feed, so that we read
+       any after them from the file rather than losing them. */
+    if (live_feed != NULL) {
+      destroy_live_feed();
+      skip_live_feed_packets(cf, &err);
+    }
+#endif
+
     /* Read what remains of the capture file, and finish the capture.
        XXX - do something if this fails? */
     switch (finish_tail_cap_file(cf, &err)) {
@@ -755,9 +831,11 @@ cap_file_input_cb(gpointer data, gint source, GdkInputCondition condition)
     case READ_ABORTED:
       /* Exit by leaving the main loop, so that any quit functions
          we registered get called. */
+      destroy_live_feed();
       gtk_main_quit();
       return;
     }
+    destroy_live_feed();
 
     /* We're not doing a capture any more, so we don't have a save
        file. */
@@ -822,10 +900,9 @@ cap_file_input_cb(gpointer data, gint source, GdkInputCondition condition)
     } 
   }
 
-  /* Read from the capture file the number of records the child told us
-     it added.
+  /* Process the number of records the child told us it added.
      XXX - do something if this fails? */
-  switch (continue_tail_cap_file(cf, to_read, &err)) {
+  switch (read_tail_packets(cf, to_read, &err)) {
 
   case READ_SUCCESS:
   case READ_ERROR:
@@ -860,6 +937,94 @@ cap_file_input_cb(gpointer data, gint source, GdkInputCondition condition)
 #endif
 }
 
+/* Process "to_read" packets that the child has added to the capture
+   file, taking them from the live feed if we have one. */
+static read_status_t
+read_tail_packets(capture_file *cf, int to_read, int *err)
+{
+#ifdef USE_LIVE_FEED
+  read_status_t status;
+
+  if (live_feed != NULL) {
+    status = continue_tail_cap_file_from_ring(cf, live_feed, &to_read,
+                                              &live_feed_end);
+    if (status != READ_SUCCESS || to_read == 0) {
+      *err = 0;
+      return status;
+    }
+
+    /* The child told us about packets that aren't in the live feed,
+       which means the feed filled up and the child stopped using it;
+       read those packets, and all the ones after them, from the
+       capture file, skipping the ones we got from the feed. */
+    destroy_live_feed();
+    status = skip_live_feed_packets(cf, err);
+    if (status != READ_SUCCESS)
+      return status;
+  }
+#endif
+  return continue_tail_cap_file(cf, to_read, err);
+}
+
+#ifdef USE_LIVE_FEED
+/* Move the sequential read position in the capture file past the packets
+   we processed from the live feed, so that we next read the packet after
+   them; the feed tells us where each packet's data is in the file, so we
+   can seek straight there rather than reading through them all again. */
+static read_status_t
+skip_live_feed_packets(capture_file *cf, int *err)
+{
+  *err = 0;
+  if (live_feed_end == -1)
+    return READ_SUCCESS;	/* nothing to skip */
+  if (!wtap_seek_sequential(cf->wth, live_feed_end, err))
+    return READ_ERROR;
+  return READ_SUCCESS;
+}
+
+/* Create the live feed, returning a descriptor for the child to map it
+   through, or -1 if we couldn't create it. */
+static int
+create_live_feed(void)
+{
+  char tmpname[128+1];
+  int fd;
+  void *mem;
+
+  live_feed = NULL;
+  live_feed_end = -1;
+
+  /* The file just backs the memory we share with the child; nobody
+     else needs to get at it. */
+  fd = create_tempfile(tmpname, sizeof tmpname, "etherfeed");
+  if (fd == -1)
+    return -1;
+  unlink(tmpname);
+  if (ftruncate(fd, CAPTURE_RING_MEM_SIZE(LIVE_FEED_SIZE)) == -1) {
+    close(fd);
+    return -1;
+  }
+  mem = mmap(NULL, CAPTURE_RING_MEM_SIZE(LIVE_FEED_SIZE),
+             PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mem == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+  live_feed = mem;
+  capture_ring_init(live_feed, LIVE_FEED_SIZE);
+  return fd;
+}
+
+static void
+destroy_live_feed(void)
+{
+  if (live_feed != NULL) {
+    munmap((void *)live_feed, CAPTURE_RING_MEM_SIZE(LIVE_FEED_SIZE));
+    live_feed = NULL;
+  }
+}
+#endif
+
 static void
 wait_for_child(gboolean always_report)
 {
@@ -872,7 +1037,9 @@ wait_for_child(gboolean always_report)
     simple_dialog(ESD_TYPE_WARN, NULL, "Child capture process stopped unexpectedly");
   }
 #else
-  if (wait(&wstatus) != -1) {
+  /* Wait for the capture child in particular; we may have other
+     children, such as the host name resolver, that are still running. */
+  if (waitpid(fork_child, &wstatus, 0) != -1) {
     if (WIFEXITED(wstatus)) {
       /* The child exited; display its exit status, if it's not zero,
          and even if it's zero if "always_report" is true. */
@@ -1329,6 +1496,9 @@ capture(gboolean *stats_known, struct pcap_stat *stats)
   ld.pcap_err       = FALSE;
   ld.from_pipe      = FALSE;
   ld.sync_packets   = 0;
+#ifdef USE_LIVE_FEED
+  ld.feed           = NULL;
+#endif
   ld.counts.sctp    = 0;
   ld.counts.tcp     = 0;
   ld.counts.udp     = 0;
@@ -1523,6 +1693,19 @@ capture(gboolean *stats_known, struct pcap_stat *stats)
        message to our parent so that they'll open the capture file and
        update its windows to indicate that we have a live capture in
        progress. */
+#ifdef USE_LIVE_FEED
+    /* If our parent gave us a live feed, copy the packets we write to
+       the capture file into it as well.  Our parent set it up before
+       starting us, so we just map it. */
+    if (live_feed_fd != -1 && !cfile.ringbuffer_on) {
+      void *mem;
+
+      mem = mmap(NULL, CAPTURE_RING_MEM_SIZE(LIVE_FEED_SIZE),
+                 PROT_READ|PROT_WRITE, MAP_SHARED, live_feed_fd, 0);
+      if (mem != MAP_FAILED)
+        ld.feed = mem;
+    }
+#endif
     fflush(wtap_dump_file(ld.pdh));
     write(1, &capstart_msg, 1);
   }
@@ -1680,6 +1863,11 @@ capture(gboolean *stats_known, struct pcap_stat *stats)
     }
     if (inpkts > 0)
       ld.sync_packets += inpkts;
+    else if (inpkts == 0 && cfile.ringbuffer_on) {
+      /* Nothing to capture right now; catch up on writing out the
+         ringbuffer file we last switched away from. */
+      ringbuf_flush_idle();
+    }
     /* check capture stop conditons */
     if (cnd_eval(cnd_stop_timeout) == TRUE) {
       /* The specified capture time has elapsed; stop the capture. */
@@ -1792,6 +1980,27 @@ capture(gboolean *stats_known, struct pcap_stat *stats)
       }
     }
   }
+#ifdef USE_LIVE_FEED
+  if (capture_child && live_feed_fd != -1) {
+    /* Our parent doesn't read the rest of the capture file when we
+       finish if it's getting packets from the live feed, so tell it
+       about the packets we've written since the last count we sent;
+       the capture file has been closed, so if the feed filled up,
+       it can read them from the file. */
+    if (ld.sync_packets) {
+      char tmp[20];
+      sprintf(tmp, "%d%c", ld.sync_packets, SP_PACKET_COUNT);
+      write(1, tmp, strlen(tmp));
+      ld.sync_packets = 0;
+    }
+    if (ld.feed != NULL) {
+      munmap((void *)ld.feed, CAPTURE_RING_MEM_SIZE(LIVE_FEED_SIZE));
+      ld.feed = NULL;
+    }
+    close(live_feed_fd);
+    live_feed_fd = -1;
+  }
+#endif
 #ifndef _WIN32
   if (ld.from_pipe)
     close(pipe_fd);
@@ -2013,6 +2222,19 @@ capture_pcap_cb(u_char *user, const struct pcap_pkthdr *phdr,
        ld->go = FALSE;
        ld->err = err;
      }
+#ifdef USE_LIVE_FEED
+     else if (ld->feed != NULL) {
+       /* Our parent processes packets in the order we tell it about
+          them, so once one doesn't fit in the live feed, we stop using
+          the feed, and our parent reads that packet and all the ones
+          after it from the capture file. */
+       if (!capture_ring_put(ld->feed, &whdr, pd,
+                             wtap_get_bytes_dumped(ld->pdh) - whdr.caplen)) {
+         munmap((void *)ld->feed, CAPTURE_RING_MEM_SIZE(LIVE_FEED_SIZE));
+         ld->feed = NULL;
+       }
+     }
+#endif
   }
 
   switch (ld->linktype) {
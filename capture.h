@@ -38,6 +38,7 @@ extern int sync_mode;	/* fork a child to do the capture, and sync between them *
 extern int sync_pipe[2]; /* used to sync father */
 extern int quit_after_cap; /* Makes a "capture only mode". Implies -k */
 extern gboolean capture_child;	/* if this is the child for "-S" */
+extern int live_feed_fd;	/* in the child, FD for packets for our parent */
 
 /* Open a specified file, or create a temporary file, and start a capture
    to the file in question. */
@@ -0,0 +1,150 @@
+/* capture_ring.c
+ * Routines for a ring of captured packets
+ *
+ * $Id$
+ *
+ * Ethereal - Network traffic analyzer
+ * By Gerald Combs <gerald@ethereal.com>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "capture_ring.h"
+
+#define RING_RECORDS(ring)	((guint8 *)((ring) + 1))
+#define RING_REC(ring, off)	((capture_ring_rec_t *)(RING_RECORDS(ring) + (off)))
+
+/* Length of the record for a packet with "caplen" bytes of data. */
+#define REC_LEN(caplen)	\
+	(sizeof (capture_ring_rec_t) + (((caplen) + 3) & ~3U))
+
+capture_ring_t *
+capture_ring_new(guint32 size)
+{
+	capture_ring_t *ring;
+
+	ring = g_malloc(CAPTURE_RING_MEM_SIZE(size));
+	capture_ring_init(ring, size);
+	return ring;
+}
+
+void
+capture_ring_init(capture_ring_t *ring, guint32 size)
+{
+	ring->size = size & ~3U;
+	ring->head = 0;
+	ring->tail = 0;
+	ring->dropped = 0;
+}
+
+void
+capture_ring_free(capture_ring_t *ring)
+{
+	g_free(ring);
+}
+
+gboolean
+capture_ring_put(capture_ring_t *ring, const struct wtap_pkthdr *phdr,
+    const guchar *pd, long file_off)
+{
+	guint32 rec_len = REC_LEN(phdr->caplen);
+	guint32 head = ring->head;
+	guint32 tail = ring->tail;
+	capture_ring_rec_t *rec;
+
+	/*
+	 * The ring mustn't fill up completely, or "head" would end up
+	 * equal to "tail", and it would look empty.
+	 */
+	if (head >= tail) {
+		if (ring->size - head < rec_len ||
+		    (ring->size - head == rec_len && tail == 0)) {
+			/* No room at the end; try the beginning. */
+			if (tail <= rec_len)
+				goto drop;
+			RING_REC(ring, head)->rec_len = 0;
+			head = 0;
+		}
+	} else {
+		if (tail - head <= rec_len)
+			goto drop;
+	}
+
+	rec = RING_REC(ring, head);
+	rec->rec_len = rec_len;
+	rec->ts_sec = phdr->ts.tv_sec;
+	rec->ts_usec = phdr->ts.tv_usec;
+	rec->caplen = phdr->caplen;
+	rec->len = phdr->len;
+	rec->pkt_encap = phdr->pkt_encap;
+	rec->file_off = file_off;
+	memcpy(rec + 1, pd, phdr->caplen);
+
+	head += rec_len;
+	if (head == ring->size)
+		head = 0;
+	ring->head = head;
+	return TRUE;
+
+drop:
+	ring->dropped++;
+	return FALSE;
+}
+
+const guchar *
+capture_ring_get(capture_ring_t *ring, struct wtap_pkthdr *phdr,
+    long *file_off)
+{
+	capture_ring_rec_t *rec;
+
+	if (capture_ring_is_empty(ring))
+		return NULL;
+	rec = RING_REC(ring, ring->tail);
+	if (rec->rec_len == 0) {
+		/* The next record is at the beginning of the ring. */
+		ring->tail = 0;
+		if (capture_ring_is_empty(ring))
+			return NULL;
+		rec = RING_REC(ring, 0);
+	}
+	phdr->ts.tv_sec = rec->ts_sec;
+	phdr->ts.tv_usec = rec->ts_usec;
+	phdr->caplen = rec->caplen;
+	phdr->len = rec->len;
+	phdr->pkt_encap = rec->pkt_encap;
+	if (file_off != NULL)
+		*file_off = rec->file_off;
+	return (const guchar *)(rec + 1);
+}
+
+void
+capture_ring_release(capture_ring_t *ring)
+{
+	guint32 tail;
+
+	tail = ring->tail + RING_REC(ring, ring->tail)->rec_len;
+	if (tail == ring->size)
+		tail = 0;
+	ring->tail = tail;
+}
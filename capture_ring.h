@@ -0,0 +1,101 @@
+/* capture_ring.h
+ * Definitions for a ring of captured packets
+ *
+ * $Id$
+ *
+ * Ethereal - Network traffic analyzer
+ * By Gerald Combs <gerald@ethereal.com>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __CAPTURE_RING_H__
+#define __CAPTURE_RING_H__
+
+#include "wiretap/wtap.h"
+
+/*
+ * A capture ring is a fixed-size area of memory into which the code
+ * reading packets from the capture device copies them, and from which
+ * the code processing them takes them, in the order in which they
+ * arrived.  Copying a packet into the ring is cheap, so the capture
+ * device can be kept drained even when processing a packet takes a
+ * long time; if the ring fills up, packets are dropped, and counted.
+ *
+ * The ring is a "capture_ring_t" followed by "size" bytes of records.
+ * Each record is a "capture_ring_rec_t" followed by "caplen" bytes of
+ * packet data, padded to a multiple of 4 bytes; "rec_len" is the length
+ * of the entire record.  A record never wraps around the end of the
+ * ring; if a record won't fit at the end, a record with a "rec_len" of
+ * 0 is put there, and the record goes at the beginning of the ring.
+ *
+ * "head" is the offset of the place where the next record will be put,
+ * and "tail" is the offset of the next record to be taken; the ring is
+ * empty if they're equal.  All offsets are relative to the beginning
+ * of the records, and all values are in host byte order, so the ring
+ * can be put in memory shared between two processes on the same machine,
+ * with one of them putting packets into it and the other taking them.
+ * Only the writer changes "head", and only the reader changes "tail";
+ * there's no locking, so the writer must tell the reader about records
+ * it has put into the ring through something, such as a pipe, that
+ * makes sure the reader sees the records once it's been told about them.
+ */
+typedef struct {
+	guint32	size;		/* bytes of records after this header */
+	guint32	head;		/* where the next record goes */
+	guint32	tail;		/* the next record to take */
+	guint32	dropped;	/* packets dropped because the ring was full */
+} capture_ring_t;
+
+typedef struct {
+	guint32	rec_len;	/* length of this record, or 0 to wrap */
+	guint32	ts_sec;
+	guint32	ts_usec;
+	guint32	caplen;
+	guint32	len;
+	gint32	pkt_encap;
+	guint32	file_off;	/* offset of the data in a capture file, if any */
+} capture_ring_rec_t;
+
+#define capture_ring_is_empty(ring)	((ring)->head == (ring)->tail)
+
+/* Number of bytes of memory needed for a ring with "size" bytes of
+   records. */
+#define CAPTURE_RING_MEM_SIZE(size)	(sizeof (capture_ring_t) + (size))
+
+capture_ring_t *capture_ring_new(guint32 size);
+void capture_ring_free(capture_ring_t *ring);
+
+/* Set up an empty ring in "CAPTURE_RING_MEM_SIZE(size)" bytes of memory
+   allocated by the caller. */
+void capture_ring_init(capture_ring_t *ring, guint32 size);
+
+/* Copy a packet into the ring, along with the offset of its data in the
+   file to which it's being written, if any; returns FALSE, and counts
+   the packet as dropped, if there's no room for it. */
+gboolean capture_ring_put(capture_ring_t *ring,
+    const struct wtap_pkthdr *phdr, const guchar *pd, long file_off);
+
+/* Get the oldest packet in the ring, filling in "phdr" and, if it's not
+   NULL, "*file_off"; returns a pointer to the packet data, which stays
+   valid until the packet is released, or NULL if the ring is empty. */
+const guchar *capture_ring_get(capture_ring_t *ring,
+    struct wtap_pkthdr *phdr, long *file_off);
+
+/* Remove the packet that "capture_ring_get()" returned from the ring. */
+void capture_ring_release(capture_ring_t *ring);
+
+#endif /* capture_ring.h */
@@ -95,6 +95,18 @@ typedef struct _conv_proto_data {
 
 static GMemChunk *conv_proto_data_area = NULL;
 
+/*
+ * The dissector in a heuristic dissector list that recognized a
+ * conversation; there's one of these for each list that's been tried.
+ */
+struct conv_heur_data {
+	struct conv_heur_data *next;
+	heur_dissector_list_t list;
+	void	*heur_dissector;
+};
+
+static GMemChunk *conv_heur_data_area = NULL;
+
 /*
  * Compute the hash value for two given address/port pairs if the match
  * is to be exact.
@@ -399,6 +411,8 @@ conversation_init(void)
 	 */
 	if (conv_proto_data_area != NULL)
 		g_mem_chunk_destroy(conv_proto_data_area);
+	if (conv_heur_data_area != NULL)
+		g_mem_chunk_destroy(conv_heur_data_area);
 
 	conversation_hashtable_exact =
 	    g_hash_table_new(conversation_hash_exact,
@@ -427,6 +441,9 @@ conversation_init(void)
 	conv_proto_data_area = g_mem_chunk_new("conv_proto_data_area",
 	    sizeof(conv_proto_data), 20 * sizeof(conv_proto_data), /* FIXME*/
 	    G_ALLOC_ONLY);
+	conv_heur_data_area = g_mem_chunk_new("conv_heur_data_area",
+	    sizeof(struct conv_heur_data),
+	    20 * sizeof(struct conv_heur_data), G_ALLOC_ONLY);
 
 	/*
 	 * Start the conversation indices over at 0.
@@ -464,6 +481,7 @@ conversation_new(address *addr1, address *addr2, port_type ptype,
 
 /* clear dissector handle */
 	conversation->dissector_handle = NULL;
+	conversation->heur_list = NULL;
 
 /* set the options and key pointer */
 	conversation->options = options;
@@ -907,6 +925,38 @@ conversation_set_dissector(conversation_t *conversation,
 	conversation->dissector_handle = handle;
 }
 
+void
+conversation_set_heur_dissector(conversation_t *conv,
+    heur_dissector_list_t list, void *heur_dissector)
+{
+	struct conv_heur_data *hd;
+
+	for (hd = conv->heur_list; hd != NULL; hd = hd->next) {
+		if (hd->list == list) {
+			hd->heur_dissector = heur_dissector;
+			return;
+		}
+	}
+	hd = g_mem_chunk_alloc(conv_heur_data_area);
+	hd->list = list;
+	hd->heur_dissector = heur_dissector;
+	hd->next = conv->heur_list;
+	conv->heur_list = hd;
+}
+
+void *
+conversation_get_heur_dissector(conversation_t *conv,
+    heur_dissector_list_t list)
+{
+	struct conv_heur_data *hd;
+
+	for (hd = conv->heur_list; hd != NULL; hd = hd->next) {
+		if (hd->list == list)
+			return hd->heur_dissector;
+	}
+	return NULL;
+}
+
 /*
  * Given two address/port pairs for a packet, search for a matching
  * conversation and, if found and it has a conversation dissector,
@@ -53,12 +53,16 @@ typedef struct conversation_key {
 	guint32	port2;
 } conversation_key;
 
+struct conv_heur_data;
+
 typedef struct conversation {
 	struct conversation *next;	/* pointer to next conversation on hash chain */
 	guint32	index;			/* unique ID for conversation */
 	GSList *data_list;		/* list of data associated with conversation */
 	dissector_handle_t dissector_handle;
 					/* handle for protocol dissector client associated with conversation */
+	struct conv_heur_data *heur_list;
+					/* heuristic dissectors that recognized it */
 	guint	options;		/* wildcard flags */
 	conversation_key *key_ptr;	/* pointer to the key for this conversation */
 } conversation_t;
@@ -78,6 +82,13 @@ extern void conversation_delete_proto_data(conversation_t *conv, int proto);
 
 extern void conversation_set_dissector(conversation_t *conversation,
     dissector_handle_t handle);
+
+/* Remember which dissector in a heuristic dissector list recognized
+   the conversation, and find out which one did. */
+extern void conversation_set_heur_dissector(conversation_t *conv,
+    heur_dissector_list_t list, void *heur_dissector);
+extern void *conversation_get_heur_dissector(conversation_t *conv,
+    heur_dissector_list_t list);
 extern gboolean
 try_conversation_dissector(address *addr_a, address *addr_b, port_type ptype,
     guint32 port_a, guint32 port_b, tvbuff_t *tvb, packet_info *pinfo,
@@ -28,14 +28,26 @@
 
 #include <epan/proto.h>
 
+/* A register of the dfvm, holding the values loaded into it.  The array
+ * of values is kept, and grown when necessary, from one run of the
+ * filter to the next, so that running a filter doesn't allocate memory
+ * once the arrays are big enough. */
+typedef struct {
+	fvalue_t	**values;
+	int		num_values;
+	int		size;		/* number of elements allocated */
+	gboolean	owns_values;	/* values were made by the VM */
+} dfvm_register_t;
+
 /* Passed back to user */
 struct _dfilter_t {
 	GPtrArray	*insns;
 	int		num_registers;
-	GList		**registers;
+	dfvm_register_t	*registers;
 	gboolean	*attempted_load;
     int         *interesting_fields;
     int         num_interesting_fields;
+	int		matched;	/* for a filter from dfilter_compile_list() */
 };
 
 typedef struct {
@@ -34,6 +34,7 @@
 #include "dfilter-int.h"
 #include "syntax-tree.h"
 #include "gencode.h"
+#include "optimize.h"
 #include "semcheck.h"
 #include "dfvm.h"
 #include <epan/epan_dissect.h>
@@ -224,6 +225,8 @@ free_insns(GPtrArray *insns)
 void
 dfilter_free(dfilter_t *df)
 {
+	int i;
+
 	if (df->insns) {
 		free_insns(df->insns);
 	}
@@ -232,6 +235,9 @@ dfilter_free(dfilter_t *df)
         g_free(df->interesting_fields);
     }
 
+	for (i = 0; i < df->num_registers; i++) {
+		g_free(df->registers[i].values);
+	}
 	g_free(df->registers);
 	g_free(df->attempted_load);
 	g_free(df);
@@ -280,16 +286,12 @@ dfwork_free(dfwork_t *dfw)
 }
 
 
-gboolean
-dfilter_compile(gchar *text, dfilter_t **dfp)
+/* Parse a filter string into dfw->st_root, check its semantics, and
+ * optimize it.  dfw->st_root is left NULL if the filter is empty. */
+static gboolean
+dfw_parse(dfwork_t *dfw, gchar *text)
 {
 	int		token;
-	dfilter_t	*dfilter;
-	dfwork_t	*dfw;
-
-	dfilter_error_msg = NULL;
-
-	dfw = dfwork_new();
 
 	df_scanner_text(text);
 
@@ -318,11 +320,61 @@ dfilter_compile(gchar *text, dfilter_t **dfp)
 		}
 	}
 
+	/* Reset flex */
+	df_scanner_cleanup();
+
 	/* One last check for syntax error (after EOF) */
 	if (dfw->syntax_error) {
-		goto FAILURE;
+		return FALSE;
 	}
 
+	if (dfw->st_root != NULL) {
+		/* Check semantics and do necessary type conversion*/
+		if (!dfw_semcheck(dfw)) {
+			return FALSE;
+		}
+
+		/* Reorder and simplify the tests */
+		dfw_optimize(dfw);
+	}
+	return TRUE;
+}
+
+/* Make a dfilter_t from the bytecode generated in "dfw". */
+static dfilter_t*
+dfilter_from_dfw(dfwork_t *dfw)
+{
+	dfilter_t	*dfilter;
+
+	/* Tuck away the bytecode in the dfilter_t */
+	dfilter = dfilter_new();
+	dfilter->insns = dfw->insns;
+	dfw->insns = NULL;
+	dfilter->interesting_fields = dfw_interesting_fields(dfw,
+	    &dfilter->num_interesting_fields);
+
+	/* Initialize run-time space */
+	dfilter->num_registers = dfw->next_register;
+	dfilter->registers = g_new0(dfvm_register_t,
+	    dfilter->num_registers);
+	dfilter->attempted_load = g_new0(gboolean, dfilter->num_registers);
+	dfilter->matched = -1;
+
+	return dfilter;
+}
+
+gboolean
+dfilter_compile(gchar *text, dfilter_t **dfp)
+{
+	dfwork_t	*dfw;
+
+	dfilter_error_msg = NULL;
+
+	dfw = dfwork_new();
+
+	if (!dfw_parse(dfw, text)) {
+		goto FAILURE;
+	}
 
 	/* Success, but was it an empty filter? If so, discard
 	 * it and set *dfp to NULL */
@@ -330,36 +382,14 @@ dfilter_compile(gchar *text, dfilter_t **dfp)
 		*dfp = NULL;
 	}
 	else {
-
-		/* Check semantics and do necessary type conversion*/
-		if (!dfw_semcheck(dfw)) {
-			goto FAILURE;
-		}
-
 		/* Create bytecode */
 		dfw_gencode(dfw);
-	
-		/* Tuck away the bytecode in the dfilter_t */
-		dfilter = dfilter_new();
-		dfilter->insns = dfw->insns;
-		dfw->insns = NULL;
-        dfilter->interesting_fields = dfw_interesting_fields(dfw,
-                &dfilter->num_interesting_fields);
-
-		/* Initialize run-time space */
-		dfilter->num_registers = dfw->next_register;
-		dfilter->registers = g_new0(GList*, dfilter->num_registers);
-		dfilter->attempted_load = g_new0(gboolean, dfilter->num_registers);
 
 		/* And give it to the user. */
-		*dfp = dfilter;
+		*dfp = dfilter_from_dfw(dfw);
 	}
 	/* SUCCESS */
 	dfwork_free(dfw);
-
-	/* Reset flex */
-	df_scanner_cleanup();
-
 	return TRUE;
 
 FAILURE:
@@ -368,13 +398,51 @@ FAILURE:
 	}
 	dfilter_fail("Unable to parse filter string \"%s\".", text);
 	*dfp = NULL;
-
-	/* Reset flex */
-	df_scanner_cleanup();
 	return FALSE;
 
 }
 
+gboolean
+dfilter_compile_list(gchar **texts, int num_texts, dfilter_t **dfp)
+{
+	dfwork_t	*dfw, *code_dfw;
+	int		i;
+
+	dfilter_error_msg = NULL;
+
+	/* All the filters are generated into one program, so that
+	 * a field that several of them test is only read once. */
+	code_dfw = dfwork_new();
+	dfw_gencode_start(code_dfw);
+
+	for (i = 0; i < num_texts; i++) {
+		dfw = dfwork_new();
+		if (!dfw_parse(dfw, texts[i])) {
+			dfwork_free(dfw);
+			dfwork_free(code_dfw);
+			dfilter_fail("Unable to parse filter string \"%s\".",
+			    texts[i]);
+			*dfp = NULL;
+			return FALSE;
+		}
+
+		/* An empty filter never matches. */
+		if (dfw->st_root != NULL) {
+			code_dfw->st_root = dfw->st_root;
+			dfw->st_root = NULL;
+			dfw_gencode_match(code_dfw, i);
+			stnode_free(code_dfw->st_root);
+			code_dfw->st_root = NULL;
+		}
+		dfwork_free(dfw);
+	}
+	dfw_gencode_finish(code_dfw);
+
+	*dfp = dfilter_from_dfw(code_dfw);
+	dfwork_free(code_dfw);
+	return TRUE;
+}
+
 
 gboolean
 dfilter_apply(dfilter_t *df, proto_tree *tree)
@@ -388,6 +456,47 @@ dfilter_apply_edt(dfilter_t *df, epan_dissect_t* edt)
 	return dfvm_apply(df, edt->tree);
 }
 
+int
+dfilter_apply_first_edt(dfilter_t *df, epan_dissect_t* edt)
+{
+	return dfvm_apply_first(df, edt->tree);
+}
+
+gboolean
+dfilter_apply_fields(dfilter_t *df, dfilter_field_values_func func,
+		gpointer user_data)
+{
+	return dfvm_apply_fields(df, func, user_data);
+}
+
+gboolean
+dfilter_check_fields(dfilter_t *df, dfilter_check_field_func func,
+		gpointer user_data)
+{
+	unsigned int	i;
+	dfvm_insn_t	*insn;
+
+	for (i = 0; i < df->insns->len; i++) {
+		insn = g_ptr_array_index(df->insns, i);
+		switch (insn->op) {
+			case CHECK_EXISTS:
+				if (!func(insn->arg1->value.numeric, FALSE,
+				    user_data))
+					return FALSE;
+				break;
+
+			case READ_TREE:
+				if (!func(insn->arg1->value.numeric, TRUE,
+				    user_data))
+					return FALSE;
+				break;
+
+			default:
+				break;
+		}
+	}
+	return TRUE;
+}
 
 void
 dfilter_prime_proto_tree(dfilter_t *df, proto_tree *tree)
@@ -58,6 +58,18 @@ dfilter_cleanup(void);
 gboolean
 dfilter_compile(gchar *text, dfilter_t **dfp);
 
+/* Compiles a list of strings to a single dfilter_t, for
+ * dfilter_apply_first_edt().  A field that more than one of the
+ * filters refers to is only read from the protocol tree once, however
+ * many of the filters are run.  Empty strings are allowed, and never
+ * match.
+ *
+ * Returns TRUE on success, FALSE on failure, as dfilter_compile()
+ * does, except that *dfp is never set to a NULL pointer on success.
+ */
+gboolean
+dfilter_compile_list(gchar **texts, int num_texts, dfilter_t **dfp);
+
 /* Frees all memory used by dfilter, and frees
  * the dfilter itself. */
 void
@@ -76,6 +88,36 @@ dfilter_apply_edt(dfilter_t *df, epan_dissect_t* edt);
 gboolean
 dfilter_apply(dfilter_t *df, proto_tree *tree);
 
+/* Apply a dfilter made by dfilter_compile_list(), returning the index
+ * of the first of its strings that matches, or -1 if none of them do. */
+int
+dfilter_apply_first_edt(dfilter_t *df, epan_dissect_t* edt);
+
+/* Fetches the values of a field for dfilter_apply_fields(). Returns
+ * the number of occurrences of the field, and, if the field has any,
+ * sets "*fvalues" to point to an array of that many fvalue_t pointers. */
+typedef int (*dfilter_field_values_func)(int field_id, fvalue_t ***fvalues,
+		gpointer user_data);
+
+/* Apply compiled dfilter to field values that come from somewhere other
+ * than a protocol tree, such as a table of values saved from an earlier
+ * dissection. */
+gboolean
+dfilter_apply_fields(dfilter_t *df, dfilter_field_values_func func,
+		gpointer user_data);
+
+/* Called by dfilter_check_fields() for each field or protocol that a
+ * dfilter refers to; "needs_values" is FALSE if the dfilter only checks
+ * whether the field is present. */
+typedef gboolean (*dfilter_check_field_func)(int field_id,
+		gboolean needs_values, gpointer user_data);
+
+/* Returns TRUE if "func" returns TRUE for every field or protocol
+ * the dfilter refers to. */
+gboolean
+dfilter_check_fields(dfilter_t *df, dfilter_check_field_func func,
+		gpointer user_data);
+
 /* Prime a proto_tree using the fields/protocols used in a dfilter. */
 void
 dfilter_prime_proto_tree(dfilter_t *df, proto_tree *tree);
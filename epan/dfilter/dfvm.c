@@ -25,6 +25,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "dfvm.h"
 
 dfvm_insn_t*
@@ -77,6 +79,9 @@ dfvm_value_free(dfvm_value_t *v)
 		case DRANGE:
 			drange_free(v->value.drange);
 			break;
+		case INTEGER_SET:
+			g_hash_table_destroy(v->value.integer_set);
+			break;
 		default:
 			/* nothing */
 			;
@@ -160,6 +165,29 @@ dfvm_dump(FILE *f, GPtrArray *insns)
 					id, arg1->value.numeric, arg2->value.numeric);
 				break;
 
+			case ANY_EQ_INTEGER:
+			case ANY_EQ_IPV4:
+			case ANY_EQ_ETHER:
+				fprintf(f, "%05d ANY_EQ\t\treg#%d == <%s>\n",
+					id, arg1->value.numeric,
+					fvalue_type_name(arg2->value.fvalue));
+				break;
+
+			case ANY_NE_INTEGER:
+			case ANY_NE_IPV4:
+			case ANY_NE_ETHER:
+				fprintf(f, "%05d ANY_NE\t\treg#%d != <%s>\n",
+					id, arg1->value.numeric,
+					fvalue_type_name(arg2->value.fvalue));
+				break;
+
+			case ANY_IN_INTEGER_SET:
+			case ANY_IN_IPV4_SET:
+				fprintf(f, "%05d ANY_IN\t\treg#%d in <%u values>\n",
+					id, arg1->value.numeric,
+					g_hash_table_size(arg2->value.integer_set));
+				break;
+
 			case NOT:
 				fprintf(f, "%05d NOT\n", id);
 				break;
@@ -168,6 +196,11 @@ dfvm_dump(FILE *f, GPtrArray *insns)
 				fprintf(f, "%05d RETURN\n", id);
 				break;
 
+			case MATCH:
+				fprintf(f, "%05d MATCH\t\t%d\n",
+						id, arg1->value.numeric);
+				break;
+
 			case IF_TRUE_GOTO:
 				fprintf(f, "%05d IF-TRUE-GOTO\t%d\n",
 						id, arg1->value.numeric);
@@ -185,19 +218,74 @@ dfvm_dump(FILE *f, GPtrArray *insns)
 	}
 }
 
+/* Where the VM gets the values of fields from: either a proto_tree,
+ * or a function that hands them to us. */
+typedef struct {
+	proto_tree			*tree;
+	dfilter_field_values_func	func;
+	gpointer			user_data;
+} field_source_t;
+
+/* Make sure a register has room for "num_values" values, and return
+ * the array for them. */
+static fvalue_t **
+register_values(dfilter_t *df, int reg, int num_values)
+{
+	dfvm_register_t	*r = &df->registers[reg];
+
+	if (num_values > r->size) {
+		if (r->size == 0)
+			r->size = 4;
+		while (r->size < num_values)
+			r->size *= 2;
+		r->values = g_realloc(r->values, r->size * sizeof (fvalue_t *));
+	}
+	return r->values;
+}
+
+/* Gets a field's values from the field source's function, rather than
+ * from a proto_tree, and loads them into a register. */
+static gboolean
+read_fields(dfilter_t *df, field_source_t *src, int field_id, int reg)
+{
+	fvalue_t	**fvs;
+	int		len;
+
+	len = src->func(field_id, &fvs, src->user_data);
+	if (len == 0) {
+		return FALSE;
+	}
+
+	memcpy(register_values(df, reg, len), fvs, len * sizeof (fvalue_t *));
+	df->registers[reg].num_values = len;
+	return TRUE;
+}
+
+static gboolean
+check_exists(field_source_t *src, int field_id)
+{
+	fvalue_t	**fvs;
+
+	if (src->tree) {
+		return proto_check_for_protocol_or_field(src->tree, field_id);
+	}
+	return src->func(field_id, &fvs, src->user_data) != 0;
+}
+
 /* Reads a field from the proto_tree and loads the fvalues into a register,
  * if that field has not already been read. */
 static gboolean
-read_tree(dfilter_t *df, proto_tree *tree, int field_id, int reg)
+read_tree(dfilter_t *df, field_source_t *src, int field_id, int reg)
 {
+	proto_tree	*tree = src->tree;
 	GPtrArray	*finfos;
 	field_info	*finfo;
 	int		i, len;
-	GList		*fvalues = NULL;
+	fvalue_t	**fvalues;
 
 	/* Already loaded in this run of the dfilter? */
 	if (df->attempted_load[reg]) {
-		if (df->registers[reg]) {
+		if (df->registers[reg].num_values != 0) {
 			return TRUE;
 		}
 		else {
@@ -207,6 +295,10 @@ read_tree(dfilter_t *df, proto_tree *tree, int field_id, int reg)
 
 	df->attempted_load[reg] = TRUE;
 
+	if (!tree) {
+		return read_fields(df, src, field_id, reg);
+	}
+
 	finfos = proto_get_finfo_ptr_array(tree, field_id);
 	if (!finfos) {
 		return FALSE;
@@ -216,13 +308,13 @@ read_tree(dfilter_t *df, proto_tree *tree, int field_id, int reg)
     }
 
 	len = finfos->len;
+	fvalues = register_values(df, reg, len);
 	for (i = 0; i < len; i++) {
 		finfo = g_ptr_array_index(finfos, i);
-		fvalues = g_list_prepend(fvalues, finfo->value);
+		fvalues[i] = finfo->value;
 	}
-	fvalues = g_list_reverse(fvalues);
 
-	df->registers[reg] = fvalues;
+	df->registers[reg].num_values = len;
 	return TRUE;
 }
 
@@ -230,7 +322,8 @@ read_tree(dfilter_t *df, proto_tree *tree, int field_id, int reg)
 static gboolean
 put_fvalue(dfilter_t *df, fvalue_t *fv, int reg)
 {
-	df->registers[reg] = g_list_append(NULL, fv);
+	register_values(df, reg, 1)[0] = fv;
+	df->registers[reg].num_values = 1;
 	return TRUE;
 }
 
@@ -239,69 +332,161 @@ typedef gboolean (*FvalueCmpFunc)(fvalue_t*, fvalue_t*);
 static gboolean
 any_test(dfilter_t *df, FvalueCmpFunc cmp, int reg1, int reg2)
 {
-	GList	*list_a, *list_b;
+	dfvm_register_t	*a = &df->registers[reg1];
+	dfvm_register_t	*b = &df->registers[reg2];
+	int		i, j;
 
-	list_a = df->registers[reg1];
-
-	while (list_a) {
-		list_b = df->registers[reg2];
-		while (list_b) {
-			if (cmp(list_a->data, list_b->data)) {
+	for (i = 0; i < a->num_values; i++) {
+		for (j = 0; j < b->num_values; j++) {
+			if (cmp(a->values[i], b->values[j])) {
 				return TRUE;
 			}
-			list_b = g_list_next(list_b);
 		}
-		list_a = g_list_next(list_a);
 	}
 	return FALSE;
 }
 
+/* The fast paths for comparing the values in a register with a
+ * constant of a type we can compare directly.  They must give the same
+ * answers as the field types' comparison functions. */
+static gboolean
+any_eq_integer(dfilter_t *df, int reg, fvalue_t *fv, gboolean eq)
+{
+	dfvm_register_t	*r = &df->registers[reg];
+	guint32		value = fv->value.integer;
+	int		i;
+
+	for (i = 0; i < r->num_values; i++) {
+		if ((r->values[i]->value.integer == value) == eq) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
 
-/* Free the list nodes w/o freeing the memory that each
- * list node points to. */
+static gboolean
+any_eq_ipv4(dfilter_t *df, int reg, fvalue_t *fv, gboolean eq)
+{
+	dfvm_register_t	*r = &df->registers[reg];
+	ipv4_addr	*b = &fv->value.ipv4;
+	ipv4_addr	*a;
+	guint32		nmask;
+	int		i;
+
+	for (i = 0; i < r->num_values; i++) {
+		/* Use the less restrictive of the two netmasks, as
+		 * "ipv4_addr_eq()" does. */
+		a = &r->values[i]->value.ipv4;
+		nmask = MIN(a->nmask, b->nmask);
+		if (((a->addr & nmask) == (b->addr & nmask)) == eq) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+any_eq_ether(dfilter_t *df, int reg, fvalue_t *fv, gboolean eq)
+{
+	dfvm_register_t	*r = &df->registers[reg];
+	GByteArray	*b = fv->value.bytes;
+	GByteArray	*a;
+	int		i;
+
+	for (i = 0; i < r->num_values; i++) {
+		a = r->values[i]->value.bytes;
+		if ((a->len == b->len &&
+		    memcmp(a->data, b->data, b->len) == 0) == eq) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* Look up the values in a register in a set of integers, or of IPv4
+ * addresses.  Fields' IPv4 addresses always have a 32-bit netmask,
+ * and the optimizer only puts constants with a 32-bit netmask into a
+ * set, so the addresses can be compared directly. */
+static gboolean
+any_in_integer_set(dfilter_t *df, int reg, GHashTable *set)
+{
+	dfvm_register_t	*r = &df->registers[reg];
+	int		i;
+
+	for (i = 0; i < r->num_values; i++) {
+		if (g_hash_table_lookup(set,
+		    GUINT_TO_POINTER(r->values[i]->value.integer))) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+any_in_ipv4_set(dfilter_t *df, int reg, GHashTable *set)
+{
+	dfvm_register_t	*r = &df->registers[reg];
+	int		i;
+
+	for (i = 0; i < r->num_values; i++) {
+		if (g_hash_table_lookup(set,
+		    GUINT_TO_POINTER(r->values[i]->value.ipv4.addr))) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
+/* Forget the values in the registers, freeing the ones that the VM
+ * made; the registers' arrays are kept for the next run. */
 static void
 free_register_overhead(dfilter_t* df)
 {
-	int i;
+	dfvm_register_t	*r;
+	int		i, j;
 
 	for (i = 0; i < df->num_registers; i++) {
-		if (df->registers[i]) {
-			g_list_free(df->registers[i]);
+		r = &df->registers[i];
+		if (r->owns_values) {
+			for (j = 0; j < r->num_values; j++) {
+				fvalue_free(r->values[j]);
+			}
+			r->owns_values = FALSE;
 		}
+		r->num_values = 0;
 	}
 }
 
-/* Takes the list of fvalue_t's in a register, uses fvalue_slice()
- * to make a new list of fvalue_t's (which are ranges, or byte-slices),
- * and puts the new list into a new register. */
+/* Takes the fvalue_t's in a register, uses fvalue_slice()
+ * to make new fvalue_t's (which are ranges, or byte-slices),
+ * and puts them into a new register. */
 static void
 mk_range(dfilter_t *df, int from_reg, int to_reg, drange *drange)
 {
-	GList		*from_list, *to_list;
-	fvalue_t	*old_fv, *new_fv;
-
-	to_list = NULL;
-	from_list = df->registers[from_reg];
-
-	while (from_list) {
-		old_fv = from_list->data;
-		new_fv = fvalue_slice(old_fv, drange);
+	dfvm_register_t	*from = &df->registers[from_reg];
+	fvalue_t	**to_values;
+	fvalue_t	*new_fv;
+	int		i;
+
+	to_values = register_values(df, to_reg, from->num_values);
+	for (i = 0; i < from->num_values; i++) {
+		new_fv = fvalue_slice(from->values[i], drange);
 		/* Assert here because semcheck.c should have
 		 * already caught the cases in which a slice
 		 * cannot be made. */
 		g_assert(new_fv);
-		to_list = g_list_append(to_list, new_fv);
-
-		from_list = g_list_next(from_list);
+		to_values[i] = new_fv;
 	}
 
-	df->registers[to_reg] = to_list;
+	df->registers[to_reg].num_values = from->num_values;
+	df->registers[to_reg].owns_values = TRUE;
 }
 
 
 
-gboolean
-dfvm_apply(dfilter_t *df, proto_tree *tree)
+static gboolean
+dfvm_run(dfilter_t *df, field_source_t *src)
 {
 	int		i, id, length;
 	gboolean	accum = TRUE;
@@ -310,12 +495,10 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 	dfvm_value_t	*arg2;
 	dfvm_value_t	*arg3;
 
-	g_assert(tree);
-
 
 	/* Clear registers */
 	for (i = 0; i < df->num_registers; i++) {
-		df->registers[i] = NULL;
+		df->registers[i].num_values = 0;
 		df->attempted_load[i] = FALSE;
 	}
 
@@ -330,12 +513,11 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 
 		switch (insn->op) {
 			case CHECK_EXISTS:
-				accum = proto_check_for_protocol_or_field(tree,
-						arg1->value.numeric);
+				accum = check_exists(src, arg1->value.numeric);
 				break;
 
 			case READ_TREE:
-				accum = read_tree(df, tree,
+				accum = read_tree(df, src,
 						arg1->value.numeric, arg2->value.numeric);
 				break;
 
@@ -381,6 +563,46 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 						arg1->value.numeric, arg2->value.numeric);
 				break;
 
+			case ANY_EQ_INTEGER:
+				accum = any_eq_integer(df, arg1->value.numeric,
+						arg2->value.fvalue, TRUE);
+				break;
+
+			case ANY_NE_INTEGER:
+				accum = any_eq_integer(df, arg1->value.numeric,
+						arg2->value.fvalue, FALSE);
+				break;
+
+			case ANY_EQ_IPV4:
+				accum = any_eq_ipv4(df, arg1->value.numeric,
+						arg2->value.fvalue, TRUE);
+				break;
+
+			case ANY_NE_IPV4:
+				accum = any_eq_ipv4(df, arg1->value.numeric,
+						arg2->value.fvalue, FALSE);
+				break;
+
+			case ANY_EQ_ETHER:
+				accum = any_eq_ether(df, arg1->value.numeric,
+						arg2->value.fvalue, TRUE);
+				break;
+
+			case ANY_NE_ETHER:
+				accum = any_eq_ether(df, arg1->value.numeric,
+						arg2->value.fvalue, FALSE);
+				break;
+
+			case ANY_IN_INTEGER_SET:
+				accum = any_in_integer_set(df, arg1->value.numeric,
+						arg2->value.integer_set);
+				break;
+
+			case ANY_IN_IPV4_SET:
+				accum = any_in_ipv4_set(df, arg1->value.numeric,
+						arg2->value.integer_set);
+				break;
+
 			case NOT:
 				accum = !accum;
 				break;
@@ -389,6 +611,14 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				free_register_overhead(df);
 				return accum;
 
+			case MATCH:
+				if (accum) {
+					df->matched = arg1->value.numeric;
+					free_register_overhead(df);
+					return TRUE;
+				}
+				break;
+
 			case IF_TRUE_GOTO:
 				if (accum) {
 					id = arg1->value.numeric;
@@ -413,3 +643,45 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 	g_assert_not_reached();
 	return FALSE; /* to appease the compiler */
 }
+
+gboolean
+dfvm_apply(dfilter_t *df, proto_tree *tree)
+{
+	field_source_t	src;
+
+	g_assert(tree);
+
+	src.tree = tree;
+	src.func = NULL;
+	src.user_data = NULL;
+	return dfvm_run(df, &src);
+}
+
+int
+dfvm_apply_first(dfilter_t *df, proto_tree *tree)
+{
+	field_source_t	src;
+
+	g_assert(tree);
+
+	src.tree = tree;
+	src.func = NULL;
+	src.user_data = NULL;
+	df->matched = -1;
+	dfvm_run(df, &src);
+	return df->matched;
+}
+
+gboolean
+dfvm_apply_fields(dfilter_t *df, dfilter_field_values_func func,
+		gpointer user_data)
+{
+	field_source_t	src;
+
+	g_assert(func);
+
+	src.tree = NULL;
+	src.func = func;
+	src.user_data = user_data;
+	return dfvm_run(df, &src);
+}
@@ -36,7 +36,8 @@ typedef enum {
 	INSN_NUMBER,
 	REGISTER,
 	INTEGER,
-	DRANGE
+	DRANGE,
+	INTEGER_SET
 } dfvm_value_type_t;
 
 typedef struct {
@@ -46,6 +47,7 @@ typedef struct {
 		fvalue_t	*fvalue;
 		guint32		numeric;
 		drange		*drange;
+		GHashTable	*integer_set;
 	} value;
 
 } dfvm_value_t;
@@ -66,7 +68,25 @@ typedef enum {
 	ANY_GE,
 	ANY_LT,
 	ANY_LE,
-	MK_RANGE
+	MK_RANGE,
+
+	/* Compare the values in a register with a constant, without
+	 * going through the field type's comparison functions. */
+	ANY_EQ_INTEGER,
+	ANY_NE_INTEGER,
+	ANY_EQ_IPV4,
+	ANY_NE_IPV4,
+	ANY_EQ_ETHER,
+	ANY_NE_ETHER,
+
+	/* Check whether any of the values in a register is in a set
+	 * of constants. */
+	ANY_IN_INTEGER_SET,
+	ANY_IN_IPV4_SET,
+
+	/* If the last test succeeded, return, remembering which of the
+	 * filters in a program made by dfilter_compile_list() matched. */
+	MATCH
 	
 } dfvm_opcode_t;
 
@@ -98,5 +118,12 @@ dfvm_dump(FILE *f, GPtrArray *insns);
 gboolean
 dfvm_apply(dfilter_t *df, proto_tree *tree);
 
+int
+dfvm_apply_first(dfilter_t *df, proto_tree *tree);
+
+gboolean
+dfvm_apply_fields(dfilter_t *df, dfilter_field_values_func func,
+		gpointer user_data);
+
 
 #endif
@@ -28,6 +28,7 @@
 #include "dfvm.h"
 #include "syntax-tree.h"
 #include "sttype-range.h"
+#include "sttype-set.h"
 #include "sttype-test.h"
 #include "ftypes/ftypes.h"
 #include <epan/gdebug.h>
@@ -144,6 +145,111 @@ dfw_append_mk_range(dfwork_t *dfw, stnode_t *node)
 }
 
 
+/* If "op" compares a field of type "ftype" with a constant, and
+ * the VM has a fast path for that comparison, return the opcode
+ * for the fast path; otherwise, return "op". */
+static dfvm_opcode_t
+fast_relation_op(dfvm_opcode_t op, ftenum_t ftype)
+{
+	if (op != ANY_EQ && op != ANY_NE)
+		return op;
+
+	switch (ftype) {
+		case FT_UINT8:
+		case FT_UINT16:
+		case FT_UINT24:
+		case FT_UINT32:
+		case FT_INT8:
+		case FT_INT16:
+		case FT_INT24:
+		case FT_INT32:
+		case FT_IPXNET:
+			return op == ANY_EQ ? ANY_EQ_INTEGER : ANY_NE_INTEGER;
+
+		case FT_IPv4:
+			return op == ANY_EQ ? ANY_EQ_IPV4 : ANY_NE_IPV4;
+
+		case FT_ETHER:
+			return op == ANY_EQ ? ANY_EQ_ETHER : ANY_NE_ETHER;
+
+		default:
+			return op;
+	}
+}
+
+/* Generate code to compare a field with a constant, using one of the
+ * VM's fast paths, and return TRUE; if there's no fast path for the
+ * comparison, return FALSE. */
+static gboolean
+gen_fast_relation(dfwork_t *dfw, dfvm_opcode_t op, stnode_t *st_field,
+		stnode_t *st_fvalue)
+{
+	header_field_info	*hfinfo;
+	dfvm_opcode_t	fast_op;
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1, *val2, *jmp;
+	int		reg;
+
+	hfinfo = stnode_data(st_field);
+	fast_op = fast_relation_op(op, hfinfo->type);
+	if (fast_op == op)
+		return FALSE;
+
+	reg = dfw_append_read_tree(dfw, hfinfo->id);
+
+	insn = dfvm_insn_new(IF_FALSE_GOTO);
+	jmp = dfvm_value_new(INSN_NUMBER);
+	insn->arg1 = jmp;
+	dfw_append_insn(dfw, insn);
+
+	insn = dfvm_insn_new(fast_op);
+	val1 = dfvm_value_new(REGISTER);
+	val1->value.numeric = reg;
+	val2 = dfvm_value_new(FVALUE);
+	val2->value.fvalue = stnode_data(st_fvalue);
+	insn->arg1 = val1;
+	insn->arg2 = val2;
+	dfw_append_insn(dfw, insn);
+
+	jmp->value.numeric = dfw->next_insn_id;
+	return TRUE;
+}
+
+/* Generate code to check whether a field has any of the values in
+ * a set made by the optimizer. */
+static void
+gen_set_membership(dfwork_t *dfw, stnode_t *st_field, stnode_t *st_set)
+{
+	header_field_info	*hfinfo;
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1, *val2, *jmp;
+	int		reg;
+
+	hfinfo = stnode_data(st_field);
+	reg = dfw_append_read_tree(dfw, hfinfo->id);
+
+	insn = dfvm_insn_new(IF_FALSE_GOTO);
+	jmp = dfvm_value_new(INSN_NUMBER);
+	insn->arg1 = jmp;
+	dfw_append_insn(dfw, insn);
+
+	if (hfinfo->type == FT_IPv4)
+		insn = dfvm_insn_new(ANY_IN_IPV4_SET);
+	else
+		insn = dfvm_insn_new(ANY_IN_INTEGER_SET);
+	val1 = dfvm_value_new(REGISTER);
+	val1->value.numeric = reg;
+	val2 = dfvm_value_new(INTEGER_SET);
+	val2->value.integer_set = sttype_set_values(st_set);
+	insn->arg1 = val1;
+	insn->arg2 = val2;
+	dfw_append_insn(dfw, insn);
+
+	sttype_set_remove_values(st_set);
+
+	jmp->value.numeric = dfw->next_insn_id;
+}
+
 static void
 gen_relation(dfwork_t *dfw, dfvm_opcode_t op, stnode_t *st_arg1, stnode_t *st_arg2)
 {
@@ -157,6 +263,16 @@ gen_relation(dfwork_t *dfw, dfvm_opcode_t op, stnode_t *st_arg1, stnode_t *st_ar
 	type1 = stnode_type_id(st_arg1);
 	type2 = stnode_type_id(st_arg2);
 
+	/* Equality is symmetric, so the constant can be on either side. */
+	if (type1 == STTYPE_FIELD && type2 == STTYPE_FVALUE) {
+		if (gen_fast_relation(dfw, op, st_arg1, st_arg2))
+			return;
+	}
+	else if (type1 == STTYPE_FVALUE && type2 == STTYPE_FIELD) {
+		if (gen_fast_relation(dfw, op, st_arg2, st_arg1))
+			return;
+	}
+
 	if (type1 == STTYPE_FIELD) {
 		hfinfo = stnode_data(st_arg1);
 		reg1 = dfw_append_read_tree(dfw, hfinfo->id);
@@ -295,6 +411,10 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 		case TEST_OP_LE:
 			gen_relation(dfw, ANY_LE, st_arg1, st_arg2);
 			break;
+
+		case TEST_OP_IN:
+			gen_set_membership(dfw, st_arg1, st_arg2);
+			break;
 	}
 }
 
@@ -317,11 +437,38 @@ gencode(dfwork_t *dfw, stnode_t *st_node)
 
 void
 dfw_gencode(dfwork_t *dfw)
+{
+	dfw_gencode_start(dfw);
+	gencode(dfw, dfw->st_root);
+	dfw_gencode_finish(dfw);
+}
+
+void
+dfw_gencode_start(dfwork_t *dfw)
 {
 	dfw->insns = g_ptr_array_new();
 	dfw->loaded_fields = g_hash_table_new(g_direct_hash, g_direct_equal);
 	dfw->interesting_fields = g_hash_table_new(g_direct_hash, g_direct_equal);
+}
+
+void
+dfw_gencode_match(dfwork_t *dfw, int match)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1;
+
 	gencode(dfw, dfw->st_root);
+
+	insn = dfvm_insn_new(MATCH);
+	val1 = dfvm_value_new(INTEGER);
+	val1->value.numeric = match;
+	insn->arg1 = val1;
+	dfw_append_insn(dfw, insn);
+}
+
+void
+dfw_gencode_finish(dfwork_t *dfw)
+{
 	dfw_append_insn(dfw, dfvm_insn_new(RETURN));
 }
 
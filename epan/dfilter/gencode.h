@@ -4,6 +4,20 @@
 void
 dfw_gencode(dfwork_t *dfw);
 
+/* Generate the code for several syntax trees, one after another, into
+ * one program: call dfw_gencode_start(), then, for each tree, set
+ * dfw->st_root and call dfw_gencode_match(), then call
+ * dfw_gencode_finish().  The program returns as soon as one of
+ * the trees matches, leaving its "match" number in the dfilter_t. */
+void
+dfw_gencode_start(dfwork_t *dfw);
+
+void
+dfw_gencode_match(dfwork_t *dfw, int match);
+
+void
+dfw_gencode_finish(dfwork_t *dfw);
+
 int*
 dfw_interesting_fields(dfwork_t *dfw, int *caller_num_fields);
 
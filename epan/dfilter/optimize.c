@@ -0,0 +1,392 @@
+/*
+ * $Id$
+ *
+ * Ethereal - Network traffic analyzer
+ * By Gerald Combs <gerald@ethereal.com>
+ * Copyright 2001 Gerald Combs
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*
+ * The optimizer runs between the semantic check and code generation.
+ * It does two things to the syntax tree:
+ *
+ *	A chain of "||" tests that compares the same integer or IPv4
+ *	field with several constants, such as
+ *	"ip.src == 10.0.0.1 || ip.src == 10.0.0.2 || ip.src == 10.0.0.3",
+ *	becomes a single TEST_OP_IN test, which the VM does with one
+ *	hash table lookup per value of the field.
+ *
+ *	The operands of chains of "&&" and "||" tests are sorted by
+ *	their estimated cost, so that the cheap tests run first and can
+ *	short-circuit the expensive ones.  The tests have no side
+ *	effects, so that doesn't change the result.
+ *
+ * Fields that are tested more than once are only read from the tree
+ * once anyway, as gencode.c gives each field one register and the VM
+ * remembers which registers it has loaded.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "dfilter-int.h"
+#include "syntax-tree.h"
+#include "sttype-set.h"
+#include "sttype-test.h"
+#include "optimize.h"
+#include "ftypes/ftypes.h"
+
+/* Don't bother making a set out of fewer tests than this. */
+#define MIN_SET_SIZE	3
+
+/* Estimated costs of the tests. */
+#define COST_EXISTS		1	/* look up the field in the tree */
+#define COST_FAST_RELATION	2	/* load the field, compare directly */
+#define COST_RELATION		4	/* load the field, compare via ftype */
+#define COST_TWO_FIELDS		6	/* load two fields */
+#define COST_RANGE		8	/* load the field, make slices */
+
+static stnode_t*
+optimize(stnode_t *st_node);
+
+/* Can the VM compare values of this type with a constant without
+ * calling the type's comparison functions?  Keep this in sync with
+ * "fast_relation_op()" in gencode.c. */
+static gboolean
+is_fast_type(ftenum_t ftype)
+{
+	switch (ftype) {
+		case FT_UINT8:
+		case FT_UINT16:
+		case FT_UINT24:
+		case FT_UINT32:
+		case FT_INT8:
+		case FT_INT16:
+		case FT_INT24:
+		case FT_INT32:
+		case FT_IPXNET:
+		case FT_IPv4:
+		case FT_ETHER:
+			return TRUE;
+
+		default:
+			return FALSE;
+	}
+}
+
+static int
+relation_cost(test_op_t op, stnode_t *st_arg1, stnode_t *st_arg2)
+{
+	sttype_id_t		type1, type2;
+	header_field_info	*hfinfo;
+
+	type1 = stnode_type_id(st_arg1);
+	type2 = stnode_type_id(st_arg2);
+
+	if (type1 == STTYPE_RANGE || type2 == STTYPE_RANGE)
+		return COST_RANGE;
+
+	if (type1 == STTYPE_FIELD && type2 == STTYPE_FIELD)
+		return COST_TWO_FIELDS;
+
+	if (op == TEST_OP_EQ || op == TEST_OP_NE) {
+		hfinfo = stnode_data(type1 == STTYPE_FIELD ? st_arg1 : st_arg2);
+		if (is_fast_type(hfinfo->type))
+			return COST_FAST_RELATION;
+	}
+	return COST_RELATION;
+}
+
+/* Estimate how expensive a test is to run. */
+static int
+cost(stnode_t *st_node)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+
+	switch (st_op) {
+		case TEST_OP_UNINITIALIZED:
+			g_assert_not_reached();
+			break;
+
+		case TEST_OP_EXISTS:
+			return COST_EXISTS;
+
+		case TEST_OP_NOT:
+			return cost(st_arg1);
+
+		case TEST_OP_AND:
+		case TEST_OP_OR:
+			return cost(st_arg1) + cost(st_arg2);
+
+		case TEST_OP_IN:
+			return COST_FAST_RELATION;
+
+		case TEST_OP_EQ:
+		case TEST_OP_NE:
+		case TEST_OP_GT:
+		case TEST_OP_GE:
+		case TEST_OP_LT:
+		case TEST_OP_LE:
+			return relation_cost(st_op, st_arg1, st_arg2);
+	}
+	g_assert_not_reached();
+	return 0;
+}
+
+/* A test and its cost, for sorting. */
+typedef struct {
+	stnode_t	*st_node;
+	int		cost;
+} operand_t;
+
+static gint
+compare_operand_costs(gconstpointer a, gconstpointer b)
+{
+	const operand_t	*op_a = a;
+	const operand_t	*op_b = b;
+
+	return op_a->cost - op_b->cost;
+}
+
+/* Take apart a chain of tests joined by "op", adding the tests to
+ * "operands" and freeing the nodes that joined them. */
+static GSList*
+flatten(stnode_t *st_node, test_op_t op, GSList *operands)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+	if (st_op != op)
+		return g_slist_append(operands, st_node);
+
+	operands = flatten(st_arg1, op, operands);
+	operands = flatten(st_arg2, op, operands);
+	sttype_test_set2_args(st_node, NULL, NULL);
+	stnode_free(st_node);
+	return operands;
+}
+
+/* If a test compares an integer or IPv4 field with a constant that
+ * can go into a set, return the field's node, and the constant's value
+ * in "*p_value"; otherwise, return NULL. */
+static stnode_t*
+set_member(stnode_t *st_node, guint32 *p_value)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2, *st_field, *st_fvalue;
+	header_field_info	*hfinfo;
+	fvalue_t	*fv;
+
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+	if (st_op != TEST_OP_EQ)
+		return NULL;
+
+	if (stnode_type_id(st_arg1) == STTYPE_FIELD &&
+	    stnode_type_id(st_arg2) == STTYPE_FVALUE) {
+		st_field = st_arg1;
+		st_fvalue = st_arg2;
+	}
+	else if (stnode_type_id(st_arg1) == STTYPE_FVALUE &&
+	    stnode_type_id(st_arg2) == STTYPE_FIELD) {
+		st_field = st_arg2;
+		st_fvalue = st_arg1;
+	}
+	else {
+		return NULL;
+	}
+
+	hfinfo = stnode_data(st_field);
+	fv = stnode_data(st_fvalue);
+
+	switch (hfinfo->type) {
+		case FT_UINT8:
+		case FT_UINT16:
+		case FT_UINT24:
+		case FT_UINT32:
+		case FT_INT8:
+		case FT_INT16:
+		case FT_INT24:
+		case FT_INT32:
+		case FT_IPXNET:
+			*p_value = fv->value.integer;
+			return st_field;
+
+		case FT_IPv4:
+			/* A constant with a netmask matches a range of
+			 * addresses, so it can't go into the set. */
+			if (fv->value.ipv4.nmask != 0xffffffff)
+				return NULL;
+			*p_value = fv->value.ipv4.addr;
+			return st_field;
+
+		default:
+			return NULL;
+	}
+}
+
+/* Free a "field == constant" test whose constant has been put into a
+ * set.  The FVALUE node doesn't free its fvalue_t, as that's normally
+ * handed to the generated code, so we have to. */
+static void
+free_set_member(stnode_t *st_node)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+	if (stnode_type_id(st_arg1) == STTYPE_FVALUE)
+		fvalue_free(stnode_data(st_arg1));
+	if (stnode_type_id(st_arg2) == STTYPE_FVALUE)
+		fvalue_free(stnode_data(st_arg2));
+	stnode_free(st_node);
+}
+
+/* Replace the tests in a list of "||" operands that compare the same
+ * field with enough constants by a single TEST_OP_IN test. */
+static GSList*
+merge_sets(GSList *operands)
+{
+	GSList		*l, *m, *next;
+	stnode_t	*st_field, *st_other, *st_set, *st_in;
+	header_field_info	*hfinfo;
+	guint32		value;
+	int		count;
+
+	for (l = operands; l != NULL; l = l->next) {
+		st_field = set_member(l->data, &value);
+		if (st_field == NULL)
+			continue;
+		hfinfo = stnode_data(st_field);
+
+		count = 1;
+		for (m = l->next; m != NULL; m = m->next) {
+			st_other = set_member(m->data, &value);
+			if (st_other != NULL && stnode_data(st_other) == hfinfo)
+				count++;
+		}
+		if (count < MIN_SET_SIZE)
+			continue;
+
+		/* Move the constants into a set, and free the tests,
+		 * except for the field node of the first one. */
+		st_set = stnode_new(STTYPE_SET, NULL);
+		st_in = stnode_new(STTYPE_TEST, NULL);
+		sttype_test_set2(st_in, TEST_OP_IN,
+		    stnode_new(STTYPE_FIELD, hfinfo), st_set);
+
+		set_member(l->data, &value);
+		sttype_set_add(st_set, value);
+		free_set_member(l->data);
+		l->data = st_in;
+
+		for (m = l->next; m != NULL; m = next) {
+			next = m->next;
+			st_other = set_member(m->data, &value);
+			if (st_other != NULL && stnode_data(st_other) == hfinfo) {
+				sttype_set_add(st_set, value);
+				free_set_member(m->data);
+				operands = g_slist_remove_link(operands, m);
+				g_slist_free_1(m);
+			}
+		}
+	}
+	return operands;
+}
+
+/* Optimize a chain of "&&" or "||" tests, returning the new chain. */
+static stnode_t*
+optimize_chain(stnode_t *st_node, test_op_t op)
+{
+	GSList		*operands, *costs, *l;
+	operand_t	*operand;
+	stnode_t	*st_chain, *st_test;
+
+	operands = flatten(st_node, op, NULL);
+	for (l = operands; l != NULL; l = l->next) {
+		l->data = optimize(l->data);
+	}
+
+	if (op == TEST_OP_OR) {
+		operands = merge_sets(operands);
+	}
+
+	/* g_slist_sort() is a merge sort, so tests with the same cost
+	 * stay in the order in which they were written. */
+	costs = NULL;
+	for (l = operands; l != NULL; l = l->next) {
+		operand = g_new(operand_t, 1);
+		operand->st_node = l->data;
+		operand->cost = cost(l->data);
+		costs = g_slist_prepend(costs, operand);
+	}
+	costs = g_slist_reverse(costs);
+	costs = g_slist_sort(costs, compare_operand_costs);
+	g_slist_free(operands);
+
+	/* Rebuild the chain, left-associative as the parser makes it. */
+	st_chain = NULL;
+	for (l = costs; l != NULL; l = l->next) {
+		operand = l->data;
+		if (st_chain == NULL) {
+			st_chain = operand->st_node;
+		}
+		else {
+			st_test = stnode_new(STTYPE_TEST, NULL);
+			sttype_test_set2(st_test, op, st_chain, operand->st_node);
+			st_chain = st_test;
+		}
+		g_free(operand);
+	}
+	g_slist_free(costs);
+
+	return st_chain;
+}
+
+/* Optimize a test, returning the test that replaces it. */
+static stnode_t*
+optimize(stnode_t *st_node)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	g_assert(stnode_type_id(st_node) == STTYPE_TEST);
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+
+	switch (st_op) {
+		case TEST_OP_NOT:
+			sttype_test_set2_args(st_node, optimize(st_arg1), NULL);
+			return st_node;
+
+		case TEST_OP_AND:
+		case TEST_OP_OR:
+			return optimize_chain(st_node, st_op);
+
+		default:
+			return st_node;
+	}
+}
+
+void
+dfw_optimize(dfwork_t *dfw)
+{
+	dfw->st_root = optimize(dfw->st_root);
+}
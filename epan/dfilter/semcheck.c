@@ -470,6 +470,7 @@ check_relation(dfwork_t *dfw, FtypeCanFunc can_func, stnode_t *st_node,
 
 		case STTYPE_UNINITIALIZED:
 		case STTYPE_TEST:
+		case STTYPE_SET:
 		case STTYPE_INTEGER:
 		case STTYPE_FVALUE:
 		case STTYPE_NUM_TYPES:
@@ -490,6 +491,11 @@ check_test(dfwork_t *dfw, stnode_t *st_node)
 			g_assert_not_reached();
 			break;
 
+		case TEST_OP_IN:
+			/* Only made by the optimizer, after semantic checks */
+			g_assert_not_reached();
+			break;
+
 		case TEST_OP_EXISTS:
 			/* nothing */
 			break;
@@ -0,0 +1,104 @@
+/*
+ * $Id$
+ *
+ * Ethereal - Network traffic analyzer
+ * By Gerald Combs <gerald@ethereal.com>
+ * Copyright 2001 Gerald Combs
+ *
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+
+#include "sttype-set.h"
+
+typedef struct {
+	guint32		magic;
+	GHashTable	*values;
+} set_t;
+
+#define SET_MAGIC	0x5e7c0de5
+
+static gpointer
+set_new(gpointer junk)
+{
+	set_t		*set;
+
+	g_assert(junk == NULL);
+
+	set = g_new(set_t, 1);
+
+	set->magic = SET_MAGIC;
+	set->values = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	return (gpointer) set;
+}
+
+static void
+set_free(gpointer value)
+{
+	set_t	*set = value;
+	assert_magic(set, SET_MAGIC);
+
+	if (set->values)
+		g_hash_table_destroy(set->values);
+
+	g_free(set);
+}
+
+/* The values are the keys of the hash table; since a value can be 0,
+ * which is also what a failed lookup returns, every key maps to TRUE. */
+void
+sttype_set_add(stnode_t *node, guint32 value)
+{
+	set_t		*set;
+
+	set = stnode_data(node);
+	assert_magic(set, SET_MAGIC);
+
+	g_hash_table_insert(set->values, GUINT_TO_POINTER(value),
+	    GUINT_TO_POINTER(TRUE));
+}
+
+void
+sttype_set_remove_values(stnode_t *node)
+{
+	set_t		*set;
+
+	set = stnode_data(node);
+	assert_magic(set, SET_MAGIC);
+
+	set->values = NULL;
+}
+
+STTYPE_ACCESSOR(GHashTable*, set, values, SET_MAGIC)
+
+void
+sttype_register_set(void)
+{
+	static sttype_t set_type = {
+		STTYPE_SET,
+		"SET",
+		set_new,
+		set_free,
+	};
+
+	sttype_register(&set_type);
+}
@@ -0,0 +1,42 @@
+/*
+ * $Id$
+ *
+ * Ethereal - Network traffic analyzer
+ * By Gerald Combs <gerald@ethereal.com>
+ * Copyright 2001 Gerald Combs
+ *
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef STTYPE_SET_H
+#define STTYPE_SET_H
+
+#include "syntax-tree.h"
+
+/* A set of 32-bit values (integers, or IPv4 addresses), made by
+ * the optimizer from a chain of "field == constant" tests. */
+
+STTYPE_ACCESSOR_PROTOTYPE(GHashTable*, set, values)
+
+void
+sttype_set_add(stnode_t *node, guint32 value);
+
+/* Clear the 'values' variable to remove responsibility for
+ * freeing it. */
+void
+sttype_set_remove_values(stnode_t *node);
+
+#endif
@@ -90,6 +90,8 @@ num_operands(test_op_t op)
 			return 2;
 		case TEST_OP_LE:
 			return 2;
+		case TEST_OP_IN:
+			return 2;
 	}
 	g_assert_not_reached();
 	return -1;
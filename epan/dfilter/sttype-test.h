@@ -35,7 +35,8 @@ typedef enum {
 	TEST_OP_GT,
 	TEST_OP_GE,
 	TEST_OP_LT,
-	TEST_OP_LE
+	TEST_OP_LE,
+	TEST_OP_IN	/* made by the optimizer; FIELD in SET */
 } test_op_t;
 
 void
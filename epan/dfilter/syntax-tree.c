@@ -34,6 +34,7 @@ static sttype_t* type_list[STTYPE_NUM_TYPES];
 void sttype_register_integer(void);
 void sttype_register_pointer(void);
 void sttype_register_range(void);
+void sttype_register_set(void);
 void sttype_register_string(void);
 void sttype_register_test(void);
 
@@ -47,6 +48,7 @@ sttype_init(void)
 	sttype_register_integer();
 	sttype_register_pointer();
 	sttype_register_range();
+	sttype_register_set();
 	sttype_register_string();
 	sttype_register_test();
 }
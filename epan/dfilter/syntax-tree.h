@@ -35,6 +35,7 @@ typedef enum {
 	STTYPE_FVALUE,
 	STTYPE_INTEGER,
 	STTYPE_RANGE,
+	STTYPE_SET,
 	STTYPE_NUM_TYPES
 } sttype_id_t;
 
@@ -113,6 +113,10 @@ epan_dissect_free(epan_dissect_t* edt)
 	 * would have incremented the usage count on that tvbuff_t*) */
 	tvb_free_chain(edt->tvb);
 
+	/* Let protocols know that data they handed to this dissection
+	 * is no longer in use by it. */
+	dissect_free_all_protocols(&edt->pi);
+
 	if (edt->tree) {
 		proto_tree_free(edt->tree);
 	}
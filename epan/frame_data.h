@@ -29,10 +29,12 @@
 
 /* XXX - some of this stuff is used only while a packet is being dissected;
    should we keep that stuff in the "packet_info" structure, instead, to
-   save memory? */
+   save memory?
+
+   Frames aren't chained together; the capture file code keeps them
+   in arrays, indexed by frame number, so there's no per-frame cost
+   for list pointers. */
 typedef struct _frame_data {
-  struct _frame_data *next; /* Next element in list */
-  struct _frame_data *prev; /* Previous element in list */
   GSList      *pfd;         /* Per frame proto data */
   GSList      *data_src;    /* Frame data sources */
   guint32      num;         /* Frame number */
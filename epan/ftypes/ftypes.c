@@ -197,6 +197,15 @@ ftype_can_le(enum ftenum ftype)
 	return ft->cmp_le ? TRUE : FALSE;
 }
 
+gboolean
+ftype_needs_cleanup(enum ftenum ftype)
+{
+	ftype_t	*ft;
+
+	ft = ftype_lookup(ftype);
+	return ft->free_value ? TRUE : FALSE;
+}
+
 /* ---------------------------------------------------------- */
 
 /* Allocate and initialize an fvalue_t, given an ftype */
@@ -204,10 +213,18 @@ fvalue_t*
 fvalue_new(ftenum_t ftype)
 {
 	fvalue_t		*fv;
-	ftype_t			*ft;
-	FvalueNewFunc		new_value;
 
 	fv = g_mem_chunk_alloc(gmc_fvalue);
+	fvalue_init(fv, ftype);
+	return fv;
+}
+
+/* Initialize an fvalue_t whose storage the caller has allocated */
+void
+fvalue_init(fvalue_t *fv, ftenum_t ftype)
+{
+	ftype_t			*ft;
+	FvalueNewFunc		new_value;
 
 	ft = ftype_lookup(ftype);
 	fv->ftype = ft;
@@ -216,13 +233,19 @@ fvalue_new(ftenum_t ftype)
 	if (new_value) {
 		new_value(fv);
 	}
-
-	return fv;
 }
 
 /* Free all memory used by an fvalue_t */
 void
 fvalue_free(fvalue_t *fv)
+{
+	fvalue_cleanup(fv);
+	g_mem_chunk_free(gmc_fvalue, fv);
+}
+
+/* Free the memory used by an fvalue_t's value, but not the fvalue_t */
+void
+fvalue_cleanup(fvalue_t *fv)
 {
 	FvalueFreeFunc	free_value;
 
@@ -230,8 +253,6 @@ fvalue_free(fvalue_t *fv)
 	if (free_value) {
 		free_value(fv);
 	}
-
-	g_mem_chunk_free(gmc_fvalue, fv);
 }
 
 
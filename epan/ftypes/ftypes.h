@@ -109,6 +109,11 @@ ftype_can_lt(enum ftenum ftype);
 gboolean
 ftype_can_le(enum ftenum ftype);
 
+/* Returns TRUE if an fvalue_t of this type allocates memory for its
+ * value, which "fvalue_cleanup()" must free. */
+gboolean
+ftype_needs_cleanup(enum ftenum ftype);
+
 /* ---------------- FVALUE ----------------- */
 
 #include <epan/ipv4.h>
@@ -142,6 +147,16 @@ fvalue_new(ftenum_t ftype);
 void
 fvalue_free(fvalue_t *fv);
 
+/* Initialize an fvalue_t in storage supplied by the caller, rather
+ * than allocating it as "fvalue_new()" does. */
+void
+fvalue_init(fvalue_t *fv, ftenum_t ftype);
+
+/* Free the memory used by the value of an fvalue_t initialized with
+ * "fvalue_init()", but not the fvalue_t itself. */
+void
+fvalue_cleanup(fvalue_t *fv);
+
 typedef void (*LogFunc)(char*,...);
 
 fvalue_t*
@@ -80,6 +80,7 @@
 #include "tvbuff.h"
 #include "plugins.h"
 #include "epan_dissect.h"
+#include "conversation.h"
 
 static gint proto_malformed = -1;
 static dissector_handle_t frame_handle = NULL;
@@ -180,6 +181,32 @@ postseq_cleanup_all_protocols(void)
 			&call_postseq_cleanup_routine, NULL);
 }
 
+/* Allow protocols to register a routine to be called when a
+ * dissection is freed. */
+static GSList *dissect_free_routines;
+
+void
+register_dissect_free_routine(void (*func)(packet_info *))
+{
+	dissect_free_routines = g_slist_append(dissect_free_routines, func);
+}
+
+/* Call all the registered "dissect_free" routines. */
+static void
+call_dissect_free_routine(gpointer routine, gpointer pinfo)
+{
+	void (*func)(packet_info *) = routine;
+
+	(*func)(pinfo);
+}
+
+void
+dissect_free_all_protocols(packet_info *pinfo)
+{
+	g_slist_foreach(dissect_free_routines,
+			&call_dissect_free_routine, pinfo);
+}
+
 
 /* Allow dissectors to register a "final_registration" routine
  * that is run like the proto_register_XXX() routine, but the end
@@ -813,6 +840,8 @@ static GHashTable *heur_dissector_lists = NULL;
 typedef struct {
 	heur_dissector_t dissector;
 	int	proto_index;
+	guint32	tries;		/* number of packets it's been handed */
+	guint32	hits;		/* number of those it recognized */
 } heur_dtbl_entry_t;
 
 /* Finds a heuristic dissector table by field name. */
@@ -835,20 +864,64 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, int proto)
 	dtbl_entry = g_malloc(sizeof (heur_dtbl_entry_t));
 	dtbl_entry->dissector = dissector;
 	dtbl_entry->proto_index = proto;
+	dtbl_entry->tries = 0;
+	dtbl_entry->hits = 0;
 
 	/* do the table insertion */
 	*sub_dissectors = g_slist_append(*sub_dissectors, (gpointer)dtbl_entry);
 }
 
+/* Hand a packet to one heuristic dissector, if its protocol is enabled. */
+static gboolean
+call_heur_dissector(heur_dtbl_entry_t *dtbl_entry, tvbuff_t *tvb,
+    packet_info *pinfo, proto_tree *tree, guint16 saved_can_desegment)
+{
+	if (dtbl_entry->proto_index != -1 &&
+	    !proto_is_protocol_enabled(dtbl_entry->proto_index)) {
+		/*
+		 * No - don't try this dissector.
+		 */
+		return FALSE;
+	}
+
+	pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
+	if (dtbl_entry->proto_index != -1) {
+		pinfo->current_proto =
+		    proto_get_protocol_short_name(dtbl_entry->proto_index);
+	}
+	dtbl_entry->tries++;
+	if ((*dtbl_entry->dissector)(tvb, pinfo, tree)) {
+		dtbl_entry->hits++;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * The dissector that recognized the last packet in a conversation is
+ * tried first on the next one; if it doesn't recognize that packet,
+ * the others are tried.
+ *
+ * A dissector that recognizes more packets than the one ahead of it
+ * in the list is moved ahead of it, so the most successful dissectors
+ * are tried first.  The dissectors are moved by swapping the data of
+ * the list elements, rather than the elements themselves, so that the
+ * list always starts with the same element, as the list's owner has a
+ * pointer to that element.
+ */
 gboolean
 dissector_try_heuristic(heur_dissector_list_t sub_dissectors,
     tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)
 {
 	gboolean status;
 	const char *saved_proto;
-	GSList *entry;
-	heur_dtbl_entry_t *dtbl_entry;
+	GSList *entry, *prev_entry;
+	heur_dtbl_entry_t *dtbl_entry, *remembered;
 	guint16 saved_can_desegment;
+	conversation_t *conversation;
+	address src, dst;
+	port_type ptype;
+	guint32 srcport, destport;
 
 	/* can_desegment is set to 2 by anyone which offers this api/service.
 	   then everytime a subdissector is called it is decremented by one.
@@ -858,25 +931,61 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors,
 	saved_can_desegment=pinfo->can_desegment;
 	pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
 
+	/* The dissectors may change the addresses and ports, so save them. */
+	src = pinfo->src;
+	dst = pinfo->dst;
+	ptype = pinfo->ptype;
+	srcport = pinfo->srcport;
+	destport = pinfo->destport;
+
+	conversation = NULL;
+	remembered = NULL;
+	if (ptype != PT_NONE) {
+		conversation = find_conversation(&src, &dst, ptype, srcport,
+		    destport, 0);
+		if (conversation != NULL) {
+			remembered = conversation_get_heur_dissector(
+			    conversation, sub_dissectors);
+		}
+	}
+
 	status = FALSE;
 	saved_proto = pinfo->current_proto;
-	for (entry = sub_dissectors; entry != NULL; entry = g_slist_next(entry)) {
-		pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
-		dtbl_entry = (heur_dtbl_entry_t *)entry->data;
-		if (dtbl_entry->proto_index != -1 &&
-		    !proto_is_protocol_enabled(dtbl_entry->proto_index)) {
-			/*
-			 * No - don't try this dissector.
-			 */
-			continue;
-		}
+	if (remembered != NULL &&
+	    call_heur_dissector(remembered, tvb, pinfo, tree,
+	      saved_can_desegment))
+		status = TRUE;
+	else {
+		prev_entry = NULL;
+		for (entry = sub_dissectors; entry != NULL;
+		    prev_entry = entry, entry = g_slist_next(entry)) {
+			dtbl_entry = (heur_dtbl_entry_t *)entry->data;
+			if (dtbl_entry == remembered)
+				continue;	/* already tried it */
+			if (!call_heur_dissector(dtbl_entry, tvb, pinfo, tree,
+			    saved_can_desegment))
+				continue;
 
-		if (dtbl_entry->proto_index != -1) {
-			pinfo->current_proto =
-			    proto_get_protocol_short_name(dtbl_entry->proto_index);
-		}
-		if ((*dtbl_entry->dissector)(tvb, pinfo, tree)) {
 			status = TRUE;
+			if (prev_entry != NULL &&
+			    dtbl_entry->hits >
+			      ((heur_dtbl_entry_t *)prev_entry->data)->hits) {
+				entry->data = prev_entry->data;
+				prev_entry->data = dtbl_entry;
+			}
+			if (ptype != PT_NONE) {
+				/* The dissector may have made a conversation
+				   of its own, with its own state; use it
+				   rather than replacing it with a new one. */
+				conversation = find_conversation(&src, &dst,
+				    ptype, srcport, destport, 0);
+				if (conversation == NULL) {
+					conversation = conversation_new(&src,
+					    &dst, ptype, srcport, destport, 0);
+				}
+				conversation_set_heur_dissector(conversation,
+				    sub_dissectors, dtbl_entry);
+			}
 			break;
 		}
 	}
@@ -885,6 +994,47 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors,
 	return status;
 }
 
+typedef struct {
+	heur_dissector_stats_func func;
+	gpointer user_data;
+} heur_stats_closure;
+
+static void
+heur_list_stats(gpointer key, gpointer value, gpointer user_data)
+{
+	const char *list_name = key;
+	heur_dissector_list_t *sub_dissectors = value;
+	heur_stats_closure *closure = user_data;
+	GSList *entry;
+	heur_dtbl_entry_t *dtbl_entry;
+	char *proto_name;
+
+	for (entry = *sub_dissectors; entry != NULL;
+	    entry = g_slist_next(entry)) {
+		dtbl_entry = (heur_dtbl_entry_t *)entry->data;
+		if (dtbl_entry->proto_index != -1) {
+			proto_name = proto_get_protocol_short_name(
+			    dtbl_entry->proto_index);
+		} else
+			proto_name = "(unknown)";
+		(*closure->func)(list_name, proto_name, dtbl_entry->tries,
+		    dtbl_entry->hits, closure->user_data);
+	}
+}
+
+void
+heur_dissector_stats_foreach(heur_dissector_stats_func func,
+    gpointer user_data)
+{
+	heur_stats_closure closure;
+
+	if (heur_dissector_lists == NULL)
+		return;
+	closure.func = func;
+	closure.user_data = user_data;
+	g_hash_table_foreach(heur_dissector_lists, heur_list_stats, &closure);
+}
+
 void
 register_heur_dissector_list(const char *name, heur_dissector_list_t *sub_dissectors)
 {
@@ -177,10 +177,24 @@ extern void heur_dissector_add(const char *name, heur_dissector_t dissector,
 
 /* Try all the dissectors in a given heuristic dissector list until
    we find one that recognizes the protocol, in which case we return
-   TRUE, or we run out of dissectors, in which case we return FALSE. */
+   TRUE, or we run out of dissectors, in which case we return FALSE.
+
+   The dissector that recognized the previous packet in the packet's
+   conversation is tried first, and the others are tried in order of
+   how many packets they've recognized, so a heuristic dissector must
+   reject packets that aren't for its protocol, whichever dissectors
+   have been tried before it. */
 extern gboolean dissector_try_heuristic(heur_dissector_list_t sub_dissectors,
     tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree);
 
+/* Call a routine for each heuristic dissector, with the name of its
+   list, the short name of its protocol, the number of packets it's
+   been handed, and the number of those it recognized. */
+typedef void (*heur_dissector_stats_func)(const char *list_name,
+    const char *proto_name, guint32 tries, guint32 hits, gpointer user_data);
+extern void heur_dissector_stats_foreach(heur_dissector_stats_func func,
+    gpointer user_data);
+
 /* Register a dissector. */
 extern void register_dissector(const char *name, dissector_t dissector,
     int proto);
@@ -231,6 +245,15 @@ extern void register_postseq_cleanup_routine(void (*func)(void));
 /* Call all the registered "postseq_cleanup" routines. */
 extern void postseq_cleanup_all_protocols(void);
 
+/* Allow protocols to register a routine to be called, with the
+ * "packet_info" for a dissection, when that dissection is freed;
+ * any data the protocol handed to tvbuffs created during the
+ * dissection is no longer referred to by the dissection after that. */
+extern void register_dissect_free_routine(void (*func)(packet_info *));
+
+/* Call all the registered "dissect_free" routines. */
+extern void dissect_free_all_protocols(packet_info *pinfo);
+
 /* Allow dissectors to register a "final_registration" routine
  * that is run like the proto_register_XXX() routine, but the end
  * end of the epan_init() function; that is, *after* all other
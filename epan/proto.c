@@ -48,8 +48,20 @@
 
 #define cVALS(x) (const value_string*)(x)
 
+static void free_node_tree_data(tree_data_t *tree_data);
+
 static gboolean
-proto_tree_free_node(GNode *node, gpointer data);
+proto_tree_can_fake(proto_tree *tree, int hfindex, header_field_info *hfinfo);
+static gint
+proto_tree_fake_item_length(header_field_info *hfinfo, tvbuff_t *tvb,
+    gint start, gint length, gboolean little_endian);
+static proto_item *
+proto_tree_add_fake(proto_tree *tree, tvbuff_t *tvb, gint start, gint length);
+
+/* Is this item a fake item, standing in for one that isn't in the tree? */
+#define PROTO_ITEM_IS_FAKE(pi) \
+	(PITEM_FINFO(pi) != NULL && \
+	 PITEM_FINFO(pi)->value == PTREE_DATA(pi)->fake_value)
 
 static void fill_label_boolean(field_info *fi, gchar *label_str);
 static void fill_label_uint(field_info *fi, gchar *label_str);
@@ -140,24 +152,47 @@ typedef struct {
 static GList *protocols;
 
 #define INITIAL_NUM_PROTOCOL_HFINFO     200
-#define INITIAL_NUM_FIELD_INFO          100
-#define INITIAL_NUM_PROTO_NODE          100
-#define INITIAL_NUM_ITEM_LABEL          100
 
 
 /* Contains information about protocols and header fields. Used when
  * dissectors register their data */
 static GMemChunk *gmc_hfinfo = NULL;
 
-/* Contains information about a field when a dissector calls
- * proto_tree_add_item.  */
-static GMemChunk *gmc_field_info = NULL;
-
-/* Contains the space for proto_nodes. */
-static GMemChunk *gmc_proto_node = NULL;
-
-/* String space for protocol and field items for the GUI */
-static GMemChunk *gmc_item_labels = NULL;
+/* Everything that makes up a protocol tree - the GNodes, proto_nodes,
+ * field_infos, fvalue_ts and item labels - is allocated from an arena
+ * belonging to that tree, carved sequentially out of fixed-size blocks,
+ * and is never freed individually; freeing the tree hands its blocks
+ * back all at once, without walking the tree.  We keep some freed
+ * blocks around, so that the next packet's tree can reuse them.
+ *
+ * Field values that point to memory of their own (strings and byte
+ * arrays) are put on a list, so that memory can be freed along with
+ * the tree. */
+#define TREE_ARENA_BLOCK_SIZE		(16 * 1024)
+#define TREE_ARENA_MAX_FREE_BLOCKS	64
+
+/* All allocations from an arena are aligned on this boundary. */
+#define TREE_ARENA_ALIGN(size)		(((size) + 7) & ~7)
+
+typedef struct _tree_arena_block {
+	struct _tree_arena_block	*next;
+} tree_arena_block;
+
+typedef struct _fvalue_cleanup {
+	struct _fvalue_cleanup		*next;
+	fvalue_t			*fv;
+} fvalue_cleanup_t;
+
+typedef struct _tree_arena {
+	tree_arena_block	*blocks;	/* blocks in use; current one first */
+	gchar			*free_ptr;	/* first free byte in current block */
+	size_t			free_left;	/* free bytes left in current block */
+	fvalue_cleanup_t	*cleanups;	/* values with memory of their own */
+} tree_arena;
+
+/* Blocks freed by "proto_tree_free()", for reuse. */
+static tree_arena_block *free_arena_blocks = NULL;
+static int num_free_arena_blocks = 0;
 
 /* List which stores protocols and fields that have been registered */
 static GPtrArray *gpa_hfinfo = NULL;
@@ -183,12 +218,6 @@ proto_init(const char *plugin_dir,void (register_all_protocols)(void),
 
 	if (gmc_hfinfo)
 		g_mem_chunk_destroy(gmc_hfinfo);
-	if (gmc_field_info)
-		g_mem_chunk_destroy(gmc_field_info);
-	if (gmc_proto_node)
-		g_mem_chunk_destroy(gmc_proto_node);
-	if (gmc_item_labels)
-		g_mem_chunk_destroy(gmc_item_labels);
 	if (gpa_hfinfo)
 		g_ptr_array_free(gpa_hfinfo, TRUE);
 	if (tree_is_expanded != NULL)
@@ -199,21 +228,6 @@ proto_init(const char *plugin_dir,void (register_all_protocols)(void),
         INITIAL_NUM_PROTOCOL_HFINFO * sizeof(header_field_info),
         G_ALLOC_ONLY);
 
-	gmc_field_info = g_mem_chunk_new("gmc_field_info",
-		sizeof(field_info),
-        INITIAL_NUM_FIELD_INFO * sizeof(field_info),
-		G_ALLOC_AND_FREE);
-
-	gmc_proto_node = g_mem_chunk_new("gmc_proto_node",
-		sizeof(proto_node),
-        INITIAL_NUM_PROTO_NODE * sizeof(proto_node),
-		G_ALLOC_AND_FREE);
-
-	gmc_item_labels = g_mem_chunk_new("gmc_item_labels",
-		ITEM_LABEL_LENGTH,
-        INITIAL_NUM_ITEM_LABEL* ITEM_LABEL_LENGTH,
-		G_ALLOC_AND_FREE);
-
 	gpa_hfinfo = g_ptr_array_new();
 
 	/* Allocate "tree_is_expanded", with one element for ETT_NONE,
@@ -262,40 +276,122 @@ proto_init(const char *plugin_dir,void (register_all_protocols)(void),
 void
 proto_cleanup(void)
 {
+	tree_arena_block *block;
+
 	if (gmc_hfinfo)
 		g_mem_chunk_destroy(gmc_hfinfo);
-	if (gmc_field_info)
-		g_mem_chunk_destroy(gmc_field_info);
-	if (gmc_proto_node)
-		g_mem_chunk_destroy(gmc_proto_node);
-	if (gmc_item_labels)
-		g_mem_chunk_destroy(gmc_item_labels);
 	if (gpa_hfinfo)
 		g_ptr_array_free(gpa_hfinfo, TRUE);
 	if (tree_is_expanded != NULL)
 		g_free(tree_is_expanded);
 
+	while (free_arena_blocks != NULL) {
+		block = free_arena_blocks;
+		free_arena_blocks = block->next;
+		g_free(block);
+	}
+	num_free_arena_blocks = 0;
+
 	/* Cleanup the ftype subsystem */
 	ftypes_cleanup();
 }
 
+/* Get a block for an arena, reusing a freed one if we have one. */
+static tree_arena_block *
+tree_arena_block_new(void)
+{
+	tree_arena_block *block;
+
+	if (free_arena_blocks != NULL) {
+		block = free_arena_blocks;
+		free_arena_blocks = block->next;
+		num_free_arena_blocks--;
+	} else
+		block = g_malloc(TREE_ARENA_BLOCK_SIZE);
+	return block;
+}
+
+/* Create an arena; the arena itself lives at the start of its first
+ * block. */
+static tree_arena *
+tree_arena_new(void)
+{
+	tree_arena_block *block;
+	tree_arena	*arena;
+	size_t		used;
+
+	block = tree_arena_block_new();
+	block->next = NULL;
+	used = TREE_ARENA_ALIGN(sizeof (tree_arena_block));
+	arena = (tree_arena *)((gchar *)block + used);
+	used += TREE_ARENA_ALIGN(sizeof (tree_arena));
+
+	arena->blocks = block;
+	arena->free_ptr = (gchar *)block + used;
+	arena->free_left = TREE_ARENA_BLOCK_SIZE - used;
+	arena->cleanups = NULL;
+	return arena;
+}
+
+/* Allocate "size" bytes from an arena; "size" must be well under
+ * TREE_ARENA_BLOCK_SIZE, which is true of everything we put in a
+ * protocol tree. */
+static gpointer
+tree_arena_alloc(tree_arena *arena, size_t size)
+{
+	tree_arena_block *block;
+	gpointer	p;
+
+	size = TREE_ARENA_ALIGN(size);
+	if (size > arena->free_left) {
+		block = tree_arena_block_new();
+		block->next = arena->blocks;
+		arena->blocks = block;
+		arena->free_ptr = (gchar *)block +
+		    TREE_ARENA_ALIGN(sizeof (tree_arena_block));
+		arena->free_left = TREE_ARENA_BLOCK_SIZE -
+		    TREE_ARENA_ALIGN(sizeof (tree_arena_block));
+	}
+	p = arena->free_ptr;
+	arena->free_ptr += size;
+	arena->free_left -= size;
+	return p;
+}
+
+/* Free the memory that values in an arena point to, and hand the
+ * arena's blocks back; that frees the arena itself, too. */
+static void
+tree_arena_free(tree_arena *arena)
+{
+	fvalue_cleanup_t *cleanup;
+	tree_arena_block *block, *next_block;
+
+	for (cleanup = arena->cleanups; cleanup != NULL;
+	    cleanup = cleanup->next)
+		fvalue_cleanup(cleanup->fv);
+
+	for (block = arena->blocks; block != NULL; block = next_block) {
+		next_block = block->next;
+		if (num_free_arena_blocks < TREE_ARENA_MAX_FREE_BLOCKS) {
+			block->next = free_arena_blocks;
+			free_arena_blocks = block;
+			num_free_arena_blocks++;
+		} else
+			g_free(block);
+	}
+}
+
 /* frees the resources that the dissection a proto_tree uses */
 void
 proto_tree_free(proto_tree *tree)
 {
-    /* Free all the data pointed to by the tree. */
-	g_node_traverse((GNode*)tree, G_IN_ORDER, G_TRAVERSE_ALL, -1,
-		proto_tree_free_node, NULL);
-
-    /* Then free the tree. */
-	g_node_destroy((GNode*)tree);
-}
+	tree_data_t	*tree_data = PTREE_DATA(tree);
+	tree_arena	*arena = tree_data->arena;
 
-/* We accept a void* instead of a field_info* to satisfy CLEANUP_POP */
-static void
-free_field_info(void *fi)
-{
-	g_mem_chunk_free(gmc_field_info, (field_info*)fi);
+	/* Free the per-tree data; everything else, including the
+	 * tree's GNodes, is in the arena. */
+	free_node_tree_data(tree_data);
+	tree_arena_free(arena);
 }
 
 static void
@@ -316,41 +412,9 @@ free_node_tree_data(tree_data_t *tree_data)
         /* And then destroy the hash. */
         g_hash_table_destroy(tree_data->interesting_hfids);
 
-        /* And finally the tree_data_t itself. */
-        g_free(tree_data);
+        /* The tree_data_t itself is in the tree's arena. */
 }
 
-static void
-free_node_field_info(field_info* finfo)
-{
-		if (finfo->representation) {
-			g_mem_chunk_free(gmc_item_labels, finfo->representation);
-		}
-		fvalue_free(finfo->value);
-		free_field_info(finfo);
-}
-
-static gboolean
-proto_tree_free_node(GNode *node, gpointer data)
-{
-	field_info *finfo = PITEM_FINFO(node);
-
-    if (finfo == NULL) {
-        /* This is the root GNode. Destroy the per-tree data.
-         * There is no field_info to destroy. */
-        free_node_tree_data(PTREE_DATA(node));
-    }
-    else {
-        /* This is a child GNode. Don't free the per-tree data, but
-         * do free the field_info data. */
-        free_node_field_info(finfo);
-	}
-
-    /* Free the proto_node. */
-	g_mem_chunk_free(gmc_proto_node, GNODE_PNODE(node));
-
-	return FALSE; /* FALSE = do not end traversal of GNode tree */
-}
 
 /* Is the parsing being done for a visible proto_tree or an invisible one?
  * By setting this correctly, the proto_tree creation is sped up by not
@@ -525,21 +589,30 @@ proto_tree_add_item(proto_tree *tree, int hfindex, tvbuff_t *tvb,
 	guint32		value, n;
 	char		*string;
 	int		found_length;
+	header_field_info *hfinfo;
     GHashTable  *hash;
     GPtrArray   *ptrs;
 
 	if (!tree)
 		return(NULL);
 
+	/*
+	 * An FT_STRINGZ with a maximum length is as long as the string
+	 * we'd have to fetch, so it's not worth faking.
+	 */
+	hfinfo = proto_registrar_get_nth(hfindex);
+	if (proto_tree_can_fake(tree, hfindex, hfinfo) &&
+	    (hfinfo->type != FT_STRINGZ || length == PROTO_LENGTH_UNTIL_END)) {
+		length = proto_tree_fake_item_length(hfinfo, tvb, start,
+		    length, little_endian);
+		return proto_tree_add_fake(tree, tvb, start, length);
+	}
+
 	new_fi = alloc_field_info(tree, hfindex, tvb, start, length);
 
 	if (new_fi == NULL)
 		return(NULL);
 
-	/* Register a cleanup function in case on of our tvbuff accesses
-	 * throws an exception. We need to clean up new_fi. */
-	CLEANUP_PUSH(free_field_info, new_fi);
-
 	switch(new_fi->hfinfo->type) {
 		case FT_NONE:
 			/* no value to set for FT_NONE */
@@ -614,7 +687,7 @@ proto_tree_add_item(proto_tree *tree, int hfindex, tvbuff_t *tvb,
 			break;
 
 		case FT_STRING:
-			/* This g_strdup'ed memory is freed in proto_tree_free_node() */
+			/* This g_strdup'ed memory is freed in proto_tree_free() */
 			proto_tree_set_string_tvb(new_fi, tvb, start, length);
 			break;
 
@@ -623,7 +696,7 @@ proto_tree_add_item(proto_tree *tree, int hfindex, tvbuff_t *tvb,
 				/* This can throw an exception */
 				length = tvb_strsize(tvb, start);
 
-				/* This g_strdup'ed memory is freed in proto_tree_free_node() */
+				/* This g_strdup'ed memory is freed in proto_tree_free() */
 				string = g_malloc(length);
 
 				tvb_memcpy(tvb, string, start, length);
@@ -632,7 +705,7 @@ proto_tree_add_item(proto_tree *tree, int hfindex, tvbuff_t *tvb,
 			else {
 				/* In this case, length signifies maximum length. */
 
-				/* This g_strdup'ed memory is freed in proto_tree_free_node() */
+				/* This g_strdup'ed memory is freed in proto_tree_free() */
 				string = g_malloc(length);
 
 				CLEANUP_PUSH(g_free, string);
@@ -647,7 +720,7 @@ proto_tree_add_item(proto_tree *tree, int hfindex, tvbuff_t *tvb,
 			break;
 
 		case FT_UINT_STRING:
-			/* This g_strdup'ed memory is freed in proto_tree_free_node() */
+			/* This g_strdup'ed memory is freed in proto_tree_free() */
 			n = get_uint_value(tvb, start, length, little_endian);
 			proto_tree_set_string_tvb(new_fi, tvb, start + length, n);
 
@@ -663,7 +736,6 @@ proto_tree_add_item(proto_tree *tree, int hfindex, tvbuff_t *tvb,
 			break;
 
 	}
-	CLEANUP_POP;
 
 	/* Don't add new node to proto_tree until now so that any exceptions
 	 * raised by a tvbuff access method doesn't leave junk in the proto_tree. */
@@ -1191,7 +1263,7 @@ proto_tree_set_string_tvb(field_info *fi, tvbuff_t *tvb, gint start, gint length
 		length = tvb_ensure_length_remaining(tvb, start);
 	}
 
-	/* This memory is freed in proto_tree_free_node() */
+	/* This memory is freed in proto_tree_free() */
 	string = g_malloc(length + 1);
 	tvb_memcpy(tvb, string, start, length);
 	string[length] = '\0';
@@ -1574,17 +1646,146 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 {
 	GNode *new_gnode;
 	proto_node *pnode;
+	tree_arena *arena = PTREE_DATA(tree)->arena;
+
+	/* Items added under a fake item go under the real item or tree
+	 * that the fake item stands in for. */
+	if (PROTO_ITEM_IS_FAKE(tree))
+		tree = tree->parent;
 
-	pnode = g_mem_chunk_alloc(gmc_proto_node);
+	pnode = tree_arena_alloc(arena, sizeof (proto_node));
 	pnode->finfo = fi;
 	pnode->tree_data = PTREE_DATA(tree);
 
-	new_gnode = g_node_new(pnode);
+	new_gnode = tree_arena_alloc(arena, sizeof (GNode));
+	memset(new_gnode, 0, sizeof (GNode));
+	new_gnode->data = pnode;
 	g_node_append((GNode*)tree, new_gnode);
 
 	return (proto_item*) new_gnode;
 }
 
+/*
+ * A tree that's invisible, and that has been primed with the fields that
+ * a filter or other consumer of the tree is interested in, is only
+ * going to be looked at through the interesting fields' lists; nobody
+ * will ever see anything else in it, so there's no need to build the
+ * rest of it.  We still have to give the dissectors something to add
+ * subtrees and items to, so, for an item that isn't interesting, we
+ * hand back a "fake" item, which isn't in the tree, and which has no
+ * value, but which has the start and length the real item would have,
+ * as dissectors such as those using ptvcursors read the length back.
+ * The same bounds checks are done as when the real item is added, so
+ * that a packet too short to have the item throws the same exception,
+ * and dissection otherwise proceeds exactly as it would with the full
+ * tree.
+ *
+ * Protocol items are always put in the tree, so that the tree has the
+ * same protocols, with the same lengths, as the full tree would.
+ */
+static gboolean
+proto_tree_can_fake(proto_tree *tree, int hfindex, header_field_info *hfinfo)
+{
+	tree_data_t	*tree_data = PTREE_DATA(tree);
+
+	if (tree_data->visible || hfinfo->type == FT_PROTOCOL)
+		return FALSE;
+	if (g_hash_table_size(tree_data->interesting_hfids) == 0)
+		return FALSE;	/* not primed; someone may walk the tree */
+	return g_hash_table_lookup(tree_data->interesting_hfids,
+	    GINT_TO_POINTER(hfindex)) == NULL;
+}
+
+/*
+ * Work out the length "proto_tree_add_item()" would give an item,
+ * fetching only what it takes to do that, and throwing an exception
+ * if any of the item isn't in the tvbuff.
+ */
+static gint
+proto_tree_fake_item_length(header_field_info *hfinfo, tvbuff_t *tvb,
+    gint start, gint length, gboolean little_endian)
+{
+	guint32	n;
+
+	if (length == PROTO_LENGTH_UNTIL_END) {
+		/* As in alloc_field_info() */
+		g_assert(hfinfo->type == FT_NONE ||
+			 hfinfo->type == FT_BYTES ||
+			 hfinfo->type == FT_STRING ||
+			 hfinfo->type == FT_STRINGZ);
+		if (hfinfo->type == FT_STRINGZ) {
+			tvb_ensure_length_remaining(tvb, start);
+			/* This can throw an exception */
+			return tvb_strsize(tvb, start);
+		}
+		length = tvb_ensure_length_remaining(tvb, start);
+	}
+
+	switch (hfinfo->type) {
+		case FT_NONE:
+			/* no value, so nothing is fetched */
+			break;
+
+		case FT_UINT_BYTES:
+		case FT_UINT_STRING:
+			n = get_uint_value(tvb, start, length, little_endian);
+			tvb_ensure_bytes_exist(tvb, start + length, n);
+			length += n;
+			break;
+
+		default:
+			tvb_ensure_bytes_exist(tvb, start, length);
+			break;
+	}
+	return length;
+}
+
+static proto_item *
+proto_tree_add_fake(proto_tree *tree, tvbuff_t *tvb, gint start, gint length)
+{
+	tree_data_t	*tree_data = PTREE_DATA(tree);
+	tree_arena	*arena = tree_data->arena;
+	field_info	*fi;
+	proto_node	*pnode;
+	GNode		*fake;
+
+	/* Anything added under a fake item stands in for something under
+	 * the item or tree for which that fake item stands in. */
+	if (PROTO_ITEM_IS_FAKE(tree))
+		tree = tree->parent;
+
+	if (tree_data->fake_value == NULL) {
+		tree_data->fake_value = tree_arena_alloc(arena,
+		    sizeof (fvalue_t));
+		fvalue_init(tree_data->fake_value, FT_NONE);
+	}
+
+	fi = tree_arena_alloc(arena, sizeof (field_info));
+	fi->hfinfo = proto_registrar_get_nth(hf_text_only);
+	fi->start = start;
+	if (tvb) {
+		fi->start += tvb_raw_offset(tvb);
+	}
+	fi->length = length;
+	fi->tree_type = ETT_NONE;
+	fi->representation = NULL;
+	fi->visible = FALSE;
+	fi->value = tree_data->fake_value;
+	fi->ds_name = NULL;
+
+	pnode = tree_arena_alloc(arena, sizeof (proto_node));
+	pnode->finfo = fi;
+	pnode->tree_data = tree_data;
+
+	/* The fake item's parent is the tree it stands in for, but it
+	 * isn't one of that tree's children. */
+	fake = tree_arena_alloc(arena, sizeof (GNode));
+	memset(fake, 0, sizeof (GNode));
+	fake->data = pnode;
+	fake->parent = tree;
+	return (proto_item*) fake;
+}
+
 
 /* Generic way to allocate field_info and add to proto_tree.
  * Sets *pfi to address of newly-allocated field_info struct, if pfi is
@@ -1601,6 +1802,18 @@ proto_tree_add_pi(proto_tree *tree, int hfindex, tvbuff_t *tvb, gint start, gint
 	if (!tree)
 		return(NULL);
 
+	/* If the caller doesn't want the field_info, it's not going to
+	 * set a value in it, so we can fake the item if nobody's
+	 * interested in it. */
+	if (pfi == NULL &&
+	    proto_tree_can_fake(tree, hfindex, proto_registrar_get_nth(hfindex))) {
+		/* As in alloc_field_info() */
+		g_assert(tvb != NULL || length == 0);
+		if (length == PROTO_LENGTH_UNTIL_END)
+			length = tvb_ensure_length_remaining(tvb, start);
+		return proto_tree_add_fake(tree, tvb, start, length);
+	}
+
 	fi = alloc_field_info(tree, hfindex, tvb, start, length);
 	pi = proto_tree_add_node(tree, fi);
 
@@ -1625,6 +1838,8 @@ alloc_field_info(proto_tree *tree, int hfindex, tvbuff_t *tvb, gint start, gint
 {
 	header_field_info	*hfinfo;
 	field_info		*fi;
+	tree_arena		*arena;
+	fvalue_cleanup_t	*cleanup;
 
 	/*
 	 * We only allow a null tvbuff if the item has a zero length,
@@ -1655,7 +1870,8 @@ alloc_field_info(proto_tree *tree, int hfindex, tvbuff_t *tvb, gint start, gint
 		length = tvb_ensure_length_remaining(tvb, start);
 	}
 
-	fi = g_mem_chunk_alloc(gmc_field_info);
+	arena = PTREE_DATA(tree)->arena;
+	fi = tree_arena_alloc(arena, sizeof (field_info));
 	fi->hfinfo = hfinfo;
 	fi->start = start;
 	if (tvb) {
@@ -1666,7 +1882,16 @@ alloc_field_info(proto_tree *tree, int hfindex, tvbuff_t *tvb, gint start, gint
 	fi->visible = PTREE_DATA(tree)->visible;
 	fi->representation = NULL;
 
-	fi->value = fvalue_new(fi->hfinfo->type);
+	fi->value = tree_arena_alloc(arena, sizeof (fvalue_t));
+	fvalue_init(fi->value, fi->hfinfo->type);
+	if (ftype_needs_cleanup(fi->hfinfo->type)) {
+		/* The value will point to memory of its own; free it when
+		 * the tree is freed. */
+		cleanup = tree_arena_alloc(arena, sizeof (fvalue_cleanup_t));
+		cleanup->fv = fi->value;
+		cleanup->next = arena->cleanups;
+		arena->cleanups = cleanup;
+	}
 
 	/* add the data source name */
 	if (tvb) {
@@ -1686,7 +1911,12 @@ proto_tree_set_representation(proto_item *pi, const char *format, va_list ap)
 	field_info *fi = PITEM_FINFO(pi);
 
 	if (fi->visible) {
-		fi->representation = g_mem_chunk_alloc(gmc_item_labels);
+		/* If the item already has a label, overwrite it. */
+		if (fi->representation == NULL) {
+			fi->representation = tree_arena_alloc(
+			    GNODE_PNODE(pi)->tree_data->arena,
+			    ITEM_LABEL_LENGTH);
+		}
 		vsnprintf(fi->representation, ITEM_LABEL_LENGTH, format, ap);
 	}
 }
@@ -1704,9 +1934,6 @@ proto_item_set_text(proto_item *pi, const char *format, ...)
 
 	fi = PITEM_FINFO(pi);
 
-	if (fi->representation)
-		g_mem_chunk_free(gmc_item_labels, fi->representation);
-
 	va_start(ap, format);
 	proto_tree_set_representation(pi, format, ap);
 	va_end(ap);
@@ -1727,13 +1954,20 @@ proto_item_append_text(proto_item *pi, const char *format, ...)
 	fi = PITEM_FINFO(pi);
 
 	if (fi->visible) {
-		va_start(ap, format);
 		/*
-		 * XXX - this will blow up if we haven't already set
-		 * "fi->representation"; that seems OK to me - you
-		 * can't append to something that doesn't exist - but
-		 * there might be cases where that's not convenient.
+		 * If the item doesn't have a label of its own, its label
+		 * is the one generated from its field's name and value,
+		 * which we normally don't produce until the item is
+		 * displayed or printed; produce it now, so that we have
+		 * something to append to.
 		 */
+		if (fi->representation == NULL) {
+			fi->representation = tree_arena_alloc(
+			    GNODE_PNODE(pi)->tree_data->arena,
+			    ITEM_LABEL_LENGTH);
+			proto_item_fill_label(fi, fi->representation);
+		}
+		va_start(ap, format);
 		curlen = strlen(fi->representation);
 		if (ITEM_LABEL_LENGTH > curlen)
 			vsnprintf(fi->representation + curlen,
@@ -1763,12 +1997,19 @@ proto_item_get_len(proto_item *pi)
 proto_tree*
 proto_tree_create_root(void)
 {
+    tree_arena  *arena;
     proto_node  *pnode;
+    GNode       *root;
+
+    /* Everything in the tree is allocated from its arena. */
+    arena = tree_arena_new();
 
     /* Initialize the proto_node */
-    pnode = g_mem_chunk_alloc(gmc_proto_node);
+    pnode = tree_arena_alloc(arena, sizeof (proto_node));
     pnode->finfo = NULL;
-    pnode->tree_data = g_new(tree_data_t, 1);
+    pnode->tree_data = tree_arena_alloc(arena, sizeof (tree_data_t));
+    pnode->tree_data->arena = arena;
+    pnode->tree_data->fake_value = NULL;
 
     /* Initialize the tree_data_t */
     pnode->tree_data->interesting_hfids =
@@ -1780,7 +2021,10 @@ proto_tree_create_root(void)
      * changed, then we'll find out very quickly. */
     pnode->tree_data->visible = FALSE;
 
-	return (proto_tree*) g_node_new(pnode);
+    root = tree_arena_alloc(arena, sizeof (GNode));
+    memset(root, 0, sizeof (GNode));
+    root->data = pnode;
+	return (proto_tree*) root;
 }
 
 	
@@ -2044,6 +2288,8 @@ proto_register_field_init(header_field_info *hfinfo, int parent)
 	case FT_INT24:
 	case FT_INT32:
 		g_assert(hfinfo->display != BASE_NONE);
+		/* Look up values in its value_string quickly */
+		value_string_register(hfinfo->strings);
 		break;
 
 	default:
@@ -2802,7 +3048,7 @@ proto_check_for_protocol_or_field(proto_tree* tree, int id)
 /* Return GPtrArray* of field_info pointers for all hfindex that appear in tree.
  * This only works if the hfindex was "primed" before the dissection
  * took place, as we just pass back the already-created GPtrArray*.
- * The caller should *not* free the GPtrArray*; proto_tree_free_node()
+ * The caller should *not* free the GPtrArray*; proto_tree_free()
  * handles that. */
 GPtrArray*
 proto_get_finfo_ptr_array(proto_tree *tree, int id)
@@ -110,7 +110,9 @@ typedef struct field_info {
 	gint				start;
 	gint				length;
 	gint				tree_type; /* ETT_* */
-	char				*representation; /* for GUI tree */
+	char				*representation; /* for GUI tree; if null, the
+							    label is generated when needed,
+							    by proto_item_fill_label() */
 	int				visible;
 	fvalue_t			*value;
 	gchar				*ds_name;  /* data source name */
@@ -121,11 +123,13 @@ typedef struct field_info {
 typedef struct {
     GHashTable  *interesting_hfids;
     gboolean    visible;
+    struct _tree_arena *arena;	/* memory for the tree's nodes and items */
+    fvalue_t    *fake_value;	/* value shared by all fake items */
 } tree_data_t;
 
 /* Each GNode (proto_tree, proto_item) points to one of
  * these. */
-typedef struct {
+typedef struct _proto_node {
     field_info  *finfo;    
     tree_data_t *tree_data;
 } proto_node;
@@ -31,13 +31,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #ifndef WIN32
 #ifndef AVOID_DNS_TIMEOUT
 #define AVOID_DNS_TIMEOUT
 #endif
+/* look up host names in a separate process if asked to */
+#define ASYNC_DNS
 #endif
 
+#include <errno.h>
+
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
@@ -46,6 +51,18 @@
 # include <sys/types.h>
 #endif
 
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
+
 #ifdef HAVE_NETINET_IN_H
 # include <netinet/in.h>
 #endif
@@ -84,17 +101,17 @@
 #define ENAME_ETHERS 		"ethers"
 #define ENAME_IPXNETS 		"ipxnets"
 #define ENAME_MANUF		"manuf"
+#define ENAME_HOSTS		"hosts"
 
 #define MAXMANUFLEN	9	/* max vendor name length with ending '\0' */
 #define HASHETHSIZE	1024
-#define HASHHOSTSIZE	1024
+#define HOST_CACHE_SIZE	8192	/* max number of cached host names */
 #define HASHIPXNETSIZE	256
-#define HASHMANUFSIZE   256
+#define MANUF_INDEX_SIZE 65536	/* first two bytes of an OUI */
 #define HASHPORTSIZE	256
+#define NAME_FILE_CHECK_INTERVAL 5	/* seconds between checks for changes */
 
-/* hash table used for host and port lookup */
-
-#define HASH_IPV4_ADDRESS(addr)	((addr) & (HASHHOSTSIZE - 1))
+/* hash table used for port lookup */
 
 #define HASH_PORT(port)	((port) & (HASHPORTSIZE - 1))
 
@@ -105,6 +122,32 @@ typedef struct hashname {
   struct hashname 	*next;
 } hashname_t;
 
+/* cache used for host lookup */
+
+#define HOST_IPV4	4
+#define HOST_IPV6	6
+
+#define HOST_ADDR_LEN(type)	((type) == HOST_IPV4 ? 4 : 16)
+
+typedef struct {
+  int			type;		/* HOST_IPV4 or HOST_IPV6 */
+  guint8		addr[16];	/* in network byte order */
+} hostkey_t;
+
+/* states of a lookup */
+#define LOOKUP_DONE		0	/* not being looked up */
+#define LOOKUP_QUEUED		1	/* handed to the resolver process */
+#define LOOKUP_NOT_QUEUED	2	/* resolver was busy; try again */
+
+typedef struct hashhost {
+  hostkey_t		key;
+  guchar   		name[MAXNAMELEN];
+  gboolean              is_dummy_entry;	/* name is the numeric address */
+  int			lookup_state;
+  struct hashhost	*prev;		/* more recently used entry */
+  struct hashhost	*next;		/* less recently used entry */
+} hashhost_t;
+
 /* hash table used for IPX network lookup */
 
 /* XXX - check goodness of hash function */
@@ -119,13 +162,7 @@ typedef struct hashname hashipxnet_t;
 	(((((addr)[2] << 8) | (addr)[3]) ^ (((addr)[4] << 8) | (addr)[5])) & \
 	 (HASHETHSIZE - 1))
 
-#define HASH_ETH_MANUF(addr) (((int)(addr)[2]) & (HASHMANUFSIZE - 1))
-
-typedef struct hashmanuf {
-  guint8 		addr[3];
-  char 			name[MAXMANUFLEN];
-  struct hashmanuf     	*next;
-} hashmanuf_t;
+#define MANUF_INDEX(addr)	(((addr)[0] << 8) | (addr)[1])
 
 typedef struct hashether {
   guint8 		addr[6];
@@ -150,16 +187,38 @@ typedef struct _ipxnet
   char 			name[MAXNAMELEN];
 } ipxnet_t;
 
-static hashname_t 	*host_table[HASHHOSTSIZE];
+/* an ethers or ipxnets file, and when it was last modified when we read it */
+
+typedef struct {
+  gchar			**path;
+  time_t		mtime;		/* 0 if we couldn't read it */
+} name_file_t;
+
+static GHashTable	*host_cache = NULL;
+static hashhost_t	*host_lru_first = NULL;
+static hashhost_t	*host_lru_last = NULL;
+static guint		host_cache_count = 0;
+static GHashTable	*hosts_table = NULL;	/* from the "hosts" file */
 static hashname_t 	*udp_port_table[HASHPORTSIZE];
 static hashname_t 	*tcp_port_table[HASHPORTSIZE];
 static hashname_t       *sctp_port_table[HASHPORTSIZE];
 static hashether_t 	*eth_table[HASHETHSIZE];
-static hashmanuf_t 	*manuf_table[HASHMANUFSIZE];
+static gchar		**manuf_table[MANUF_INDEX_SIZE];
 static hashipxnet_t 	*ipxnet_table[HASHIPXNETSIZE];
 
 static int 		eth_resolution_initialized = 0;
 static int 		ipxnet_resolution_initialized = 0;
+static int 		hosts_initialized = 0;
+
+/* the contents of the ethers and ipxnets files, indexed both ways */
+static GSList		*ethers_entries = NULL;
+static GHashTable	*ethers_by_addr = NULL;
+static GHashTable	*ethers_by_name = NULL;
+static GSList		*ipxnets_entries = NULL;
+static GHashTable	*ipxnets_by_addr = NULL;
+static GHashTable	*ipxnets_by_name = NULL;
+static time_t		ethers_checked = 0;
+static time_t		ipxnets_checked = 0;
 
 /*
  * Flag controlling what names to resolve.
@@ -176,12 +235,28 @@ gchar *g_ethers_path  = NULL;		/* global ethers file    */
 gchar *g_pethers_path = NULL; 		/* personal ethers file  */
 gchar *g_ipxnets_path  = NULL;		/* global ipxnets file   */
 gchar *g_pipxnets_path = NULL;		/* personal ipxnets file */
+gchar *g_phosts_path = NULL;		/* personal hosts file   */
 					/* first resolving call  */
 
+/* the system file is searched first, then the personal one */
+static name_file_t ethers_files[] = {
+  { &g_ethers_path, 0 },
+  { &g_pethers_path, 0 },
+};
+#define N_ETHERS_FILES	(sizeof ethers_files / sizeof ethers_files[0])
+
+static name_file_t ipxnets_files[] = {
+  { &g_ipxnets_path, 0 },
+  { &g_pipxnets_path, 0 },
+};
+#define N_IPXNETS_FILES	(sizeof ipxnets_files / sizeof ipxnets_files[0])
+
 /*
  *  Local function definitions 
  */
 
+static void initialize_hosts(void);
+
 static guchar *serv_name_lookup(guint port, port_type proto)
 {
   int hash_idx;
@@ -258,39 +333,65 @@ static void abort_network_query(int sig)
 }
 #endif /* AVOID_DNS_TIMEOUT */
 
-static guchar *host_name_lookup(guint addr, gboolean *found)
+/*
+ * Host name resolution
+ *
+ * Names for IPv4 and IPv6 addresses are kept in a cache of at most
+ * HOST_CACHE_SIZE entries; when it's full, the least recently used
+ * entry is reused.  Names in the personal "hosts" file are kept
+ * separately, and are never discarded.
+ *
+ * If "host_name_lookup_init()" has been called, addresses not in the
+ * cache are handed to a separate resolver process, and their numeric
+ * form is returned until the name comes back; it's put into the cache
+ * entry, replacing the numeric form, when "host_name_lookup_process()"
+ * is called.  Otherwise, the name is looked up on the spot.
+ */
+
+static guint host_key_hash(gconstpointer k)
 {
-  int hash_idx;
-  hashname_t * volatile tp;
-  struct hostent *hostp;
+  const hostkey_t *key = k;
+  guint hash_val;
+  int i;
 
-  *found = TRUE;
+  hash_val = key->type;
+  for (i = 0; i < HOST_ADDR_LEN(key->type); i++)
+    hash_val = (hash_val << 5) - hash_val + key->addr[i];
+  return hash_val;
+}
 
-  hash_idx = HASH_IPV4_ADDRESS(addr);
+static gint host_key_equal(gconstpointer k1, gconstpointer k2)
+{
+  const hostkey_t *key1 = k1;
+  const hostkey_t *key2 = k2;
 
-  tp = host_table[hash_idx];
+  return key1->type == key2->type &&
+    memcmp(key1->addr, key2->addr, HOST_ADDR_LEN(key1->type)) == 0;
+}
 
-  if( tp == NULL ) {
-    tp = host_table[hash_idx] = (hashname_t *)g_malloc(sizeof(hashname_t));
-  } else {  
-    while(1) {
-      if( tp->addr == addr ) {
-	if (tp->is_dummy_entry)
-	  *found = FALSE;
-	return tp->name;
-      }
-      if (tp->next == NULL) {
-	tp->next = (hashname_t *)g_malloc(sizeof(hashname_t));
-	tp = tp->next;
-	break;
-      }
-      tp = tp->next;
-    }
+static void host_key_init(hostkey_t *key, int type, const void *addr)
+{
+  memset(key, 0, sizeof *key);
+  key->type = type;
+  memcpy(key->addr, addr, HOST_ADDR_LEN(type));
+}
+
+static void host_numeric_name(const hostkey_t *key, guchar *name)
+{
+  if (key->type == HOST_IPV4)
+    ip_to_str_buf(key->addr, name);
+  else {
+    strncpy(name, ip6_to_str((struct e_in6_addr *)key->addr), MAXNAMELEN);
+    name[MAXNAMELEN-1] = '\0';
   }
-  
-  /* fill in a new entry */
-  tp->addr = addr;
-  tp->next = NULL;
+}
+
+/*
+ * Look up the name for an address, waiting for the answer.
+ */
+static gboolean resolve_host(const hostkey_t *key, guchar *name)
+{
+  struct hostent *hostp;
 
   /*
    * The Windows "gethostbyaddr()" insists on translating 0.0.0.0 to
@@ -298,76 +399,215 @@ static guchar *host_name_lookup(guint addr, gboolean *found)
    * botch, we don't try to translate an all-zero IP address to a host
    * name.
    */
-  if (addr != 0 && (g_resolv_flags & RESOLV_NETWORK)) {
-#ifdef AVOID_DNS_TIMEOUT
-    
-    /* Quick hack to avoid DNS/YP timeout */
-  
-    if (!setjmp(hostname_env)) {
-      signal(SIGALRM, abort_network_query);
-      alarm(DNS_TIMEOUT);
+  if (key->type == HOST_IPV4 && pntohl(key->addr) == 0)
+    return FALSE;
+#ifndef INET6
+  if (key->type == HOST_IPV6)
+    return FALSE;
 #endif
-      hostp = gethostbyaddr((char *)&addr, 4, AF_INET);
+
 #ifdef AVOID_DNS_TIMEOUT
-      alarm(0);
+  /* Quick hack to avoid DNS/YP timeout */
+  if (setjmp(hostname_env))
+    return FALSE;
+  signal(SIGALRM, abort_network_query);
+  alarm(DNS_TIMEOUT);
 #endif
-      if (hostp != NULL) {
-	strncpy(tp->name, hostp->h_name, MAXNAMELEN);
-	tp->name[MAXNAMELEN-1] = '\0';
-	tp->is_dummy_entry = FALSE;
-	return tp->name;
-      }
+#ifdef INET6
+  if (key->type == HOST_IPV6)
+    hostp = gethostbyaddr((char *)key->addr, 16, AF_INET6);
+  else
+#endif
+    hostp = gethostbyaddr((char *)key->addr, 4, AF_INET);
 #ifdef AVOID_DNS_TIMEOUT
-    }
+  alarm(0);
 #endif
+  if (hostp == NULL)
+    return FALSE;
+  strncpy(name, hostp->h_name, MAXNAMELEN);
+  name[MAXNAMELEN-1] = '\0';
+  return TRUE;
+}
+
+#ifdef ASYNC_DNS
+
+/* What we send to, and get back from, the resolver process; both are
+   less than PIPE_BUF bytes long, so they're written atomically. */
+typedef struct {
+  hostkey_t	key;
+} resolv_request_t;
+
+typedef struct {
+  hostkey_t	key;
+  gboolean	found;
+  guchar	name[MAXNAMELEN];
+} resolv_reply_t;
+
+static pid_t resolver_pid = -1;
+static int resolver_req_fd = -1;	/* requests to the resolver */
+static int resolver_rep_fd = -1;	/* replies from the resolver */
+static guint lookups_outstanding = 0;
+static gboolean names_found = FALSE;
+
+static gboolean read_all(int fd, void *buf, size_t len)
+{
+  char *p = buf;
+  int n;
+
+  while (len != 0) {
+    n = read(fd, p, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return FALSE;
+    p += n;
+    len -= n;
   }
+  return TRUE;
+}
 
-  /* unknown host or DNS timeout */
+/*
+ * The resolver process: look up each address we're handed, and hand
+ * back the answer, until our parent goes away.
+ */
+static void resolver_main(void)
+{
+  resolv_request_t req;
+  resolv_reply_t rep;
+
+  while (read_all(resolver_req_fd, &req, sizeof req)) {
+    rep.key = req.key;
+    rep.found = resolve_host(&req.key, rep.name);
+    if (write(resolver_rep_fd, &rep, sizeof rep) != sizeof rep)
+      break;
+  }
+  _exit(0);
+}
 
-  ip_to_str_buf((guint8 *)&addr, tp->name);
-  tp->is_dummy_entry = TRUE;
-  *found = FALSE;
+static void queue_host_lookup(hashhost_t *tp)
+{
+  resolv_request_t req;
 
-  return (tp->name);
+  req.key = tp->key;
+  if (write(resolver_req_fd, &req, sizeof req) == sizeof req) {
+    tp->lookup_state = LOOKUP_QUEUED;
+    lookups_outstanding++;
+  } else {
+    /* The resolver's behind; try again the next time we're asked. */
+    tp->lookup_state = LOOKUP_NOT_QUEUED;
+  }
+}
 
-} /* host_name_lookup */
+static void stop_resolver(void)
+{
+  close(resolver_req_fd);
+  close(resolver_rep_fd);
+  resolver_req_fd = resolver_rep_fd = -1;
+  waitpid(resolver_pid, NULL, 0);
+  resolver_pid = -1;
+  lookups_outstanding = 0;
+}
+#endif /* ASYNC_DNS */
 
-static guchar *host_name_lookup6(struct e_in6_addr *addr, gboolean *found)
+static hashhost_t *host_cache_add(const hostkey_t *key)
 {
-  static guchar name[MAXNAMELEN];
-#ifdef INET6
-  struct hostent *hostp;
+  hashhost_t *tp;
 
-  if (g_resolv_flags & RESOLV_NETWORK) {
-#ifdef AVOID_DNS_TIMEOUT
-    
-    /* Quick hack to avoid DNS/YP timeout */
-    
-    if (!setjmp(hostname_env)) {
-      signal(SIGALRM, abort_network_query);
-      alarm(DNS_TIMEOUT);
-#endif /* AVOID_DNS_TIMEOUT */
-      hostp = gethostbyaddr((char *)addr, sizeof(*addr), AF_INET6);
-#ifdef AVOID_DNS_TIMEOUT
-      alarm(0);
+  if (host_cache_count < HOST_CACHE_SIZE) {
+    tp = g_malloc(sizeof(hashhost_t));
+    host_cache_count++;
+  } else {
+    /* Reuse the least recently used entry. */
+    tp = host_lru_last;
+    g_hash_table_remove(host_cache, &tp->key);
+    host_lru_last = tp->prev;
+    host_lru_last->next = NULL;
+  }
+  tp->key = *key;
+  tp->prev = NULL;
+  tp->next = host_lru_first;
+  if (host_lru_first != NULL)
+    host_lru_first->prev = tp;
+  else
+    host_lru_last = tp;
+  host_lru_first = tp;
+  g_hash_table_insert(host_cache, &tp->key, tp);
+  return tp;
+}
+
+static hashhost_t *host_cache_find(const hostkey_t *key)
+{
+  hashhost_t *tp;
+
+  if (host_cache == NULL) {
+    host_cache = g_hash_table_new(host_key_hash, host_key_equal);
+    return NULL;
+  }
+  tp = g_hash_table_lookup(host_cache, key);
+  if (tp != NULL && tp != host_lru_first) {
+    /* Move it to the front of the list. */
+    tp->prev->next = tp->next;
+    if (tp->next != NULL)
+      tp->next->prev = tp->prev;
+    else
+      host_lru_last = tp->prev;
+    tp->prev = NULL;
+    tp->next = host_lru_first;
+    host_lru_first->prev = tp;
+    host_lru_first = tp;
+  }
+  return tp;
+}
+
+static guchar *host_name_lookup(const hostkey_t *key, gboolean *found)
+{
+  const guchar *name;
+  hashhost_t *tp;
+
+  if (!hosts_initialized) {
+    initialize_hosts();
+    hosts_initialized = 1;
+  }
+  if (hosts_table != NULL &&
+      (name = g_hash_table_lookup(hosts_table, key)) != NULL) {
+    *found = TRUE;
+    return (guchar *)name;
+  }
+
+  tp = host_cache_find(key);
+  if (tp != NULL) {
+#ifdef ASYNC_DNS
+    if (tp->lookup_state == LOOKUP_NOT_QUEUED && resolver_pid != -1)
+      queue_host_lookup(tp);
 #endif
-      if (hostp != NULL) {
-	strncpy(name, hostp->h_name, MAXNAMELEN);
-	name[MAXNAMELEN-1] = '\0';
-	*found = TRUE;
-	return name;
-      }
-#ifdef AVOID_DNS_TIMEOUT
-    }
+    *found = !tp->is_dummy_entry;
+    return tp->name;
+  }
+
+  /* fill in a new entry */
+  tp = host_cache_add(key);
+  tp->lookup_state = LOOKUP_DONE;
+#ifdef ASYNC_DNS
+  if (resolver_pid != -1) {
+    host_numeric_name(key, tp->name);
+    tp->is_dummy_entry = TRUE;
+    queue_host_lookup(tp);
+    *found = FALSE;
+    return tp->name;
+  }
 #endif
+  if (resolve_host(key, tp->name)) {
+    tp->is_dummy_entry = FALSE;
+    *found = TRUE;
+  } else {
+    /* unknown host or DNS timeout */
+    host_numeric_name(key, tp->name);
+    tp->is_dummy_entry = TRUE;
+    *found = FALSE;
   }
+  return (tp->name);
 
-  /* unknown host or DNS timeout */
-#endif /* INET6 */
-  *found = FALSE;
-  sprintf(name, "%s", ip6_to_str(addr));  
-  return (name);
-}
+} /* host_name_lookup */
 
 /*
  *  Miscellaneous functions
@@ -410,6 +650,105 @@ static int fgetline(char **buf, int *size, FILE *fp)
 
 } /* fgetline */
 
+/*
+ * Read the personal "hosts" file, which has the same format as
+ * hosts(5); names in it are used in preference to ones looked up.
+ */
+static void initialize_hosts(void)
+{
+  FILE *hf;
+  char *buf = NULL;
+  int size = 0;
+  char *cp, *addr_str, *name;
+  struct in_addr ipaddr;
+  struct e_in6_addr ip6addr;
+  hostkey_t key;
+
+  if (g_phosts_path == NULL)
+    g_phosts_path = get_persconffile_path(ENAME_HOSTS, FALSE);
+
+  if ((hf = fopen(g_phosts_path, "r")) == NULL)
+    return;
+
+  hosts_table = g_hash_table_new(host_key_hash, host_key_equal);
+  while (fgetline(&buf, &size, hf) >= 0) {
+    if ((cp = strchr(buf, '#')))
+      *cp = '\0';
+    if ((addr_str = strtok(buf, " \t")) == NULL)
+      continue;
+    if ((name = strtok(NULL, " \t")) == NULL)
+      continue;
+    if (inet_pton(AF_INET6, addr_str, &ip6addr) == 1)
+      host_key_init(&key, HOST_IPV6, &ip6addr);
+    else if (inet_aton(addr_str, &ipaddr))
+      host_key_init(&key, HOST_IPV4, &ipaddr.s_addr);
+    else
+      continue;
+    /* the first entry for an address is the one used */
+    if (g_hash_table_lookup(hosts_table, &key) != NULL)
+      continue;
+    if (strlen(name) >= MAXNAMELEN)
+      name[MAXNAMELEN-1] = '\0';
+    g_hash_table_insert(hosts_table, g_memdup(&key, sizeof key),
+			g_strdup(name));
+  }
+  g_free(buf);
+  fclose(hf);
+
+} /* initialize_hosts */
+
+
+
+/*
+ * Ethers and ipxnets files
+ *
+ * Each file is read into memory once, and read again if it's been
+ * changed; we look at most every NAME_FILE_CHECK_INTERVAL seconds.
+ */
+
+static time_t name_file_mtime(const gchar *path)
+{
+  struct stat st;
+
+  if (path == NULL || stat(path, &st) != 0)
+    return 0;
+  return st.st_mtime;
+}
+
+/* Returns TRUE if it's time to look at the files again and any of them
+ * has been changed, created, or removed since we read it. */
+static gboolean name_files_changed(name_file_t *files, guint n_files,
+				   time_t *checked)
+{
+  time_t now;
+  guint i;
+
+  now = time(NULL);
+  if (now >= *checked && now - *checked < NAME_FILE_CHECK_INTERVAL)
+    return FALSE;
+  *checked = now;
+
+  for (i = 0; i < n_files; i++) {
+    if (name_file_mtime(*files[i].path) != files[i].mtime)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+static void free_name_file_entries(GHashTable **by_addr, GHashTable **by_name,
+				   GSList **entries)
+{
+  GSList *entry;
+
+  if (*by_addr != NULL) {
+    g_hash_table_destroy(*by_addr);
+    g_hash_table_destroy(*by_name);
+  }
+  for (entry = *entries; entry != NULL; entry = entry->next)
+    g_free(entry->data);
+  g_slist_free(*entries);
+  *entries = NULL;
+}
 
 /*
  * Ethernet / manufacturer resolution
@@ -531,101 +870,114 @@ static ether_t *get_ethent(int six_bytes)
 
 } /* get_ethent */
 
-static ether_t *get_ethbyname(const guchar *name)
+static guint ether_addr_hash(gconstpointer k)
 {
-  ether_t *eth;
-  
-  set_ethent(g_ethers_path);
-
-  while ((eth = get_ethent(1)) && strncmp(name, eth->name, MAXNAMELEN) != 0)
-    ;
+  const guint8 *addr = k;
 
-  if (eth == NULL) {
-    end_ethent();
-    
-    set_ethent(g_pethers_path);
+  return HASH_ETH_ADDRESS(addr) ^ (addr[0] << 16) ^ (addr[1] << 8);
+}
 
-    while ((eth = get_ethent(1)) && strncmp(name, eth->name, MAXNAMELEN) != 0)
-      ;
+static gint ether_addr_equal(gconstpointer k1, gconstpointer k2)
+{
+  return memcmp(k1, k2, 6) == 0;
+}
 
+/* (Re)read the ethers files; the first entry for an address or a
+ * name is the one used. */
+static void load_ethers(void)
+{
+  ether_t *eth, *entry;
+  guint i;
+
+  free_name_file_entries(&ethers_by_addr, &ethers_by_name, &ethers_entries);
+  ethers_by_addr = g_hash_table_new(ether_addr_hash, ether_addr_equal);
+  ethers_by_name = g_hash_table_new(g_str_hash, g_str_equal);
+
+  for (i = 0; i < N_ETHERS_FILES; i++) {
+    ethers_files[i].mtime = name_file_mtime(*ethers_files[i].path);
+    if (*ethers_files[i].path == NULL)
+      continue;
+    set_ethent(*ethers_files[i].path);
+    while ((eth = get_ethent(1))) {
+      if (g_hash_table_lookup(ethers_by_addr, eth->addr) != NULL &&
+	  g_hash_table_lookup(ethers_by_name, eth->name) != NULL)
+	continue;
+      entry = g_memdup(eth, sizeof *eth);
+      ethers_entries = g_slist_prepend(ethers_entries, entry);
+      if (g_hash_table_lookup(ethers_by_addr, entry->addr) == NULL)
+	g_hash_table_insert(ethers_by_addr, entry->addr, entry);
+      if (g_hash_table_lookup(ethers_by_name, entry->name) == NULL)
+	g_hash_table_insert(ethers_by_name, entry->name, entry);
+    }
     end_ethent();
   }
 
-  return eth;
+} /* load_ethers */
 
-} /* get_ethbyname */
-
-static ether_t *get_ethbyaddr(const guint8 *addr)
+/* Give the names we've handed out the values from the ethers files as
+ * they are now.  Entries that have been removed from the files keep
+ * their names, as they may have come from somewhere else. */
+static void refresh_eth_table(void)
 {
-
+  hashether_t *tp;
   ether_t *eth;
-  
-  set_ethent(g_ethers_path);
+  int i;
 
-  while ((eth = get_ethent(1)) && memcmp(addr, eth->addr, 6) != 0)
-    ;
+  for (i = 0; i < HASHETHSIZE; i++) {
+    for (tp = eth_table[i]; tp != NULL; tp = tp->next) {
+      if ((eth = g_hash_table_lookup(ethers_by_addr, tp->addr)) != NULL) {
+	strcpy(tp->name, eth->name);
+	tp->is_dummy_entry = FALSE;
+      }
+    }
+  }
 
-  if (eth == NULL) {
-    end_ethent();
-    
-    set_ethent(g_pethers_path);
-    
-    while ((eth = get_ethent(1)) && memcmp(addr, eth->addr, 6) != 0)
-      ;
-    
-    end_ethent();
+} /* refresh_eth_table */
+
+static void check_ethers(void)
+{
+  if (name_files_changed(ethers_files, N_ETHERS_FILES, &ethers_checked)) {
+    load_ethers();
+    refresh_eth_table();
   }
 
-  return eth;
+} /* check_ethers */
+
+static ether_t *get_ethbyname(const guchar *name)
+{
+  return g_hash_table_lookup(ethers_by_name, name);
+
+} /* get_ethbyname */
+
+static ether_t *get_ethbyaddr(const guint8 *addr)
+{
+  return g_hash_table_lookup(ethers_by_addr, addr);
 
 } /* get_ethbyaddr */
 
+
 static void add_manuf_name(guint8 *addr, guchar *name)
 {
-  int hash_idx;
-  hashmanuf_t *tp;
-
-  hash_idx = HASH_ETH_MANUF(addr);
+  gchar **names;
 
-  tp = manuf_table[hash_idx];
+  names = manuf_table[MANUF_INDEX(addr)];
+  if (names == NULL)
+    names = manuf_table[MANUF_INDEX(addr)] = g_new0(gchar *, 256);
 
-  if( tp == NULL ) {
-    tp = manuf_table[hash_idx] = (hashmanuf_t *)g_malloc(sizeof(hashmanuf_t));
-  } else {  
-    while(1) {
-      if (tp->next == NULL) {
-	tp->next = (hashmanuf_t *)g_malloc(sizeof(hashmanuf_t));
-	tp = tp->next;
-	break;
-      }
-      tp = tp->next;
-    }
-  }
-  
-  memcpy(tp->addr, addr, sizeof(tp->addr));
-  strncpy(tp->name, name, MAXMANUFLEN);
-  tp->name[MAXMANUFLEN-1] = '\0';
-  tp->next = NULL;
+  /* the first entry for an OUI is the one used */
+  if (names[addr[2]] == NULL)
+    names[addr[2]] = g_strndup(name, MAXMANUFLEN - 1);
 
 } /* add_manuf_name */
 
-static hashmanuf_t *manuf_name_lookup(const guint8 *addr)
+static const gchar *manuf_name_lookup(const guint8 *addr)
 {
-  int hash_idx;
-  hashmanuf_t *tp;
-
-  hash_idx = HASH_ETH_MANUF(addr);
+  gchar **names;
 
-  tp = manuf_table[hash_idx];
-  
-  while(tp != NULL) {
-    if (memcmp(tp->addr, addr, sizeof(tp->addr)) == 0) {
-      return tp;
-    }
-    tp = tp->next;
-  }
-  
-  return NULL;
+  names = manuf_table[MANUF_INDEX(addr)];
+  if (names == NULL)
+    return NULL;
+  return names[addr[2]];
 
 } /* manuf_name_lookup */
 
@@ -642,12 +994,13 @@ static void initialize_ethers(void)
 	    get_systemfile_dir(), ENAME_ETHERS);
   }
 
-  /* Set g_pethers_path here, but don't actually do anything
-   * with it. It's used in get_ethbyname() and get_ethbyaddr()
-   */
   if (g_pethers_path == NULL)
     g_pethers_path = get_persconffile_path(ENAME_ETHERS, FALSE);
 
+  /* Read the ethers files */
+  load_ethers();
+  ethers_checked = time(NULL);
+
   /* manuf hash table initialization */
 
   /* Compute the pathname of the manuf file */
@@ -713,7 +1066,7 @@ static hashether_t *add_eth_name(const guint8 *addr, const guchar *name)
 static guchar *eth_name_lookup(const guint8 *addr)
 {
   int hash_idx;
-  hashmanuf_t *manufp;
+  const gchar *manuf;
   hashether_t *tp;
   ether_t *eth;
 
@@ -745,11 +1098,11 @@ static guchar *eth_name_lookup(const guint8 *addr)
   if ( (eth = get_ethbyaddr(addr)) == NULL) {
     /* unknown name */
 
-    if ((manufp = manuf_name_lookup(addr)) == NULL)
+    if ((manuf = manuf_name_lookup(addr)) == NULL)
       sprintf(tp->name, "%s", ether_to_str((guint8 *)addr));
     else
       sprintf(tp->name, "%s_%02x:%02x:%02x", 
-	      manufp->name, addr[3], addr[4], addr[5]);
+	      manuf, addr[3], addr[4], addr[5]);
 
     tp->is_dummy_entry = TRUE;
 
@@ -884,51 +1237,78 @@ static ipxnet_t *get_ipxnetent(void)
 
 } /* get_ipxnetent */
 
-static ipxnet_t *get_ipxnetbyname(const guchar *name)
+/* (Re)read the ipxnets files; the first entry for an address or a
+ * name is the one used. */
+static void load_ipxnets(void)
 {
-  ipxnet_t *ipxnet;
-  
-  set_ipxnetent(g_ipxnets_path);
-
-  while ((ipxnet = get_ipxnetent()) && strncmp(name, ipxnet->name, MAXNAMELEN) != 0)
-    ;
-
-  if (ipxnet == NULL) {
+  ipxnet_t *ipxnet, *entry;
+  guint i;
+
+  free_name_file_entries(&ipxnets_by_addr, &ipxnets_by_name,
+			 &ipxnets_entries);
+  ipxnets_by_addr = g_hash_table_new(g_direct_hash, g_direct_equal);
+  ipxnets_by_name = g_hash_table_new(g_str_hash, g_str_equal);
+
+  for (i = 0; i < N_IPXNETS_FILES; i++) {
+    ipxnets_files[i].mtime = name_file_mtime(*ipxnets_files[i].path);
+    if (*ipxnets_files[i].path == NULL)
+      continue;
+    set_ipxnetent(*ipxnets_files[i].path);
+    while ((ipxnet = get_ipxnetent())) {
+      if (g_hash_table_lookup(ipxnets_by_addr,
+			      GUINT_TO_POINTER(ipxnet->addr)) != NULL &&
+	  g_hash_table_lookup(ipxnets_by_name, ipxnet->name) != NULL)
+	continue;
+      entry = g_memdup(ipxnet, sizeof *ipxnet);
+      ipxnets_entries = g_slist_prepend(ipxnets_entries, entry);
+      if (g_hash_table_lookup(ipxnets_by_addr,
+			      GUINT_TO_POINTER(entry->addr)) == NULL)
+	g_hash_table_insert(ipxnets_by_addr, GUINT_TO_POINTER(entry->addr),
+			    entry);
+      if (g_hash_table_lookup(ipxnets_by_name, entry->name) == NULL)
+	g_hash_table_insert(ipxnets_by_name, entry->name, entry);
+    }
     end_ipxnetent();
-    
-    set_ipxnetent(g_pipxnets_path);
+  }
 
-    while ((ipxnet = get_ipxnetent()) && strncmp(name, ipxnet->name, MAXNAMELEN) != 0)
-      ;
+} /* load_ipxnets */
 
-    end_ipxnetent();
-  }
+/* Give the names we've handed out the values from the ipxnets files as
+ * they are now. */
+static void refresh_ipxnet_table(void)
+{
+  hashipxnet_t *tp;
+  ipxnet_t *ipxnet;
+  int i;
 
-  return ipxnet;
+  for (i = 0; i < HASHIPXNETSIZE; i++) {
+    for (tp = ipxnet_table[i]; tp != NULL; tp = tp->next) {
+      ipxnet = g_hash_table_lookup(ipxnets_by_addr, GUINT_TO_POINTER(tp->addr));
+      if (ipxnet != NULL)
+	strcpy(tp->name, ipxnet->name);
+    }
+  }
 
-} /* get_ipxnetbyname */
+} /* refresh_ipxnet_table */
 
-static ipxnet_t *get_ipxnetbyaddr(guint32 addr)
+static void check_ipxnets(void)
 {
+  if (name_files_changed(ipxnets_files, N_IPXNETS_FILES, &ipxnets_checked)) {
+    load_ipxnets();
+    refresh_ipxnet_table();
+  }
 
-  ipxnet_t *ipxnet;
-  
-  set_ipxnetent(g_ipxnets_path);
+} /* check_ipxnets */
 
-  while ((ipxnet = get_ipxnetent()) && (addr != ipxnet->addr) ) ;
+static ipxnet_t *get_ipxnetbyname(const guchar *name)
+{
+  return g_hash_table_lookup(ipxnets_by_name, name);
 
-  if (ipxnet == NULL) {
-    end_ipxnetent();
-    
-    set_ipxnetent(g_pipxnets_path);
-    
-    while ((ipxnet = get_ipxnetent()) && (addr != ipxnet->addr) )
-      ;
-    
-    end_ipxnetent();
-  }
+} /* get_ipxnetbyname */
 
-  return ipxnet;
+static ipxnet_t *get_ipxnetbyaddr(guint32 addr)
+{
+  return g_hash_table_lookup(ipxnets_by_addr, GUINT_TO_POINTER(addr));
 
 } /* get_ipxnetbyaddr */
 
@@ -948,12 +1328,13 @@ static void initialize_ipxnets(void)
 	    get_systemfile_dir(), ENAME_IPXNETS);
   }
 
-  /* Set g_pipxnets_path here, but don't actually do anything
-   * with it. It's used in get_ipxnetbyname() and get_ipxnetbyaddr()
-   */
   if (g_pipxnets_path == NULL)
     g_pipxnets_path = get_persconffile_path(ENAME_IPXNETS, FALSE);
 
+  /* Read the ipxnets files */
+  load_ipxnets();
+  ipxnets_checked = time(NULL);
+
 } /* initialize_ipxnets */
 
 static hashipxnet_t *add_ipxnet_name(guint addr, const guchar *name)
@@ -1072,16 +1453,19 @@ static guint ipxnet_addr_lookup(const guchar *name, gboolean *success)
 extern guchar *get_hostname(guint addr) 
 {
   gboolean found;
+  hostkey_t key;
 
   if (!(g_resolv_flags & RESOLV_NETWORK))
     return ip_to_str((guint8 *)&addr);
 
-  return host_name_lookup(addr, &found);
+  host_key_init(&key, HOST_IPV4, &addr);
+  return host_name_lookup(&key, &found);
 }
 
 extern const guchar *get_hostname6(struct e_in6_addr *addr)
 {
   gboolean found;
+  hostkey_t key;
 
 #ifdef INET6
   if (!(g_resolv_flags & RESOLV_NETWORK))
@@ -1094,48 +1478,129 @@ extern const guchar *get_hostname6(struct e_in6_addr *addr)
     return ip6_to_str(addr);
 #endif
 
-  return host_name_lookup6(addr, &found);
+  host_key_init(&key, HOST_IPV6, addr);
+  return host_name_lookup(&key, &found);
 }
 
 extern void add_host_name(guint addr, const guchar *name)
 {
-  int hash_idx;
-  hashname_t *tp;
-
-  hash_idx = HASH_IPV4_ADDRESS(addr);
-
-  tp = host_table[hash_idx];
-
-  if( tp == NULL ) {
-    tp = host_table[hash_idx] = (hashname_t *)g_malloc(sizeof(hashname_t));
-  } else {  
-    while(1) {
-      if (tp->addr == addr) {
-	/* address already known */
-	if (!tp->is_dummy_entry) {
-	  return;
-	} else {
-	  /* replace this dummy entry with the new one */
-	  break;
-	}
-      }
-      if (tp->next == NULL) {
-	tp->next = (hashname_t *)g_malloc(sizeof(hashname_t));
-	tp = tp->next;
-	break;
-      }
-      tp = tp->next;
-    }
+  hostkey_t key;
+  hashhost_t *tp;
+
+  host_key_init(&key, HOST_IPV4, &addr);
+  tp = host_cache_find(&key);
+  if (tp == NULL)
+    tp = host_cache_add(&key);
+  else if (!tp->is_dummy_entry) {
+    /* address already known */
+    return;
   }
-  
+
+  /* replace any dummy entry with the new one; if the resolver is
+     still looking the address up, its answer is ignored */
   strncpy(tp->name, name, MAXNAMELEN);
   tp->name[MAXNAMELEN-1] = '\0';
-  tp->addr = addr;
-  tp->next = NULL;
   tp->is_dummy_entry = FALSE;
+  tp->lookup_state = LOOKUP_DONE;
 
 } /* add_host_name */
 
+extern gboolean host_name_lookup_init(void)
+{
+#ifdef ASYNC_DNS
+  int req_pipe[2], rep_pipe[2];
+
+  if (resolver_pid != -1)
+    return TRUE;
+  if (pipe(req_pipe) < 0)
+    return FALSE;
+  if (pipe(rep_pipe) < 0) {
+    close(req_pipe[0]);
+    close(req_pipe[1]);
+    return FALSE;
+  }
+  resolver_pid = fork();
+  if (resolver_pid == 0) {
+    /* We're the resolver. */
+    close(req_pipe[1]);
+    close(rep_pipe[0]);
+    resolver_req_fd = req_pipe[0];
+    resolver_rep_fd = rep_pipe[1];
+    resolver_main();
+  }
+  close(req_pipe[0]);
+  close(rep_pipe[1]);
+  if (resolver_pid == -1) {
+    close(req_pipe[1]);
+    close(rep_pipe[0]);
+    return FALSE;
+  }
+  resolver_req_fd = req_pipe[1];
+  resolver_rep_fd = rep_pipe[0];
+
+  /* Don't wait for the resolver, in either direction, and don't get
+     killed if it goes away. */
+  fcntl(resolver_req_fd, F_SETFL, O_NONBLOCK);
+  fcntl(resolver_rep_fd, F_SETFL, O_NONBLOCK);
+  signal(SIGPIPE, SIG_IGN);
+
+  /* Don't hand our ends of the pipes to programs we run, such as the
+     capture child; if it held the request pipe open, the resolver
+     wouldn't see an EOF, and exit, when we close it. */
+  fcntl(resolver_req_fd, F_SETFD, FD_CLOEXEC);
+  fcntl(resolver_rep_fd, F_SETFD, FD_CLOEXEC);
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
+extern gboolean host_name_lookup_process(void)
+{
+#ifdef ASYNC_DNS
+  resolv_reply_t rep;
+  hashhost_t *tp;
+  int n;
+
+  if (resolver_pid == -1)
+    return FALSE;
+
+  while ((n = read(resolver_rep_fd, &rep, sizeof rep)) == sizeof rep) {
+    lookups_outstanding--;
+    tp = g_hash_table_lookup(host_cache, &rep.key);
+    if (tp == NULL || tp->lookup_state != LOOKUP_QUEUED) {
+      /* The entry has been reused, or the name has been found
+	 some other way, since we asked. */
+      continue;
+    }
+    tp->lookup_state = LOOKUP_DONE;
+    if (rep.found) {
+      strcpy(tp->name, rep.name);
+      tp->is_dummy_entry = FALSE;
+      names_found = TRUE;
+    }
+  }
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+    /* The resolver has gone away; look names up ourselves from now on. */
+    stop_resolver();
+  }
+
+  if (names_found && lookups_outstanding == 0) {
+    names_found = FALSE;
+    return TRUE;
+  }
+#endif
+  return FALSE;
+}
+
+extern void host_name_lookup_cleanup(void)
+{
+#ifdef ASYNC_DNS
+  if (resolver_pid != -1)
+    stop_resolver();
+#endif
+}
+
 extern guchar *get_udp_port(guint port)
 {
   static gchar  str[3][MAXNAMELEN];
@@ -1207,7 +1672,8 @@ extern guchar *get_ether_name(const guint8 *addr)
   if (!eth_resolution_initialized) {
     initialize_ethers();
     eth_resolution_initialized = 1;
-  }
+  } else
+    check_ethers();
 
   return eth_name_lookup(addr);
 
@@ -1230,7 +1696,8 @@ guchar *get_ether_name_if_known(const guint8 *addr)
   if (!eth_resolution_initialized) {
     initialize_ethers();
     eth_resolution_initialized = 1;
-  }
+  } else
+    check_ethers();
 
   hash_idx = HASH_ETH_ADDRESS(addr);
 
@@ -1280,7 +1747,8 @@ extern guint8 *get_ether_addr(const guchar *name)
   if (!eth_resolution_initialized) {
     initialize_ethers();
     eth_resolution_initialized = 1;
-  }
+  } else
+    check_ethers();
 
   return eth_addr_lookup(name);
 
@@ -1291,10 +1759,12 @@ extern void add_ether_byip(guint ip, const guint8 *eth)
 
   guchar *host;
   gboolean found;
+  hostkey_t key;
 
   /* first check that IP address can be resolved */
 
-  if ((host = host_name_lookup(ip, &found)) == NULL)
+  host_key_init(&key, HOST_IPV4, &ip);
+  if ((host = host_name_lookup(&key, &found)) == NULL)
     return;
   
   /* ok, we can add this entry in the ethers hashtable */
@@ -1314,7 +1784,8 @@ extern const guchar *get_ipxnet_name(const guint32 addr)
   if (!ipxnet_resolution_initialized) {
     initialize_ipxnets();
     ipxnet_resolution_initialized = 1;
-  }
+  } else
+    check_ipxnets();
 
   return ipxnet_name_lookup(addr);
 
@@ -1330,7 +1801,8 @@ extern guint32 get_ipxnet_addr(const guchar *name, gboolean *known)
   if (!ipxnet_resolution_initialized) {
     initialize_ipxnets();
     ipxnet_resolution_initialized = 1;
-  }
+  } else
+    check_ipxnets();
 
   addr =  ipxnet_addr_lookup(name, &success);
 
@@ -1343,14 +1815,14 @@ extern const guchar *get_manuf_name(const guint8 *addr)
 {
   static gchar  str[3][MAXMANUFLEN];
   static gchar *cur;
-  hashmanuf_t  *manufp;
+  const gchar  *manuf;
 
   if ((g_resolv_flags & RESOLV_MAC) && !eth_resolution_initialized) {
     initialize_ethers();
     eth_resolution_initialized = 1;
   }
 
-  if (!(g_resolv_flags & RESOLV_MAC) || ((manufp = manuf_name_lookup(addr)) == NULL)) {
+  if (!(g_resolv_flags & RESOLV_MAC) || ((manuf = manuf_name_lookup(addr)) == NULL)) {
     if (cur == &str[0][0]) {
       cur = &str[1][0];
     } else if (cur == &str[1][0]) {  
@@ -1362,7 +1834,7 @@ extern const guchar *get_manuf_name(const guint8 *addr)
     return cur;
   }
   
-  return manufp->name;
+  return manuf;
 
 } /* get_manuf_name */
 
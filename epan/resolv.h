@@ -51,6 +51,7 @@ extern gchar *g_ethers_path;
 extern gchar *g_ipxnets_path;
 extern gchar *g_pethers_path;
 extern gchar *g_pipxnets_path;
+extern gchar *g_phosts_path;
 
 /* Functions in resolv.c */
 
@@ -73,6 +74,13 @@ extern guchar *get_hostname(guint addr);
 struct e_in6_addr;
 const guchar* get_hostname6(struct e_in6_addr *ad);
 
+/* The strings get_hostname and get_hostname6 return are kept in a cache
+ * of limited size, and are reused for other addresses once they've been
+ * unused for long enough; a string is good until at least several
+ * thousand other addresses have been looked up, so it may be used to
+ * build a label or column, but a caller that wants to keep it longer
+ * must make its own copy. */
+
 /* get_ether_name returns the logical name if found in ethers files else
    "<vendor>_%02x:%02x:%02x" if the vendor code is known else
    "%02x:%02x:%02x:%02x:%02x:%02x" */
@@ -96,6 +104,21 @@ extern guint8 *get_ether_addr(const guchar *name);
  * is set to TRUE. */
 guint32 get_ipxnet_addr(const guchar *name, gboolean *known);
 
+/* Start looking up host names in the background; until a name is found,
+ * get_hostname and get_hostname6 return the numeric address.  Returns
+ * FALSE if that can't be done, in which case names are looked up as
+ * they're asked for. */
+extern gboolean host_name_lookup_init(void);
+
+/* Pick up any names the background lookups have found.  Returns TRUE
+ * if names have been found since the last time it returned TRUE and
+ * there are no more lookups outstanding, so that anything showing
+ * addresses can be redisplayed once for a batch of names. */
+extern gboolean host_name_lookup_process(void);
+
+/* Stop looking up host names in the background. */
+extern void host_name_lookup_cleanup(void);
+
 /* adds a hostname/IP in the hash table */
 extern void add_host_name(guint addr, const guchar *name);
 
@@ -645,6 +645,16 @@ tvb_bytes_exist(tvbuff_t *tvb, gint offset, gint length)
 	}
 }
 
+/* Validates that 'length' bytes are available starting from
+ * offset (pos/neg). Throws an exception if they aren't. */
+void
+tvb_ensure_bytes_exist(tvbuff_t *tvb, gint offset, gint length)
+{
+	guint		abs_offset, abs_length;
+
+	check_offset_length(tvb, offset, length, &abs_offset, &abs_length);
+}
+
 gboolean
 tvb_offset_exists(tvbuff_t *tvb, gint offset)
 {
@@ -199,6 +199,11 @@ extern gint tvb_ensure_length_remaining(tvbuff_t*, gint offset);
  * 'offset'/'length' actually exist in the buffer */
 extern gboolean tvb_bytes_exist(tvbuff_t*, gint offset, gint length);
 
+/* Checks that the bytes referred to by 'offset'/'length' actually exist
+ * in the buffer, throwing the same exception that fetching them would
+ * if they don't */
+extern void tvb_ensure_bytes_exist(tvbuff_t*, gint offset, gint length);
+
 /* Checks (w/o throwing exception) that offset exists in buffer */
 extern gboolean tvb_offset_exists(tvbuff_t*, gint offset);
 
@@ -28,6 +28,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #ifdef NEED_SNPRINTF_H
 # include "snprintf.h"
@@ -35,6 +36,158 @@
 #include "to_str.h"
 #include "value_string.h"
 
+/*
+ * Lookups in a value_string array that's been registered with
+ * "value_string_register()" don't scan the array; the first time a
+ * value is looked up in it, we build an index for it:
+ *
+ *	if the values in the array cover at least half of the range
+ *	between its smallest and largest value, a table of strings
+ *	indexed by the value minus the smallest value;
+ *
+ *	otherwise, a copy of the array, sorted by value, that's
+ *	searched with a binary search.
+ *
+ * We wait until a value is looked up because some dissectors fill in
+ * their arrays after registering the fields that use them.  Arrays
+ * too small for an index to beat a scan aren't indexed.
+ *
+ * If a value appears more than once in an array, the first string for
+ * it is the one used, just as with a scan.
+ */
+#define VS_INDEX_MIN_ENTRIES	8
+
+typedef struct {
+  guint32	min;		/* for a table indexed by value */
+  guint32	count;
+  gchar		**strings;
+  value_string	*sorted;	/* for a binary search */
+  guint32	n_sorted;
+} value_string_index;
+
+/* Marks an array we've looked at and decided to scan */
+static value_string_index scan_index;
+
+/* Registered arrays, and their indices if they have them yet */
+static GHashTable *value_string_indices;
+
+void
+value_string_register(const value_string *vs)
+{
+  gpointer orig_key, value;
+
+  if (vs == NULL)
+    return;
+  if (value_string_indices == NULL)
+    value_string_indices = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  /* The index is built when it's first needed */
+  if (!g_hash_table_lookup_extended(value_string_indices, vs, &orig_key,
+				    &value))
+    g_hash_table_insert(value_string_indices, (gpointer)vs, NULL);
+}
+
+typedef struct {
+  guint32	value;
+  gchar		*strptr;
+  guint32	pos;		/* where it is in the array */
+} vs_sort_entry;
+
+static int
+vs_sort_compare(const void *a, const void *b)
+{
+  const vs_sort_entry *ea = a;
+  const vs_sort_entry *eb = b;
+
+  if (ea->value != eb->value)
+    return (ea->value < eb->value) ? -1 : 1;
+  return (ea->pos < eb->pos) ? -1 : (ea->pos > eb->pos);
+}
+
+static value_string_index *
+value_string_build_index(const value_string *vs)
+{
+  value_string_index *vsi;
+  vs_sort_entry *entries;
+  guint32 n, i, j;
+  guint32 min, max;
+
+  for (n = 0; vs[n].strptr != NULL; n++)
+    ;
+  if (n < VS_INDEX_MIN_ENTRIES)
+    return &scan_index;
+
+  min = max = vs[0].value;
+  for (i = 1; i < n; i++) {
+    if (vs[i].value < min)
+      min = vs[i].value;
+    if (vs[i].value > max)
+      max = vs[i].value;
+  }
+
+  vsi = g_malloc(sizeof (value_string_index));
+  vsi->strings = NULL;
+  vsi->sorted = NULL;
+
+  if (max - min < 2 * n) {
+    vsi->min = min;
+    vsi->count = max - min + 1;
+    vsi->strings = g_malloc0(vsi->count * sizeof (gchar *));
+    for (i = 0; i < n; i++) {
+      if (vsi->strings[vs[i].value - min] == NULL)
+        vsi->strings[vs[i].value - min] = vs[i].strptr;
+    }
+    return vsi;
+  }
+
+  entries = g_malloc(n * sizeof (vs_sort_entry));
+  for (i = 0; i < n; i++) {
+    entries[i].value = vs[i].value;
+    entries[i].strptr = vs[i].strptr;
+    entries[i].pos = i;
+  }
+  qsort(entries, n, sizeof (vs_sort_entry), vs_sort_compare);
+
+  /* keep only the first entry for each value */
+  vsi->sorted = g_malloc(n * sizeof (value_string));
+  for (i = 0, j = 0; i < n; i++) {
+    if (j != 0 && vsi->sorted[j - 1].value == entries[i].value)
+      continue;
+    vsi->sorted[j].value = entries[i].value;
+    vsi->sorted[j].strptr = entries[i].strptr;
+    j++;
+  }
+  vsi->n_sorted = j;
+  g_free(entries);
+  return vsi;
+}
+
+/* Returns the index for a registered array, building it if necessary,
+   or NULL if the array isn't registered. */
+static value_string_index *
+value_string_get_index(const value_string *vs)
+{
+  static const value_string *last_vs;
+  static value_string_index *last_vsi;
+  gpointer orig_key, value;
+
+  if (vs == last_vs)
+    return last_vsi;
+
+  last_vs = vs;
+  last_vsi = NULL;
+  if (value_string_indices != NULL &&
+      g_hash_table_lookup_extended(value_string_indices, vs, &orig_key,
+				   &value)) {
+    if (value == NULL) {
+      value = value_string_build_index(vs);
+      g_hash_table_insert(value_string_indices, (gpointer)vs, value);
+    }
+    last_vsi = value;
+  }
+  return last_vsi;
+}
+
 /* Tries to match val against each element in the value_string array vs.
    Returns the associated string ptr on a match.
    Formats val with fmt, and returns the resulting string, on failure. */
@@ -63,7 +216,30 @@ val_to_str(guint32 val, const value_string *vs, const char *fmt) {
 gchar*
 match_strval(guint32 val, const value_string *vs) {
   gint i = 0;
-  
+  value_string_index *vsi;
+  guint32 low, high, mid;
+
+  vsi = value_string_get_index(vs);
+  if (vsi != NULL && vsi->strings != NULL) {
+    if (val - vsi->min < vsi->count)
+      return vsi->strings[val - vsi->min];
+    return NULL;
+  }
+  if (vsi != NULL && vsi->sorted != NULL) {
+    low = 0;
+    high = vsi->n_sorted;
+    while (low < high) {
+      mid = low + (high - low) / 2;
+      if (vsi->sorted[mid].value < val)
+        low = mid + 1;
+      else if (vsi->sorted[mid].value > val)
+        high = mid;
+      else
+        return vsi->sorted[mid].strptr;
+    }
+    return NULL;
+  }
+
   while (vs[i].strptr) {
     if (vs[i].value == val)
       return(vs[i].strptr);
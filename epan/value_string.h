@@ -37,6 +37,11 @@ typedef struct _value_string {
 
 extern gchar*     match_strval(guint32, const value_string*);
 
+/* Have lookups in a value_string array use an index rather than
+   scanning the array; the array must not change once a value has been
+   looked up in it. */
+extern void       value_string_register(const value_string *vs);
+
 extern gchar*     val_to_str(guint32, const value_string *, const char *);
 extern const char *decode_enumerated_bitfield(guint32 val, guint32 mask,
   int width, const value_string *tab, const char *fmt);
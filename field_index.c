@@ -0,0 +1,466 @@
+/* field_index.c
+ * Routines for an index of commonly-filtered-on field values
+ *
+ * $Id$
+ *
+ * Ethereal - Network traffic analyzer
+ * By Gerald Combs <gerald@ethereal.com>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/epan_dissect.h>
+#include <epan/proto.h>
+#include <epan/ipv4.h>
+
+#include "field_index.h"
+
+/*
+ * The fields we index.
+ *
+ * For protocols, we only record whether the protocol is present in the
+ * frame; for other fields, we record their values, which must fit in
+ * 32 bits.  Fields such as "ip.addr" and "tcp.port", which the
+ * dissectors add as hidden items with the values of two other fields,
+ * are made up from the values we record for those fields rather than
+ * being recorded separately.
+ */
+typedef struct {
+	const char	*abbrev;
+	const char	*part_of[2];	/* fields this one is made up of */
+} indexed_field_def_t;
+
+static const indexed_field_def_t indexed_field_defs[] = {
+	{ "eth",		{ NULL,			NULL } },
+	{ "llc",		{ NULL,			NULL } },
+	{ "arp",		{ NULL,			NULL } },
+	{ "ip",			{ NULL,			NULL } },
+	{ "ipv6",		{ NULL,			NULL } },
+	{ "icmp",		{ NULL,			NULL } },
+	{ "tcp",		{ NULL,			NULL } },
+	{ "udp",		{ NULL,			NULL } },
+	{ "frame.pkt_len",	{ NULL,			NULL } },
+	{ "ip.src",		{ NULL,			NULL } },
+	{ "ip.dst",		{ NULL,			NULL } },
+	{ "tcp.srcport",	{ NULL,			NULL } },
+	{ "tcp.dstport",	{ NULL,			NULL } },
+	{ "udp.srcport",	{ NULL,			NULL } },
+	{ "udp.dstport",	{ NULL,			NULL } },
+	{ "ip.addr",		{ "ip.src",		"ip.dst" } },
+	{ "tcp.port",		{ "tcp.srcport",	"tcp.dstport" } },
+	{ "udp.port",		{ "udp.srcport",	"udp.dstport" } },
+};
+#define N_INDEXED_FIELD_DEFS \
+	(sizeof indexed_field_defs / sizeof indexed_field_defs[0])
+
+/*
+ * Each frame's entry in the index is a variable-length record of 32-bit
+ * words:
+ *
+ *	a bitmask of the indexed protocols present in the frame;
+ *
+ *	the number of occurrences of each recorded field, 4 bits per
+ *	field, so at most 8 recorded fields with at most 15 values each;
+ *
+ *	the values of the recorded fields, in order.
+ *
+ * Records are packed into fixed-size blocks, so that indexing millions
+ * of frames doesn't involve reallocating and copying one huge array.
+ */
+#define MAX_PROTOCOLS		32
+#define MAX_RECORDED_FIELDS	8
+#define MAX_VALUES		15
+#define MAX_RECORD_WORDS	(2 + MAX_RECORDED_FIELDS*MAX_VALUES)
+
+#define BLOCK_WORDS		65536
+
+typedef struct {
+	guint32	used;			/* number of words in use */
+	guint32	words[BLOCK_WORDS];
+} index_block_t;
+
+typedef enum {
+	IFIELD_PROTOCOL,		/* presence bit */
+	IFIELD_RECORDED,		/* values recorded in the index */
+	IFIELD_COMBINED			/* made up of other fields' values */
+} ifield_kind_t;
+
+typedef struct {
+	int		hfid;
+	ifield_kind_t	kind;
+	ftenum_t	ftype;
+	int		slot;		/* presence bit or recorded-field number */
+	int		parts[2];	/* for IFIELD_COMBINED, the indexed
+					   fields it's made up of */
+	gboolean	usable;		/* FALSE if a frame had more values
+					   than we can record */
+	fvalue_t	*fvalues[2*MAX_VALUES];	/* values for the current frame */
+	int		n_values;
+	gboolean	loaded;		/* fvalues are for the current frame */
+} indexed_field_t;
+
+struct _field_index {
+	indexed_field_t	fields[N_INDEXED_FIELD_DEFS];
+	int		n_fields;
+	int		n_recorded;	/* number of recorded fields */
+	GHashTable	*by_hfid;	/* hfid -> field number + 1 */
+	GPtrArray	*blocks;
+	guint32		count;		/* number of frames in the index */
+	guint32		*cur_record;	/* record of the frame being filtered */
+};
+
+static int
+lookup_hfid(const char *abbrev)
+{
+	int i, n;
+
+	n = proto_registrar_n();
+	for (i = 0; i < n; i++) {
+		if (strcmp(proto_registrar_get_abbrev(i), abbrev) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static int
+lookup_field(field_index_t *fidx, int hfid)
+{
+	return GPOINTER_TO_INT(g_hash_table_lookup(fidx->by_hfid,
+	    GINT_TO_POINTER(hfid))) - 1;
+}
+
+static gboolean
+is_recordable_type(ftenum_t ftype)
+{
+	switch (ftype) {
+
+	case FT_UINT8:
+	case FT_UINT16:
+	case FT_UINT24:
+	case FT_UINT32:
+	case FT_IPv4:
+		return TRUE;
+
+	default:
+		return FALSE;
+	}
+}
+
+field_index_t *
+field_index_new(void)
+{
+	field_index_t *fidx;
+	const indexed_field_def_t *def;
+	indexed_field_t *field;
+	header_field_info *hfinfo;
+	int n_protocols;
+	int hfid, part;
+	unsigned int i, j;
+
+	fidx = g_malloc(sizeof (field_index_t));
+	fidx->n_fields = 0;
+	fidx->n_recorded = 0;
+	fidx->by_hfid = g_hash_table_new(g_direct_hash, g_direct_equal);
+	fidx->blocks = g_ptr_array_new();
+	fidx->count = 0;
+	fidx->cur_record = NULL;
+
+	n_protocols = 0;
+	for (i = 0; i < N_INDEXED_FIELD_DEFS; i++) {
+		def = &indexed_field_defs[i];
+
+		/* Skip fields that don't exist (e.g., because they're
+		   in a plugin that isn't loaded). */
+		hfid = lookup_hfid(def->abbrev);
+		if (hfid == -1)
+			continue;
+		hfinfo = proto_registrar_get_nth(hfid);
+
+		field = &fidx->fields[fidx->n_fields];
+		field->hfid = hfid;
+		field->ftype = hfinfo->type;
+		field->usable = TRUE;
+		field->n_values = 0;
+		field->loaded = FALSE;
+		if (def->part_of[0] != NULL) {
+			field->kind = IFIELD_COMBINED;
+			field->slot = -1;
+			for (j = 0; j < 2; j++) {
+				part = lookup_hfid(def->part_of[j]);
+				field->parts[j] = (part == -1) ? -1 :
+				    lookup_field(fidx, part);
+				if (field->parts[j] == -1 ||
+				    fidx->fields[field->parts[j]].ftype != field->ftype)
+					field->usable = FALSE;
+			}
+			if (!field->usable)
+				continue;
+		} else if (proto_registrar_is_protocol(hfid)) {
+			if (n_protocols == MAX_PROTOCOLS)
+				continue;
+			field->kind = IFIELD_PROTOCOL;
+			field->slot = n_protocols++;
+		} else {
+			if (!is_recordable_type(field->ftype) ||
+			    fidx->n_recorded == MAX_RECORDED_FIELDS)
+				continue;
+			field->kind = IFIELD_RECORDED;
+			field->slot = fidx->n_recorded++;
+			for (j = 0; j < MAX_VALUES; j++)
+				field->fvalues[j] = fvalue_new(field->ftype);
+		}
+		g_hash_table_insert(fidx->by_hfid, GINT_TO_POINTER(hfid),
+		    GINT_TO_POINTER(fidx->n_fields + 1));
+		fidx->n_fields++;
+	}
+
+	return fidx;
+}
+
+void
+field_index_free(field_index_t *fidx)
+{
+	indexed_field_t *field;
+	unsigned int i;
+	int j;
+
+	for (i = 0; i < fidx->blocks->len; i++)
+		g_free(g_ptr_array_index(fidx->blocks, i));
+	g_ptr_array_free(fidx->blocks, TRUE);
+
+	for (i = 0; i < (unsigned int)fidx->n_fields; i++) {
+		field = &fidx->fields[i];
+		if (field->kind == IFIELD_RECORDED) {
+			for (j = 0; j < MAX_VALUES; j++)
+				fvalue_free(field->fvalues[j]);
+		}
+	}
+	g_hash_table_destroy(fidx->by_hfid);
+	g_free(fidx);
+}
+
+guint32
+field_index_count(field_index_t *fidx)
+{
+	return fidx->count;
+}
+
+void
+field_index_prime_edt(field_index_t *fidx, epan_dissect_t *edt)
+{
+	int i;
+
+	for (i = 0; i < fidx->n_fields; i++) {
+		if (fidx->fields[i].kind != IFIELD_COMBINED)
+			proto_tree_prime_hfid(edt->tree, fidx->fields[i].hfid);
+	}
+}
+
+static guint32
+get_recordable_value(indexed_field_t *field, fvalue_t *fv)
+{
+	if (field->ftype == FT_IPv4)
+		return ipv4_get_net_order_addr(fvalue_get(fv));
+	else
+		return fvalue_get_integer(fv);
+}
+
+void
+field_index_add_frame(field_index_t *fidx, epan_dissect_t *edt)
+{
+	guint32 record[MAX_RECORD_WORDS];
+	int n_words;
+	indexed_field_t *field;
+	GPtrArray *finfos;
+	field_info *finfo;
+	index_block_t *block;
+	guint n;
+	int i;
+	guint j;
+
+	record[0] = 0;
+	record[1] = 0;
+	n_words = 2;
+	for (i = 0; i < fidx->n_fields; i++) {
+		field = &fidx->fields[i];
+		if (field->kind == IFIELD_COMBINED)
+			continue;
+		finfos = proto_get_finfo_ptr_array(edt->tree, field->hfid);
+		n = (finfos != NULL) ? finfos->len : 0;
+		if (n == 0)
+			continue;
+		if (field->kind == IFIELD_PROTOCOL) {
+			record[0] |= 1U << field->slot;
+			continue;
+		}
+		if (n > MAX_VALUES) {
+			/* We can't record all of them, so we can't use
+			   the index to look at this field. */
+			field->usable = FALSE;
+			continue;
+		}
+		record[1] |= n << (4*field->slot);
+		for (j = 0; j < n; j++) {
+			finfo = g_ptr_array_index(finfos, j);
+			record[n_words++] = get_recordable_value(field,
+			    finfo->value);
+		}
+	}
+
+	if (fidx->blocks->len != 0)
+		block = g_ptr_array_index(fidx->blocks, fidx->blocks->len - 1);
+	else
+		block = NULL;
+	if (block == NULL || block->used + n_words > BLOCK_WORDS) {
+		block = g_malloc(sizeof (index_block_t));
+		block->used = 0;
+		g_ptr_array_add(fidx->blocks, block);
+	}
+	memcpy(&block->words[block->used], record, n_words * sizeof (guint32));
+	block->used += n_words;
+	fidx->count++;
+}
+
+static gboolean
+check_field(int field_id, gboolean needs_values, gpointer user_data)
+{
+	field_index_t *fidx = user_data;
+	indexed_field_t *field;
+	int i;
+
+	i = lookup_field(fidx, field_id);
+	if (i == -1)
+		return FALSE;
+	field = &fidx->fields[i];
+	if (!field->usable)
+		return FALSE;
+	if (field->kind == IFIELD_COMBINED) {
+		if (!fidx->fields[field->parts[0]].usable ||
+		    !fidx->fields[field->parts[1]].usable)
+			return FALSE;
+	}
+
+	/* We only know whether protocols are present, not their
+	   contents. */
+	if (field->kind == IFIELD_PROTOCOL && needs_values)
+		return FALSE;
+	return TRUE;
+}
+
+gboolean
+field_index_can_apply(field_index_t *fidx, dfilter_t *dfcode)
+{
+	return dfilter_check_fields(dfcode, check_field, fidx);
+}
+
+/* Load the current frame's values of a recorded field into its fvalues. */
+static void
+load_recorded_field(field_index_t *fidx, indexed_field_t *field)
+{
+	guint32 counts;
+	guint32 *value;
+	int i;
+
+	counts = fidx->cur_record[1];
+	value = &fidx->cur_record[2];
+	for (i = 0; i < field->slot; i++)
+		value += (counts >> (4*i)) & 0xF;
+	field->n_values = (counts >> (4*field->slot)) & 0xF;
+	for (i = 0; i < field->n_values; i++)
+		fvalue_set_integer(field->fvalues[i], value[i]);
+	field->loaded = TRUE;
+}
+
+static int
+get_field_values(int field_id, fvalue_t ***fvalues, gpointer user_data)
+{
+	field_index_t *fidx = user_data;
+	indexed_field_t *field, *part;
+	int i, j;
+
+	field = &fidx->fields[lookup_field(fidx, field_id)];
+	switch (field->kind) {
+
+	case IFIELD_PROTOCOL:
+		/* Presence is all anybody can ask about. */
+		*fvalues = NULL;
+		return (fidx->cur_record[0] & (1U << field->slot)) ? 1 : 0;
+
+	case IFIELD_RECORDED:
+		if (!field->loaded)
+			load_recorded_field(fidx, field);
+		break;
+
+	case IFIELD_COMBINED:
+		if (!field->loaded) {
+			field->n_values = 0;
+			for (i = 0; i < 2; i++) {
+				part = &fidx->fields[field->parts[i]];
+				if (!part->loaded)
+					load_recorded_field(fidx, part);
+				for (j = 0; j < part->n_values; j++)
+					field->fvalues[field->n_values++] =
+					    part->fvalues[j];
+			}
+			field->loaded = TRUE;
+		}
+		break;
+	}
+	*fvalues = field->fvalues;
+	return field->n_values;
+}
+
+void
+field_index_apply(field_index_t *fidx, dfilter_t *dfcode, guint32 *bits)
+{
+	index_block_t *block;
+	guint32 block_num, offset;
+	guint32 num;
+	guint32 counts;
+	int i;
+
+	block_num = 0;
+	offset = 0;
+	for (num = 1; num <= fidx->count; num++) {
+		block = g_ptr_array_index(fidx->blocks, block_num);
+		if (offset >= block->used) {
+			block_num++;
+			block = g_ptr_array_index(fidx->blocks, block_num);
+			offset = 0;
+		}
+		fidx->cur_record = &block->words[offset];
+		for (i = 0; i < fidx->n_fields; i++)
+			fidx->fields[i].loaded = FALSE;
+
+		if (dfilter_apply_fields(dfcode, get_field_values, fidx))
+			bits[(num - 1) / 32] |= 1U << ((num - 1) % 32);
+
+		/* On to the next frame's record. */
+		counts = fidx->cur_record[1];
+		offset += 2;
+		for (i = 0; i < fidx->n_recorded; i++)
+			offset += (counts >> (4*i)) & 0xF;
+	}
+	fidx->cur_record = NULL;
+}
@@ -0,0 +1,65 @@
+/* field_index.h
+ * Definitions for an index of commonly-filtered-on field values
+ *
+ * $Id$
+ *
+ * Ethereal - Network traffic analyzer
+ * By Gerald Combs <gerald@ethereal.com>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __FIELD_INDEX_H__
+#define __FIELD_INDEX_H__
+
+#include <epan/epan.h>
+
+/*
+ * A field index holds, for every frame in a capture, the values of a
+ * fixed set of commonly-filtered-on fields (IPv4 addresses, TCP and UDP
+ * ports, frame length) and whether a few common protocols are present,
+ * as found when the frame was dissected.  A display filter that refers
+ * only to those fields can then be evaluated against every frame from
+ * the index, without reading or dissecting any frames.
+ *
+ * Frames must be added in the order in which they appear in the packet
+ * list; the results of applying a filter are one bit per frame, in the
+ * same layout as the display filter results kept by "file.c".
+ */
+typedef struct _field_index field_index_t;
+
+field_index_t *field_index_new(void);
+void field_index_free(field_index_t *fidx);
+
+/* Number of frames in the index. */
+guint32 field_index_count(field_index_t *fidx);
+
+/* Prime a protocol tree so that, once the frame has been dissected,
+   "field_index_add_frame()" can find the fields we index. */
+void field_index_prime_edt(field_index_t *fidx, epan_dissect_t *edt);
+
+/* Add the values of the indexed fields in a dissected frame. */
+void field_index_add_frame(field_index_t *fidx, epan_dissect_t *edt);
+
+/* Returns TRUE if the filter refers only to fields we've indexed. */
+gboolean field_index_can_apply(field_index_t *fidx, dfilter_t *dfcode);
+
+/* Apply the filter to every frame in the index, setting bit "num - 1"
+   of "bits" for each frame "num" that passes it. */
+void field_index_apply(field_index_t *fidx, dfilter_t *dfcode,
+    guint32 *bits);
+
+#endif /* field_index.h */
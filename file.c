@@ -90,6 +90,8 @@
 #include <epan/dfilter/dfilter.h>
 #include <epan/conversation.h>
 #include "reassemble.h"
+#include "field_index.h"
+#include "follow.h"
 #include "globals.h"
 #include "gtk/colors.h"
 #include <epan/epan_dissect.h>
@@ -103,13 +105,24 @@ gboolean auto_scroll_live;
 static guint32 firstsec, firstusec;
 static guint32 prevsec, prevusec;
 
-static void read_packet(capture_file *cf, long offset);
+static void read_packet(capture_file *cf, long offset,
+    const struct wtap_pkthdr *phdr, union wtap_pseudo_header *pseudo_header,
+    const u_char *buf);
+static frame_data *alloc_frame(capture_file *cf);
+static const guint8 *read_reassembly_frame(guint32 num, gpointer data);
 
 static void rescan_packets(capture_file *cf, const char *action,
 	gboolean refilter, gboolean redissect);
 
 static void set_selected_row(int row);
 
+static void free_dfilter_results(capture_file *cf);
+static gboolean apply_dfilter_results(capture_file *cf, const gchar *dftext);
+static void add_dfilter_results(capture_file *cf, const gchar *dftext,
+	guint32 *bits);
+static gboolean apply_field_index(capture_file *cf, dfilter_t *dfcode,
+	const gchar *dftext);
+
 static void freeze_clist(capture_file *cf);
 static void thaw_clist(capture_file *cf);
 
@@ -120,10 +133,34 @@ static gboolean copy_binary_file(char *from_filename, char *to_filename);
 /* Update the progress bar this many times when reading a file. */
 #define N_PROGBAR_UPDATES	100
 
-/* Number of "frame_data" structures per memory chunk.
+/* Number of packets to read at a time when reading a file. */
+#define READ_BATCH_PACKETS	256
+
+/* Number of "frame_data" structures per chunk of the packet list.
+   The frames are kept in fixed-size arrays, rather than in a linked
+   list, so that we can find a frame given its number without walking
+   the list, and so that scanning the list touches memory in order.
    XXX - is this the right number? */
 #define	FRAME_DATA_CHUNK_SIZE	1024
 
+/* Number of display filters whose per-frame results we remember. */
+#define	N_DFILTER_RESULTS	8
+
+/* The result of applying a display filter to every frame in the capture,
+   one bit per frame, so that going back to a filter we've already
+   applied doesn't require dissecting the frames that it rejects. */
+typedef struct {
+  gchar   *dftext;	/* text of the display filter */
+  guint32  count;	/* number of frames in the capture when it was applied */
+  guint32 *bits;	/* bit "num - 1" is set iff frame "num" passed */
+} dfilter_results_t;
+
+#define DFRESULT_WORDS(count)	(((count) + 31) / 32)
+#define DFRESULT_TEST(bits, num) \
+	((bits)[((num) - 1) / 32] & (1U << (((num) - 1) % 32)))
+#define DFRESULT_SET(bits, num) \
+	((bits)[((num) - 1) / 32] |= (1U << (((num) - 1) % 32)))
+
 int
 open_cap_file(char *fname, gboolean is_tempfile, capture_file *cf)
 {
@@ -160,6 +197,13 @@ open_cap_file(char *fname, gboolean is_tempfile, capture_file *cf)
      data structures that "reassemble_init()" frees. */
   reassemble_init();
 
+  /* If there's a limit on how much reassembled data to keep in memory,
+     let the reassembly code read frames from the file to make up again
+     data it's freed. */
+  reassemble_set_frame_reader(prefs.gui_reassembly_mem_limit != 0 ?
+      read_reassembly_frame : NULL, cf);
+  reassemble_set_memory_limit(prefs.gui_reassembly_mem_limit * 1024);
+
   /* We're about to start reading the file. */
   cf->state = FILE_READ_IN_PROGRESS;
 
@@ -197,11 +241,16 @@ open_cap_file(char *fname, gboolean is_tempfile, capture_file *cf)
   firstsec = 0, firstusec = 0;
   prevsec = 0, prevusec = 0;
  
-  cf->plist_chunk = g_mem_chunk_new("frame_data_chunk",
-	sizeof(frame_data),
-	FRAME_DATA_CHUNK_SIZE * sizeof(frame_data),
-	G_ALLOC_AND_FREE);
-  g_assert(cf->plist_chunk);
+  cf->plist_chunks = g_ptr_array_new();
+
+  /* If the user wants us to index the commonly-filtered-on fields
+     while we read the file, set up the index. */
+  if (prefs.gui_index_fields)
+    cf->findex = field_index_new();
+
+  /* Index the frames in each TCP connection, so that "Follow TCP Stream"
+     doesn't have to look at every frame. */
+  cf->tcp_index = follow_index_new();
 
   return (0);
 
@@ -215,6 +264,8 @@ fail:
 void
 close_cap_file(capture_file *cf)
 {
+  guint i;
+
   /* Die if we're in the middle of reading a file. */
   g_assert(cf->state != FILE_READ_IN_PROGRESS);
 
@@ -237,16 +288,25 @@ close_cap_file(capture_file *cf)
   /* ...which means we have nothing to save. */
   cf->user_saved = FALSE;
 
-  if (cf->plist_chunk != NULL) {
-    g_mem_chunk_destroy(cf->plist_chunk);
-    cf->plist_chunk = NULL;
+  if (cf->plist_chunks != NULL) {
+    for (i = 0; i < cf->plist_chunks->len; i++)
+      g_free(g_ptr_array_index(cf->plist_chunks, i));
+    g_ptr_array_free(cf->plist_chunks, TRUE);
+    cf->plist_chunks = NULL;
   }
   if (cf->rfcode != NULL) {
     dfilter_free(cf->rfcode);
     cf->rfcode = NULL;
   }
-  cf->plist = NULL;
-  cf->plist_end = NULL;
+  free_dfilter_results(cf);
+  if (cf->findex != NULL) {
+    field_index_free(cf->findex);
+    cf->findex = NULL;
+  }
+  if (cf->tcp_index != NULL) {
+    follow_index_free(cf->tcp_index);
+    cf->tcp_index = NULL;
+  }
   unselect_packet(cf);	/* nothing to select */
   cf->first_displayed = NULL;
   cf->last_displayed = NULL;
@@ -331,6 +391,8 @@ read_cap_file(capture_file *cf, int *err)
   gboolean  stop_flag;
   int       file_pos;
   float     prog_val;
+  struct wtap_batch *batch;
+  int       i;
 
   name_ptr = get_basename(cf->filename);
 
@@ -355,31 +417,43 @@ read_cap_file(capture_file *cf, int *err)
   progbar = create_progress_dlg(load_msg, "Stop", &stop_flag);
   g_free(load_msg);
 
-  while ((wtap_read(cf->wth, err, &data_offset))) {
-    /* Update the progress bar, but do it only N_PROGBAR_UPDATES times;
-       when we update it, we have to run the GTK+ main loop to get it
-       to repaint what's pending, and doing so may involve an "ioctl()"
-       to see if there's any pending input from an X server, and doing
-       that for every packet can be costly, especially on a big file. */
-    if (data_offset >= cf->progbar_nextstep) {
-        file_pos = lseek(cf->filed, 0, SEEK_CUR);
-        prog_val = (gfloat) file_pos / (gfloat) cf->f_len;
-        update_progress_dlg(progbar, prog_val);
-        cf->progbar_nextstep += cf->progbar_quantum;
-    }
+  /* Read the packets a batch at a time, so that the OS can be reading
+     in the next batch while we dissect this one. */
+  batch = wtap_batch_new(READ_BATCH_PACKETS);
+  while ((wtap_read_batch(cf->wth, batch, err))) {
+    for (i = 0; i < batch->count; i++) {
+      data_offset = batch->data_offsets[i];
 
-    if (stop_flag) {
-      /* Well, the user decided to abort the read.  Destroy the progress
-         bar, close the capture file, and return READ_ABORTED so our caller
-	 can do whatever is appropriate when that happens. */
-      destroy_progress_dlg(progbar);
-      cf->state = FILE_READ_ABORTED;	/* so that we're allowed to close it */
-      gtk_clist_thaw(GTK_CLIST(packet_list));	/* undo our freeze */
-      close_cap_file(cf);
-      return (READ_ABORTED);
+      /* Update the progress bar, but do it only N_PROGBAR_UPDATES times;
+         when we update it, we have to run the GTK+ main loop to get it
+         to repaint what's pending, and doing so may involve an "ioctl()"
+         to see if there's any pending input from an X server, and doing
+         that for every packet can be costly, especially on a big file. */
+      if (data_offset >= cf->progbar_nextstep) {
+          file_pos = lseek(cf->filed, 0, SEEK_CUR);
+          prog_val = (gfloat) file_pos / (gfloat) cf->f_len;
+          update_progress_dlg(progbar, prog_val);
+          cf->progbar_nextstep += cf->progbar_quantum;
+      }
+
+      if (stop_flag) {
+        /* Well, the user decided to abort the read.  Destroy the progress
+           bar, close the capture file, and return READ_ABORTED so our caller
+           can do whatever is appropriate when that happens. */
+        wtap_batch_free(batch);
+        destroy_progress_dlg(progbar);
+        cf->state = FILE_READ_ABORTED;	/* so that we're allowed to close it */
+        gtk_clist_thaw(GTK_CLIST(packet_list));	/* undo our freeze */
+        close_cap_file(cf);
+        return (READ_ABORTED);
+      }
+      read_packet(cf, data_offset, &batch->phdrs[i],
+                  &batch->pseudo_headers[i], batch->data[i]);
     }
-    read_packet(cf, data_offset);
+    if (*err != 0)
+      break;
   }
+  wtap_batch_free(batch);
 
   /* We're done reading the file; destroy the progress bar. */
   destroy_progress_dlg(progbar);
@@ -504,7 +578,8 @@ continue_tail_cap_file(capture_file *cf, int to_read, int *err)
 	 aren't any packets left to read) exit. */
       break;
     }
-    read_packet(cf, data_offset);
+    read_packet(cf, data_offset, wtap_phdr(cf->wth),
+                wtap_pseudoheader(cf->wth), wtap_buf_ptr(cf->wth));
     to_read--;
   }
 
@@ -512,7 +587,7 @@ continue_tail_cap_file(capture_file *cf, int to_read, int *err)
 
   /* XXX - this cheats and looks inside the packet list to find the final
      row number. */
-  if (auto_scroll_live && cf->plist_end != NULL)
+  if (auto_scroll_live && cf->count != 0)
     gtk_clist_moveto(GTK_CLIST(packet_list), 
 		       GTK_CLIST(packet_list)->rows - 1, -1, 1.0, 1.0);
 
@@ -531,6 +606,52 @@ continue_tail_cap_file(capture_file *cf, int to_read, int *err)
     return (READ_SUCCESS);
 }
 
+/* Process packets that the capture child put into a live feed ring,
+   rather than reading them from the capture file, until we've processed
+   "*to_read" packets or run out of packets in the ring; "*to_read" is
+   decremented for each packet processed, and "*next_off" is set to the
+   offset in the capture file just past the last packet processed. */
+read_status_t
+continue_tail_cap_file_from_ring(capture_file *cf, capture_ring_t *ring,
+    int *to_read, long *next_off)
+{
+  struct wtap_pkthdr phdr;
+  union wtap_pseudo_header pseudo_header;
+  const u_char *pd;
+  long file_off;
+
+  /* Packets captured live have no pseudo-header. */
+  memset(&pseudo_header, 0, sizeof pseudo_header);
+
+  gtk_clist_freeze(GTK_CLIST(packet_list));
+
+  while (*to_read != 0 &&
+         (pd = capture_ring_get(ring, &phdr, &file_off)) != NULL) {
+    if (cf->state == FILE_READ_ABORTED) {
+      /* Well, the user decided to exit Ethereal; see
+         "continue_tail_cap_file()". */
+      break;
+    }
+    read_packet(cf, file_off, &phdr, &pseudo_header, pd);
+    *next_off = file_off + phdr.caplen;
+    capture_ring_release(ring);
+    (*to_read)--;
+  }
+
+  gtk_clist_thaw(GTK_CLIST(packet_list));
+
+  /* XXX - this cheats and looks inside the packet list to find the final
+     row number. */
+  if (auto_scroll_live && cf->count != 0)
+    gtk_clist_moveto(GTK_CLIST(packet_list), 
+		       GTK_CLIST(packet_list)->rows - 1, -1, 1.0, 1.0);
+
+  if (cf->state == FILE_READ_ABORTED)
+    return READ_ABORTED;
+  else
+    return READ_SUCCESS;
+}
+
 read_status_t
 finish_tail_cap_file(capture_file *cf, int *err)
 {
@@ -538,6 +659,7 @@ finish_tail_cap_file(capture_file *cf, int *err)
 
   gtk_clist_freeze(GTK_CLIST(packet_list));
 
+  *err = 0;
   while ((wtap_read(cf->wth, err, &data_offset))) {
     if (cf->state == FILE_READ_ABORTED) {
       /* Well, the user decided to abort the read.  Break out of the
@@ -545,7 +667,8 @@ finish_tail_cap_file(capture_file *cf, int *err)
 	 aren't any packets left to read) exit. */
       break;
     }
-    read_packet(cf, data_offset);
+    read_packet(cf, data_offset, wtap_phdr(cf->wth),
+                wtap_pseudoheader(cf->wth), wtap_buf_ptr(cf->wth));
   }
 
   if (cf->state == FILE_READ_ABORTED) {
@@ -559,7 +682,7 @@ finish_tail_cap_file(capture_file *cf, int *err)
   }
 
   thaw_clist(cf);
-  if (auto_scroll_live && cf->plist_end != NULL)
+  if (auto_scroll_live && cf->count != 0)
     /* XXX - this cheats and looks inside the packet list to find the final
        row number. */
     gtk_clist_moveto(GTK_CLIST(packet_list), 
@@ -605,41 +728,88 @@ finish_tail_cap_file(capture_file *cf, int *err)
 }
 #endif /* HAVE_LIBPCAP */
 
-typedef struct {
-  color_filter_t *colorf;
-  epan_dissect_t *edt;
-} apply_color_filter_args;
-
-/*
- * If no color filter has been applied, apply this one.
- * (The "if no color filter has been applied" is to handle the case where
- * more than one color filter matches the packet.)
- */
-static void
-apply_color_filter(gpointer filter_arg, gpointer argp)
+/* Add a row for a frame that passed the display filter to the end of
+   the packet list, and return its row number. */
+static gint
+append_packet_list_row(frame_data *fdata, capture_file *cf)
 {
-  color_filter_t *colorf = filter_arg;
-  apply_color_filter_args *args = argp;
+  static gchar **empty_row;
+  static gint   empty_row_cols;
+  gint          row;
+
+  /* If we don't have the time stamp of the previous displayed packet,
+     it's because this is the first displayed packet.  Save the time
+     stamp of this packet as the time stamp of the previous displayed
+     packet. */
+  if (!prevsec && !prevusec) {
+    prevsec  = fdata->abs_secs;
+    prevusec = fdata->abs_usecs;
+  }
+
+  /* Get the time elapsed between the first packet and this packet. */
+  compute_timestamp_diff(&fdata->rel_secs, &fdata->rel_usecs,
+		fdata->abs_secs, fdata->abs_usecs, firstsec, firstusec);
+
+  /* If it's greater than the current elapsed time, set the elapsed time
+     to it (we check for "greater than" so as not to be confused by
+     time moving backwards). */
+  if ((gint32)cf->esec < fdata->rel_secs
+	|| ((gint32)cf->esec == fdata->rel_secs && (gint32)cf->eusec < fdata->rel_usecs)) {
+    cf->esec = fdata->rel_secs;
+    cf->eusec = fdata->rel_usecs;
+  }
 
-  if (colorf->c_colorfilter != NULL && args->colorf == NULL) {
-    if (dfilter_apply_edt(colorf->c_colorfilter, args->edt))
-      args->colorf = colorf;
+  /* Get the time elapsed between the previous displayed packet and
+     this packet. */
+  compute_timestamp_diff(&fdata->del_secs, &fdata->del_usecs,
+		fdata->abs_secs, fdata->abs_usecs, prevsec, prevusec);
+  prevsec = fdata->abs_secs;
+  prevusec = fdata->abs_usecs;
+
+  /* If we haven't yet seen the first frame, this is it.
+
+     XXX - we must do this before we add the row to the display,
+     as, if the display's GtkCList's selection mode is
+     GTK_SELECTION_BROWSE, when the first entry is added to it,
+     "select_packet()" will be called, and it will fetch the row
+     data for the 0th row, and will get a null pointer rather than
+     "fdata", as "gtk_clist_append()" won't yet have returned and
+     thus "gtk_clist_set_row_data()" won't yet have been called.
+
+     We thus need to leave behind bread crumbs so that
+     "select_packet()" can find this frame.  See the comment
+     in "select_packet()". */
+  if (cf->first_displayed == NULL)
+    cf->first_displayed = fdata;
+
+  /* This is the last frame we've seen so far. */
+  cf->last_displayed = fdata;
+
+  if (empty_row_cols < cf->cinfo.num_cols) {
+    g_free(empty_row);
+    empty_row = g_new0(gchar *, cf->cinfo.num_cols);
+    empty_row_cols = cf->cinfo.num_cols;
   }
+  row = gtk_clist_append(GTK_CLIST(packet_list), empty_row);
+  gtk_clist_set_row_data(GTK_CLIST(packet_list), row, fdata);
+  return row;
 }
 
+/* Dissect a frame, apply the display filter to it if "refilter" is
+   TRUE, and, if it passes, add it to the packet list.  If "findex"
+   isn't null, add the frame's values of the indexed fields to it; if
+   "tcp_index" isn't null, add the frame to it.
+
+   The row is added empty; its columns and colors are filled in by
+   "fill_packet_list_row()" when it's first drawn. */
 static int
 add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
 	union wtap_pseudo_header *pseudo_header, const u_char *buf,
-	gboolean refilter)
+	gboolean refilter, field_index_t *findex, follow_index_t *tcp_index)
 {
-  apply_color_filter_args args;
-  gint          i, row;
+  gint          row;
   gboolean	create_proto_tree = FALSE;
   epan_dissect_t *edt;
-  GdkColor      fg, bg;
-
-  /* We don't yet have a color filter to apply. */
-  args.colorf = NULL;
 
   /* If we don't have the time stamp of the first packet in the
      capture, it's because this is the first packet.  Save the time
@@ -649,28 +819,28 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
     firstusec = fdata->abs_usecs;
   }
 
-  /* If either
-
-	we have a display filter and are re-applying it;
-
-	we have a list of color filters;
-
-     allocate a protocol tree root node, so that we'll construct
-     a protocol tree against which a filter expression can be
-     evaluated. */
-  if ((cf->dfcode != NULL && refilter) || filter_list != NULL)
+  /* If we have a display filter and are re-applying it, or are
+     indexing the frame's fields, allocate a protocol tree root node,
+     so that we'll construct a protocol tree against which a filter
+     expression can be evaluated. */
+  if ((cf->dfcode != NULL && refilter) || findex != NULL)
 	  create_proto_tree = TRUE;
 
-  /* Dissect the frame. */
+  /* Dissect the frame.  We don't need the columns yet. */
   edt = epan_dissect_new(create_proto_tree, FALSE);
 
-  if (cf->dfcode) {
+  if (cf->dfcode != NULL && refilter) {
       epan_dissect_prime_dfilter(edt, cf->dfcode);
   }
-  if (filter_list) {
-      filter_list_prime_edt(edt);
+  if (findex != NULL) {
+      field_index_prime_edt(findex, edt);
   }
-  epan_dissect_run(edt, pseudo_header, buf, fdata, &cf->cinfo);
+  epan_dissect_run(edt, pseudo_header, buf, fdata, NULL);
+
+  if (findex != NULL)
+    field_index_add_frame(findex, edt);
+  if (tcp_index != NULL)
+    follow_index_add_frame(tcp_index, &edt->pi, fdata->num);
 
 
   /* If we have a display filter, apply it if we're refiltering, otherwise
@@ -687,109 +857,99 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
   } else
     fdata->flags.passed_dfilter = 1;
 
-  /* If we have color filters, and the frame is to be displayed, apply
-     the color filters. */
-  if (fdata->flags.passed_dfilter) {
-    if (filter_list != NULL) {
-      args.edt = edt;
-      g_slist_foreach(filter_list, apply_color_filter, &args);
-    }
-  }
-
+  /* We're done with the dissection; free it before adding the row, as
+     adding the row may draw it, which dissects the frame again. */
+  epan_dissect_free(edt);
 
   if (fdata->flags.passed_dfilter) {
     /* This frame passed the display filter, so add it to the clist. */
+    row = append_packet_list_row(fdata, cf);
+  } else {
+    /* This frame didn't pass the display filter, so it's not being added
+       to the clist, and thus has no row. */
+    row = -1;
+  }
+  return row;
+}
 
-    /* If we don't have the time stamp of the previous displayed packet,
-       it's because this is the first displayed packet.  Save the time
-       stamp of this packet as the time stamp of the previous displayed
-       packet. */
-    if (!prevsec && !prevusec) {
-      prevsec  = fdata->abs_secs;
-      prevusec = fdata->abs_usecs;
-    }
-
-    /* Get the time elapsed between the first packet and this packet. */
-    compute_timestamp_diff(&fdata->rel_secs, &fdata->rel_usecs,
-		fdata->abs_secs, fdata->abs_usecs, firstsec, firstusec);
-
-    /* If it's greater than the current elapsed time, set the elapsed time
-       to it (we check for "greater than" so as not to be confused by
-       time moving backwards). */
-    if ((gint32)cf->esec < fdata->rel_secs
-	|| ((gint32)cf->esec == fdata->rel_secs && (gint32)cf->eusec < fdata->rel_usecs)) {
-      cf->esec = fdata->rel_secs;
-      cf->eusec = fdata->rel_usecs;
-    }
-  
-    /* Get the time elapsed between the previous displayed packet and
-       this packet. */
-    compute_timestamp_diff(&fdata->del_secs, &fdata->del_usecs,
-		fdata->abs_secs, fdata->abs_usecs, prevsec, prevusec);
-    prevsec = fdata->abs_secs;
-    prevusec = fdata->abs_usecs;
-
-    epan_dissect_fill_in_columns(edt);
-
-    /* If we haven't yet seen the first frame, this is it.
-
-       XXX - we must do this before we add the row to the display,
-       as, if the display's GtkCList's selection mode is
-       GTK_SELECTION_BROWSE, when the first entry is added to it,
-       "select_packet()" will be called, and it will fetch the row
-       data for the 0th row, and will get a null pointer rather than
-       "fdata", as "gtk_clist_append()" won't yet have returned and
-       thus "gtk_clist_set_row_data()" won't yet have been called.
-
-       We thus need to leave behind bread crumbs so that
-       "select_packet()" can find this frame.  See the comment
-       in "select_packet()". */
-    if (cf->first_displayed == NULL)
-      cf->first_displayed = fdata;
+/* Fill in the columns and colors of a row of the packet list, by
+   reading and dissecting its frame again.
 
-    /* This is the last frame we've seen so far. */
-    cf->last_displayed = fdata;
+   We read the frame into a buffer of our own, not into "cf->pd", as
+   that holds the data for the selected frame, which the protocol tree
+   and hex dump panes still refer to. */
+static void
+fill_packet_list_row(GtkCList *clist, GtkCListRow *clist_row, gpointer data)
+{
+  static guint8 pd[WTAP_MAX_PACKET_SIZE];
+  capture_file *cf = data;
+  frame_data   *fdata = clist_row->data;
+  union wtap_pseudo_header pseudo_header;
+  const guint8 *buf;
+  color_filter_t *colorf;
+  epan_dissect_t *edt;
+  GdkColor      fg, bg;
 
-    row = gtk_clist_append(GTK_CLIST(packet_list), cf->cinfo.col_data);
-    gtk_clist_set_row_data(GTK_CLIST(packet_list), row, fdata);
+  /* The row may be drawn before "gtk_clist_set_row_data()" has been
+     called for it; "gtk_clist_set_row_data()" will draw it again. */
+  if (fdata == NULL || cf->wth == NULL)
+    return;
 
-    if (fdata->flags.marked) {
-	color_t_to_gdkcolor(&bg, &prefs.gui_marked_bg);
-	color_t_to_gdkcolor(&fg, &prefs.gui_marked_fg);
-    } else if (filter_list != NULL && (args.colorf != NULL)) {
-	bg = args.colorf->bg_color;
-	fg = args.colorf->fg_color;
-    } else {
-	bg = WHITE;
-	fg = BLACK;
-    }
-    gtk_clist_set_background(GTK_CLIST(packet_list), row, &bg);
-    gtk_clist_set_foreground(GTK_CLIST(packet_list), row, &fg);
+  buf = wtap_seek_read_data(cf->wth, fdata->file_off, &pseudo_header, pd,
+      fdata->cap_len);
+
+  /* If we have a list of color filters, allocate a protocol tree root
+     node, so that we'll construct a protocol tree against which they
+     can be evaluated. */
+  edt = epan_dissect_new(filter_list != NULL, FALSE);
+  if (filter_list != NULL)
+    filter_list_prime_edt(edt);
+  epan_dissect_run(edt, &pseudo_header, buf, fdata, &cf->cinfo);
+  epan_dissect_fill_in_columns(edt);
+
+  /* The color filters are all tested in one run of the filter VM,
+     which stops at the first one that matches. */
+  colorf = NULL;
+  if (filter_list != NULL)
+    colorf = color_filters_first_match(edt);
+
+  if (fdata->flags.marked) {
+    color_t_to_gdkcolor(&bg, &prefs.gui_marked_bg);
+    color_t_to_gdkcolor(&fg, &prefs.gui_marked_fg);
+  } else if (colorf != NULL) {
+    bg = colorf->bg_color;
+    fg = colorf->fg_color;
   } else {
-    /* This frame didn't pass the display filter, so it's not being added
-       to the clist, and thus has no row. */
-    row = -1;
+    bg = WHITE;
+    fg = BLACK;
   }
+  gtk_clist_set_row_contents(clist, clist_row, cf->cinfo.col_data, &fg, &bg);
+
   epan_dissect_free(edt);
-  return row;
+}
+
+/* Have the packet list fill in its rows from the capture file "cf". */
+void
+set_packet_list_fill_func(capture_file *cf)
+{
+  gtk_clist_set_fill_row_func(GTK_CLIST(packet_list), fill_packet_list_row,
+      cf, PACKET_LIST_FILLED_ROWS);
 }
 
 static void
-read_packet(capture_file *cf, long offset)
+read_packet(capture_file *cf, long offset, const struct wtap_pkthdr *phdr,
+    union wtap_pseudo_header *pseudo_header, const u_char *buf)
 {
-  const struct wtap_pkthdr *phdr = wtap_phdr(cf->wth);
-  union wtap_pseudo_header *pseudo_header = wtap_pseudoheader(cf->wth);
-  const u_char *buf = wtap_buf_ptr(cf->wth);
   frame_data   *fdata;
   int           passed;
-  frame_data   *plist_end;
   epan_dissect_t *edt;
 
-  /* Allocate the next list entry, and add it to the list. */
-  fdata = g_mem_chunk_alloc(cf->plist_chunk);
+  /* Fill in the next slot in the packet list; it doesn't become part
+     of the list until we bump the frame count, so if the frame doesn't
+     pass the read filter, the slot will just be reused by the next
+     frame. */
+  fdata = alloc_frame(cf);
 
-  fdata->next = NULL;
-  fdata->prev = NULL;
   fdata->pfd  = NULL;
   fdata->data_src  = NULL;
   fdata->pkt_len  = phdr->len;
@@ -811,30 +971,56 @@ read_packet(capture_file *cf, long offset)
     epan_dissect_free(edt);
   }   
   if (passed) {
-    plist_end = cf->plist_end;
-    fdata->prev = plist_end;
-    if (plist_end != NULL)
-      plist_end->next = fdata;
-    else
-      cf->plist = fdata;
-    cf->plist_end = fdata;
-
     cf->count++;
     fdata->num = cf->count;
-    add_packet_to_packet_list(fdata, cf, pseudo_header, buf, TRUE);
-  } else {
-    /* XXX - if we didn't have read filters, or if we could avoid
-       allocating the "frame_data" structure until we knew whether
-       the frame passed the read filter, we could use a G_ALLOC_ONLY
-       memory chunk...
-
-       ...but, at least in one test I did, where I just made the chunk
-       a G_ALLOC_ONLY chunk and read in a huge capture file, it didn't
-       seem to save a noticeable amount of time or space. */
-    g_mem_chunk_free(cf->plist_chunk, fdata);
+    add_packet_to_packet_list(fdata, cf, pseudo_header, buf, TRUE,
+                              cf->findex, cf->tcp_index);
   }
 }
 
+/* Return a pointer to the slot in the packet list for the frame after
+   the last frame in the list, allocating another chunk if necessary. */
+static frame_data *
+alloc_frame(capture_file *cf)
+{
+  guint32 slot = cf->count;
+
+  if (slot / FRAME_DATA_CHUNK_SIZE >= cf->plist_chunks->len) {
+    g_ptr_array_add(cf->plist_chunks,
+	g_new(frame_data, FRAME_DATA_CHUNK_SIZE));
+  }
+  return &((frame_data *)g_ptr_array_index(cf->plist_chunks,
+	slot / FRAME_DATA_CHUNK_SIZE))[slot % FRAME_DATA_CHUNK_SIZE];
+}
+
+frame_data *
+cf_get_frame(capture_file *cf, guint32 num)
+{
+  if (num == 0 || num > (guint32)cf->count)
+    return NULL;
+  num--;
+  return &((frame_data *)g_ptr_array_index(cf->plist_chunks,
+	num / FRAME_DATA_CHUNK_SIZE))[num % FRAME_DATA_CHUNK_SIZE];
+}
+
+/* Read the raw data for a frame, for the reassembly code. */
+static const guint8 *
+read_reassembly_frame(guint32 num, gpointer data)
+{
+  static guint8 pd[WTAP_MAX_PACKET_SIZE];
+  capture_file *cf = data;
+  union wtap_pseudo_header pseudo_header;
+  frame_data *fdata;
+
+  if (cf->wth == NULL)
+    return NULL;
+  fdata = cf_get_frame(cf, num);
+  if (fdata == NULL)
+    return NULL;
+  return wtap_seek_read_data(cf->wth, fdata->file_off, &pseudo_header, pd,
+      fdata->cap_len);
+}
+
 int
 filter_packets(capture_file *cf, gchar *dftext)
 {
@@ -870,15 +1056,191 @@ filter_packets(capture_file *cf, gchar *dftext)
   cf->dfcode = dfcode;
 
   /* Now rescan the packet list, applying the new filter, but not
-     throwing away information constructed on a previous pass. */
-  rescan_packets(cf, "Filtering", TRUE, FALSE);
+     throwing away information constructed on a previous pass.
+
+     If we've applied this filter before, and nothing has changed since
+     then, we already know which frames pass it, so we don't have to
+     re-evaluate it, or even dissect the frames that don't pass it. */
+  if (dftext != NULL && (apply_dfilter_results(cf, dftext) ||
+                         apply_field_index(cf, dfcode, dftext)))
+    rescan_packets(cf, "Filtering", FALSE, FALSE);
+  else
+    rescan_packets(cf, "Filtering", TRUE, FALSE);
   return 1;
 }
 
+/* Filter the packets with "dftext", a filter from "build_follow_filter()"
+   for the TCP stream to which the packet dissected into "pi" belongs,
+   while the TCP dissector hands the stream's data to "follow_data".
+
+   If we have an index of the frames in each TCP connection, we get the
+   stream's data by dissecting only the frames in the stream's connection,
+   and then filter with "follow_data" cleared, so that the data isn't
+   handed over twice.  The index's frames are used only for that, not to
+   filter; frames with more than one IP header can match the filter but
+   not be in the index, so the filter is applied as usual. */
+int
+filter_tcp_stream_packets(capture_file *cf, gchar *dftext, packet_info *pi)
+{
+  static guint8 pd[WTAP_MAX_PACKET_SIZE];
+  union wtap_pseudo_header pseudo_header;
+  guint32 *bits;
+  guint32 framenum;
+  frame_data *fdata;
+  const guint8 *buf;
+  epan_dissect_t *edt;
+  GByteArray *data;
+  int ret;
+
+  if (follow_data == NULL || cf->tcp_index == NULL || cf->count == 0 ||
+      follow_index_count(cf->tcp_index) != (guint32)cf->count)
+    return filter_packets(cf, dftext);
+
+  bits = g_malloc0(DFRESULT_WORDS(cf->count) * sizeof (guint32));
+  if (!follow_index_get_frames(cf->tcp_index, pi, bits)) {
+    g_free(bits);
+    return filter_packets(cf, dftext);
+  }
+
+  /* Dissect the stream's frames, in order, so the TCP dissector can
+     reassemble the stream; we read them into a buffer of our own, as
+     "cf->pd" holds the selected frame's data. */
+  for (framenum = 1; (fdata = cf_get_frame(cf, framenum)) != NULL;
+       framenum++) {
+    if (!DFRESULT_TEST(bits, framenum))
+      continue;
+    buf = wtap_seek_read_data(cf->wth, fdata->file_off, &pseudo_header, pd,
+	fdata->cap_len);
+    edt = epan_dissect_new(FALSE, FALSE);
+    epan_dissect_run(edt, &pseudo_header, buf, fdata, NULL);
+    epan_dissect_free(edt);
+  }
+  g_free(bits);
+
+  data = follow_data;
+  follow_data = NULL;
+  ret = filter_packets(cf, dftext);
+  follow_data = data;
+  return ret;
+}
+
+/* If the display filter refers only to fields in the field index, work
+   out which frames pass it from the index, without dissecting any frames,
+   and set their "passed_dfilter" flags; return TRUE if we could do that,
+   FALSE otherwise. */
+static gboolean
+apply_field_index(capture_file *cf, dfilter_t *dfcode, const gchar *dftext)
+{
+  guint32 *bits;
+
+  if (cf->findex == NULL || dfcode == NULL || cf->count == 0)
+    return FALSE;
+  if (field_index_count(cf->findex) != (guint32)cf->count)
+    return FALSE;	/* the index doesn't cover every frame */
+  if (!field_index_can_apply(cf->findex, dfcode))
+    return FALSE;
+
+  bits = g_malloc0(DFRESULT_WORDS(cf->count) * sizeof (guint32));
+  field_index_apply(cf->findex, dfcode, bits);
+  add_dfilter_results(cf, dftext, bits);
+  return apply_dfilter_results(cf, dftext);
+}
+
+static void
+free_dfilter_result(dfilter_results_t *dfr)
+{
+  g_free(dfr->dftext);
+  g_free(dfr->bits);
+  g_free(dfr);
+}
+
+/* Discard the remembered results of all display filters. */
+static void
+free_dfilter_results(capture_file *cf)
+{
+  GSList *entry;
+
+  for (entry = cf->dfresults; entry != NULL; entry = g_slist_next(entry))
+    free_dfilter_result(entry->data);
+  g_slist_free(cf->dfresults);
+  cf->dfresults = NULL;
+}
+
+/* If we have the results of a previous application of the display filter
+   with the text "dftext" to all the frames in the capture, set the
+   "passed_dfilter" flags of the frames from them, and return TRUE;
+   otherwise, return FALSE. */
+static gboolean
+apply_dfilter_results(capture_file *cf, const gchar *dftext)
+{
+  GSList *entry;
+  dfilter_results_t *dfr;
+  guint32 framenum;
+  frame_data *fdata;
+
+  for (entry = cf->dfresults; entry != NULL; entry = g_slist_next(entry)) {
+    dfr = entry->data;
+    if (strcmp(dfr->dftext, dftext) == 0)
+      break;
+  }
+  if (entry == NULL)
+    return FALSE;
+
+  if (dfr->count != (guint32)cf->count) {
+    /* Frames have been added since we applied the filter (we're doing
+       a live capture); the results are incomplete, so throw them away. */
+    cf->dfresults = g_slist_remove(cf->dfresults, dfr);
+    free_dfilter_result(dfr);
+    return FALSE;
+  }
+
+  for (framenum = 1; (fdata = cf_get_frame(cf, framenum)) != NULL;
+       framenum++)
+    fdata->flags.passed_dfilter = DFRESULT_TEST(dfr->bits, fdata->num) ? 1 : 0;
+
+  /* This is now the most recently used filter. */
+  cf->dfresults = g_slist_remove_link(cf->dfresults, entry);
+  cf->dfresults = g_slist_concat(entry, cf->dfresults);
+  return TRUE;
+}
+
+/* Remember the results of applying the display filter with the text
+   "dftext" to all the frames in the capture; we take ownership of
+   "bits". */
+static void
+add_dfilter_results(capture_file *cf, const gchar *dftext, guint32 *bits)
+{
+  GSList *entry;
+  dfilter_results_t *dfr;
+
+  /* Get rid of any stale results for the same filter and, if we've
+     got as many sets of results as we're willing to keep, of the
+     least recently used set. */
+  for (entry = cf->dfresults; entry != NULL; entry = g_slist_next(entry)) {
+    dfr = entry->data;
+    if (strcmp(dfr->dftext, dftext) == 0)
+      break;
+  }
+  if (entry == NULL && g_slist_length(cf->dfresults) >= N_DFILTER_RESULTS)
+    entry = g_slist_last(cf->dfresults);
+  if (entry != NULL) {
+    dfr = entry->data;
+    cf->dfresults = g_slist_remove(cf->dfresults, dfr);
+    free_dfilter_result(dfr);
+  }
+
+  dfr = g_malloc(sizeof (dfilter_results_t));
+  dfr->dftext = g_strdup(dftext);
+  dfr->count = cf->count;
+  dfr->bits = bits;
+  cf->dfresults = g_slist_prepend(cf->dfresults, dfr);
+}
+
 void
 colorize_packets(capture_file *cf)
 {
-  rescan_packets(cf, "Colorizing", FALSE, FALSE);
+  /* The colors are chosen when a row is filled in. */
+  gtk_clist_unfill_rows(GTK_CLIST(packet_list));
 }
 
 void
@@ -887,6 +1249,14 @@ redissect_packets(capture_file *cf)
   rescan_packets(cf, "Reprocessing", TRUE, TRUE);
 }
 
+/* Redisplay the packet list with names for addresses that have been
+   resolved since its rows were filled in. */
+void
+update_packet_names(capture_file *cf)
+{
+  gtk_clist_unfill_rows(GTK_CLIST(packet_list));
+}
+
 /* Rescan the list of packets, reconstructing the CList.
 
    "action" describes why we're doing this; it's used in the progress
@@ -902,6 +1272,7 @@ static void
 rescan_packets(capture_file *cf, const char *action, gboolean refilter,
 		gboolean redissect)
 {
+  guint32 framenum;
   frame_data *fdata;
   progdlg_t *progbar;
   gboolean stop_flag;
@@ -911,6 +1282,11 @@ rescan_packets(capture_file *cf, const char *action, gboolean refilter,
   frame_data *selected_frame;
   int selected_row;
   int row;
+  guint32 *dfresult_bits;
+  field_index_t *findex;
+  follow_index_t *tcp_index;
+  const guint8 *pd;
+  gboolean dissect_frames;
 
   /* Which frame, if any, is the currently selected frame?
      XXX - should the selected frame or the focus frame be the "current"
@@ -939,8 +1315,46 @@ rescan_packets(capture_file *cf, const char *action, gboolean refilter,
        may free up space for fragments, which it finds by using the
        data structures that "reassemble_init()" frees. */
     reassemble_init();
+
+    /* The dissectors might now build different protocol trees from the
+       ones against which we evaluated the display filters whose results
+       we've remembered, or from which we built the field index, so those
+       results, and the index, might be wrong.  Rebuild the index as we
+       redissect the frames. */
+    free_dfilter_results(cf);
+    if (cf->findex != NULL) {
+      field_index_free(cf->findex);
+      cf->findex = field_index_new();
+    }
+    findex = cf->findex;
+    if (cf->tcp_index != NULL) {
+      follow_index_free(cf->tcp_index);
+      cf->tcp_index = follow_index_new();
+    }
+    tcp_index = cf->tcp_index;
+  } else {
+    findex = NULL;
+    tcp_index = NULL;
   }
 
+  /* If we're applying a display filter to all the frames, remember
+     which frames pass it, so that if the user goes back to this filter
+     later, we don't have to evaluate it again. */
+  if (refilter && cf->dfcode != NULL && cf->dfilter != NULL && cf->count > 0)
+    dfresult_bits = g_malloc0(DFRESULT_WORDS(cf->count) * sizeof (guint32));
+  else
+    dfresult_bits = NULL;
+
+  /* If we're not rebuilding the dissectors' state, and there's no
+     display filter to evaluate - either we're clearing the filter, so
+     every frame passes, or we already know which frames pass it - we
+     don't need to dissect the frames that pass, as their rows' columns
+     and colors are filled in when they're drawn.  We do if something's
+     collecting data from the dissectors as the frames are dissected,
+     as "Follow TCP Stream" does with "follow_data". */
+  dissect_frames = redissect || (refilter && cf->dfcode != NULL) ||
+      follow_data != NULL;
+
   /* Freeze the packet list while we redo it, so we don't get any
      screen updates while it happens. */
   gtk_clist_freeze(GTK_CLIST(packet_list));
@@ -960,6 +1374,16 @@ rescan_packets(capture_file *cf, const char *action, gboolean refilter,
   prevsec = 0;
   prevusec = 0;
 
+  /* The relative time stamps are relative to the first frame in the
+     capture, not to the first frame we dissect; as we may skip frames
+     below, get that time stamp from the frame list rather than leaving
+     it to "add_packet_to_packet_list()". */
+  if (cf->count != 0) {
+    fdata = cf_get_frame(cf, 1);
+    firstsec  = fdata->abs_secs;
+    firstusec = fdata->abs_usecs;
+  }
+
   /* Update the progress bar when it gets to this value. */
   progbar_nextstep = 0;
   /* When we reach the value that triggers a progress bar update,
@@ -971,7 +1395,8 @@ rescan_packets(capture_file *cf, const char *action, gboolean refilter,
   stop_flag = FALSE;
   progbar = create_progress_dlg(action, "Stop", &stop_flag);
 
-  for (fdata = cf->plist; fdata != NULL; fdata = fdata->next) {
+  for (framenum = 1; (fdata = cf_get_frame(cf, framenum)) != NULL;
+       framenum++) {
     /* Update the progress bar, but do it only N_PROGBAR_UPDATES times;
        when we update it, we have to run the GTK+ main loop to get it
        to repaint what's pending, and doing so may involve an "ioctl()"
@@ -1020,17 +1445,60 @@ rescan_packets(capture_file *cf, const char *action, gboolean refilter,
 	g_slist_free(fdata->data_src);
       }
       fdata->data_src = NULL;
+    } else if (!refilter && !fdata->flags.passed_dfilter) {
+      /* We're neither rebuilding the dissectors' state nor re-evaluating
+         the display filter, so a frame that didn't pass the filter the
+         last time we looked at it won't pass it now, and won't be put
+         into the packet list; don't bother reading or dissecting it.
+
+         Only a pass that has to reconstruct conversation and reassembly
+         state has to look at every frame, in order. */
+      continue;
     }
 
-    wtap_seek_read (cf->wth, fdata->file_off, &cf->pseudo_header,
-    	cf->pd, fdata->cap_len);
+    if (!dissect_frames) {
+      /* We don't need to dissect the frame; see above. */
+      if (refilter)
+        fdata->flags.passed_dfilter = 1;
+      if (fdata->flags.passed_dfilter)
+        row = append_packet_list_row(fdata, cf);
+      else
+        row = -1;
+    } else {
+      /* If the file's mapped into memory, this just points "pd" at the
+         frame in the mapping, rather than reading it into "cf->pd". */
+      pd = wtap_seek_read_data(cf->wth, fdata->file_off, &cf->pseudo_header,
+      	cf->pd, fdata->cap_len);
 
-    row = add_packet_to_packet_list(fdata, cf, &cf->pseudo_header, cf->pd,
-					refilter);
+      row = add_packet_to_packet_list(fdata, cf, &cf->pseudo_header, pd,
+					refilter, findex, tcp_index);
+    }
     if (fdata == selected_frame)
       selected_row = row;
+    if (dfresult_bits != NULL && fdata->flags.passed_dfilter)
+      DFRESULT_SET(dfresult_bits, fdata->num);
+  }
+
+  if (dfresult_bits != NULL) {
+    if (fdata == NULL) {
+      /* We looked at every frame, so the results are complete. */
+      add_dfilter_results(cf, cf->dfilter, dfresult_bits);
+    } else
+      g_free(dfresult_bits);
   }
  
+  if (redissect && fdata != NULL && cf->findex != NULL) {
+    /* We didn't look at every frame, so the field index is incomplete;
+       get rid of it. */
+    field_index_free(cf->findex);
+    cf->findex = NULL;
+  }
+  if (redissect && fdata != NULL && cf->tcp_index != NULL) {
+    /* Likewise for the TCP connection index. */
+    follow_index_free(cf->tcp_index);
+    cf->tcp_index = NULL;
+  }
+
   if (redissect) {
     /* Clear out what remains of the visited flags and per-frame data
        pointers.
@@ -1041,7 +1509,7 @@ rescan_packets(capture_file *cf, const char *action, gboolean refilter,
        even though the user requested that the scan stop, and that
        would leave the user stuck with an Ethereal grinding on
        until it finishes.  Should we just stick them with that? */
-    for (; fdata != NULL; fdata = fdata->next) {
+    for (; fdata != NULL; fdata = cf_get_frame(cf, ++framenum)) {
       fdata->flags.visited = 0;
       if (fdata->pfd) {
 	g_slist_free(fdata->pfd);
@@ -1077,6 +1545,7 @@ int
 print_packets(capture_file *cf, print_args_t *print_args)
 {
   int         i;
+  guint32     framenum;
   frame_data *fdata;
   progdlg_t  *progbar;
   gboolean    stop_flag;
@@ -1092,6 +1561,7 @@ print_packets(capture_file *cf, print_args_t *print_args)
   int         column_len;
   int         line_len;
   epan_dissect_t *edt = NULL;
+  const guint8 *pd;
 
   cf->print_fh = open_print_dest(print_args->to_file, print_args->dest);
   if (cf->print_fh == NULL)
@@ -1164,7 +1634,8 @@ print_packets(capture_file *cf, print_args_t *print_args)
 
   /* Iterate through the list of packets, printing the packets that
      were selected by the current display filter.  */
-  for (fdata = cf->plist; fdata != NULL; fdata = fdata->next) {
+  for (framenum = 1; (fdata = cf_get_frame(cf, framenum)) != NULL;
+       framenum++) {
     /* Update the progress bar, but do it only N_PROGBAR_UPDATES times;
        when we update it, we have to run the GTK+ main loop to get it
        to repaint what's pending, and doing so may involve an "ioctl()"
@@ -1197,13 +1668,13 @@ print_packets(capture_file *cf, print_args_t *print_args)
      */
     if (((print_args->suppress_unmarked && fdata->flags.marked ) ||
         !(print_args->suppress_unmarked)) && fdata->flags.passed_dfilter) {
-      wtap_seek_read (cf->wth, fdata->file_off, &cf->pseudo_header,
+      pd = wtap_seek_read_data(cf->wth, fdata->file_off, &cf->pseudo_header,
       			cf->pd, fdata->cap_len);
       if (print_args->print_summary) {
         /* Fill in the column information, but don't bother creating
            the logical protocol tree. */
         edt = epan_dissect_new(FALSE, FALSE);
-        epan_dissect_run(edt, &cf->pseudo_header, cf->pd, fdata, &cf->cinfo);
+        epan_dissect_run(edt, &cf->pseudo_header, pd, fdata, &cf->cinfo);
         epan_dissect_fill_in_columns(edt);
         cp = &line_buf[0];
         line_len = 0;
@@ -1242,7 +1713,7 @@ print_packets(capture_file *cf, print_args_t *print_args)
            representation of the items; we don't need the columns here,
            however. */
         edt = epan_dissect_new(TRUE, TRUE);
-        epan_dissect_run(edt, &cf->pseudo_header, cf->pd, fdata, NULL);
+        epan_dissect_run(edt, &cf->pseudo_header, pd, fdata, NULL);
 
         /* Print the information in that tree. */
         proto_tree_print(FALSE, print_args, (GNode *)edt->tree,
@@ -1277,19 +1748,12 @@ print_packets(capture_file *cf, print_args_t *print_args)
   return TRUE;
 }
 
-/* Scan through the packet list and change all columns that use the
+/* Change all columns in the packet list that use the
    "command-line-specified" time stamp format to use the current
    value of that format. */
 void
 change_time_formats(capture_file *cf)
 {
-  frame_data *fdata;
-  progdlg_t *progbar;
-  gboolean stop_flag;
-  guint32 progbar_quantum;
-  guint32 progbar_nextstep;
-  unsigned int count;
-  int row;
   int i;
   GtkStyle  *pl_style;
 
@@ -1309,70 +1773,9 @@ change_time_formats(capture_file *cf)
      screen updates while it happens. */
   freeze_clist(cf);
 
-  /* Update the progress bar when it gets to this value. */
-  progbar_nextstep = 0;
-  /* When we reach the value that triggers a progress bar update,
-     bump that value by this amount. */
-  progbar_quantum = cf->count/N_PROGBAR_UPDATES;
-  /* Count of packets at which we've looked. */
-  count = 0;
-
-  stop_flag = FALSE;
-  progbar = create_progress_dlg("Changing time display", "Stop", &stop_flag);
-
-  /* Iterate through the list of packets, checking whether the packet
-     is in a row of the summary list and, if so, whether there are
-     any columns that show the time in the "command-line-specified"
-     format and, if so, update that row. */
-  for (fdata = cf->plist; fdata != NULL; fdata = fdata->next) {
-    /* Update the progress bar, but do it only N_PROGBAR_UPDATES times;
-       when we update it, we have to run the GTK+ main loop to get it
-       to repaint what's pending, and doing so may involve an "ioctl()"
-       to see if there's any pending input from an X server, and doing
-       that for every packet can be costly, especially on a big file. */
-    if (count >= progbar_nextstep) {
-      /* let's not divide by zero. I should never be started
-       * with count == 0, so let's assert that
-       */
-      g_assert(cf->count > 0);
-
-      update_progress_dlg(progbar, (gfloat) count / cf->count);
-
-      progbar_nextstep += progbar_quantum;
-    }
-
-    if (stop_flag) {
-      /* Well, the user decided to abort the redisplay.  Just stop.
-
-         XXX - this leaves the time field in the old format in
-	 frames we haven't yet processed.  So it goes; should we
-	 simply not offer them the option of stopping? */
-      break;
-    }
-
-    count++;
-
-    /* Find what row this packet is in. */
-    row = gtk_clist_find_row_from_data(GTK_CLIST(packet_list), fdata);
-
-    if (row != -1) {
-      /* This packet is in the summary list, on row "row". */
-
-      for (i = 0; i < cf->cinfo.num_cols; i++) {
-        if (cf->cinfo.fmt_matx[i][COL_CLS_TIME]) {
-          /* This is one of the columns that shows the time in
-             "command-line-specified" format; update it. */
-          cf->cinfo.col_buf[i][0] = '\0';
-          col_set_cls_time(fdata, &cf->cinfo, i);
-          gtk_clist_set_text(GTK_CLIST(packet_list), row, i,
-			     cf->cinfo.col_data[i]);
-        }
-      }
-    }
-  }
-
-  /* We're done redisplaying the packets; destroy the progress bar. */
-  destroy_progress_dlg(progbar);
+  /* Only the rows that are filled in have their time stamps formatted;
+     empty them, so they're filled in again in the new format. */
+  gtk_clist_unfill_rows(GTK_CLIST(packet_list));
 
   /* Set the column widths of those columns that show the time in
      "command-line-specified" format. */
@@ -1392,6 +1795,7 @@ gboolean
 find_packet(capture_file *cf, dfilter_t *sfcode)
 {
   frame_data *start_fd;
+  guint32 framenum;
   frame_data *fdata;
   frame_data *new_fd = NULL;
   progdlg_t *progbar;
@@ -1402,6 +1806,7 @@ find_packet(capture_file *cf, dfilter_t *sfcode)
   gboolean frame_matched;
   int row;
   epan_dissect_t	*edt;
+  const guint8 *pd;
 
   start_fd = cf->current_frame;
   if (start_fd != NULL)  {
@@ -1421,6 +1826,7 @@ find_packet(capture_file *cf, dfilter_t *sfcode)
     progbar = create_progress_dlg("Searching", "Cancel", &stop_flag);
 
     fdata = start_fd;
+    framenum = start_fd->num;
     for (;;) {
       /* Update the progress bar, but do it only N_PROGBAR_UPDATES times;
          when we update it, we have to run the GTK+ main loop to get it
@@ -1448,26 +1854,29 @@ find_packet(capture_file *cf, dfilter_t *sfcode)
       /* Go past the current frame. */
       if (cf->sbackward) {
         /* Go on to the previous frame. */
-        fdata = fdata->prev;
-        if (fdata == NULL)
-          fdata = cf->plist_end;	/* wrap around */
+        if (framenum == 1)
+          framenum = cf->count;	/* wrap around */
+        else
+          framenum--;
       } else {
         /* Go on to the next frame. */
-        fdata = fdata->next;
-        if (fdata == NULL)
-          fdata = cf->plist;	/* wrap around */
+        if (framenum == (guint32)cf->count)
+          framenum = 1;	/* wrap around */
+        else
+          framenum++;
       }
+      fdata = cf_get_frame(cf, framenum);
 
       count++;
 
       /* Is this packet in the display? */
       if (fdata->flags.passed_dfilter) {
         /* Yes.  Does it match the search filter? */
-        wtap_seek_read(cf->wth, fdata->file_off, &cf->pseudo_header,
+        pd = wtap_seek_read_data(cf->wth, fdata->file_off, &cf->pseudo_header,
         		cf->pd, fdata->cap_len);
         edt = epan_dissect_new(TRUE, FALSE);
         epan_dissect_prime_dfilter(edt, sfcode);
-        epan_dissect_run(edt, &cf->pseudo_header, cf->pd, fdata, NULL);
+        epan_dissect_run(edt, &cf->pseudo_header, pd, fdata, NULL);
         frame_matched = dfilter_apply_edt(sfcode, edt);
         epan_dissect_free(edt);
         if (frame_matched) {
@@ -1505,9 +1914,7 @@ goto_frame(capture_file *cf, guint fnumber)
   frame_data *fdata;
   int row;
 
-  for (fdata = cf->plist; fdata != NULL && fdata->num < fnumber; fdata = fdata->next)
-    ;
-
+  fdata = cf_get_frame(cf, fnumber);
   if (fdata == NULL)
     return NO_SUCH_FRAME;	/* we didn't find that frame */
   if (!fdata->flags.passed_dfilter)
@@ -1680,6 +2087,10 @@ thaw_clist(capture_file *cf)
 {
   int i;
 
+  /* Fill in the first rows of the packet list, so that the columns
+     that adjust to their contents have some contents to adjust to. */
+  gtk_clist_fill_rows(GTK_CLIST(packet_list), 0, PACKET_LIST_FILLED_ROWS);
+
   for (i = 0; i < cf->cinfo.num_cols; i++) {
     if (get_column_resize_type(cf->cinfo.col_fmt[i]) == RESIZE_MANUAL) {
       /* Set this column's width to the appropriate value. */
@@ -1710,10 +2121,12 @@ save_cap_file(char *fname, capture_file *cf, gboolean save_filtered, gboolean sa
   int           err;
   gboolean      do_copy;
   wtap_dumper  *pdh;
+  guint32       framenum;
   frame_data   *fdata;
   struct wtap_pkthdr hdr;
   union wtap_pseudo_header pseudo_header;
   guint8        pd[65536];
+  const guint8 *data;
 
   name_ptr = get_basename(fname);
   msg_len = strlen(name_ptr) + strlen(save_fmt) + 2;
@@ -1791,7 +2204,8 @@ save_cap_file(char *fname, capture_file *cf, gboolean save_filtered, gboolean sa
        If we do that, should we make that file the current file?  If so,
        it means we can no longer get at the other packets.  What does
        NetMon do? */
-    for (fdata = cf->plist; fdata != NULL; fdata = fdata->next) {
+    for (framenum = 1; (fdata = cf_get_frame(cf, framenum)) != NULL;
+         framenum++) {
       /* XXX - do a progress bar */
       if ((!save_filtered && !save_marked) ||
 	  (save_filtered && fdata->flags.passed_dfilter && !save_marked) ||
@@ -1809,10 +2223,10 @@ save_cap_file(char *fname, capture_file *cf, gboolean save_filtered, gboolean sa
         hdr.caplen = fdata->cap_len;
         hdr.len = fdata->pkt_len;
         hdr.pkt_encap = fdata->lnk_t;
-	wtap_seek_read(cf->wth, fdata->file_off, &pseudo_header,
+	data = wtap_seek_read_data(cf->wth, fdata->file_off, &pseudo_header,
 		pd, fdata->cap_len);
 
-        if (!wtap_dump(pdh, &hdr, &pseudo_header, pd, &err)) {
+        if (!wtap_dump(pdh, &hdr, &pseudo_header, data, &err)) {
 	    simple_dialog(ESD_TYPE_CRIT, NULL,
 				file_write_error_message(err), fname);
 	    wtap_dump_close(pdh, &err);
@@ -34,6 +34,7 @@
 #include "print.h"
 #include <errno.h>
 #include <epan/epan.h>
+#include "capture_ring.h"
 
 /* Current state of file. */
 typedef enum {
@@ -71,6 +72,9 @@ typedef struct _capture_file {
   gchar       *dfilter;   /* Display filter string */
   struct _colfilter   *colors;	  /* Colors for colorizing packet window */
   dfilter_t   *dfcode;    /* Compiled display filter program */ 
+  GSList      *dfresults; /* Per-frame results of recently-applied display filters */
+  struct _field_index *findex; /* Index of commonly-filtered-on fields, or NULL */
+  struct _follow_index *tcp_index; /* Index of frames in each TCP connection, or NULL */
 #ifdef HAVE_LIBPCAP
   gchar       *cfilter;   /* Capture filter string */
 #endif
@@ -78,9 +82,7 @@ typedef struct _capture_file {
   gboolean     sbackward;  /* TRUE if search is backward, FALSE if forward */
   union wtap_pseudo_header pseudo_header;      /* Packet pseudo_header */
   guint8       pd[WTAP_MAX_PACKET_SIZE];  /* Packet data */
-  GMemChunk   *plist_chunk; /* Memory chunk for frame_data structures */
-  frame_data  *plist;     /* Packet list */
-  frame_data  *plist_end; /* Last packet in list */
+  GPtrArray   *plist_chunks; /* Packet list, as chunks of frame_data structures */
   frame_data  *first_displayed; /* First frame displayed */
   frame_data  *last_displayed;  /* Last frame displayed */
   column_info  cinfo;    /* Column formatting information */
@@ -108,13 +110,29 @@ void close_cap_file(capture_file *);
 read_status_t read_cap_file(capture_file *, int *);
 int  start_tail_cap_file(char *, gboolean, capture_file *);
 read_status_t continue_tail_cap_file(capture_file *, int, int *);
+read_status_t continue_tail_cap_file_from_ring(capture_file *,
+    capture_ring_t *, int *, long *);
 read_status_t finish_tail_cap_file(capture_file *, int *);
 /* size_t read_frame_header(capture_file *); */
 int  save_cap_file(char *, capture_file *, gboolean, gboolean, guint);
 
+/* Get the frame_data structure for frame number "num" (the first frame
+   is frame 1); returns NULL if there's no such frame. */
+frame_data *cf_get_frame(capture_file *cf, guint32 num);
+
 int filter_packets(capture_file *cf, gchar *dfilter);
+int filter_tcp_stream_packets(capture_file *cf, gchar *dfilter,
+    packet_info *pi);
 void colorize_packets(capture_file *);
 void redissect_packets(capture_file *cf);
+void update_packet_names(capture_file *cf);
+
+/* Number of rows of the packet list to keep filled in; the columns of
+   the others are generated from their frames when they're drawn. */
+#define PACKET_LIST_FILLED_ROWS	512
+
+void set_packet_list_fill_func(capture_file *cf);
+
 int print_packets(capture_file *cf, print_args_t *print_args);
 void change_time_formats(capture_file *);
 gboolean find_packet(capture_file *cf, dfilter_t *sfcode);
@@ -43,7 +43,7 @@
 #include <epan/packet.h>
 #include "follow.h"
 
-FILE* data_out_file;
+GByteArray *follow_data = NULL;
 
 gboolean incomplete_tcp_stream = FALSE;
 
@@ -316,7 +316,177 @@ reset_tcp_reassembly() {
 static void 
 write_packet_data( int index, tcp_stream_chunk *sc, const char *data )
 {
-  fwrite( sc, 1, sizeof(tcp_stream_chunk), data_out_file );
-  fwrite( data, 1, sc->dlen, data_out_file );
+  g_byte_array_append( follow_data, (guint8 *)sc, sizeof(tcp_stream_chunk) );
+  g_byte_array_append( follow_data, (const guint8 *)data, sc->dlen );
   bytes_written[index] += sc->dlen;
 }
+
+/*
+ * The index of the frames in each TCP connection.  A connection is
+ * identified by its two addresses and ports, in a canonical order, so
+ * that frames in both directions go into the same entry.
+ */
+typedef struct {
+  int       addr_len;
+  guint8    addr[2][MAX_IPADDR_LEN];
+  guint32   port[2];
+} follow_conn_key;
+
+typedef struct {
+  follow_conn_key key;
+  GArray   *frames;       /* numbers of the frames in the connection */
+} follow_conn;
+
+struct _follow_index {
+  GHashTable *conns;
+  guint32     count;      /* frames added to the index */
+};
+
+static guint
+follow_conn_hash(gconstpointer v)
+{
+  const follow_conn_key *key = v;
+  guint hash = key->port[0] ^ (key->port[1] << 16);
+  int i;
+
+  for (i = 0; i < key->addr_len; i++)
+    hash = hash*31 + key->addr[0][i] + key->addr[1][i];
+  return hash;
+}
+
+static gint
+follow_conn_equal(gconstpointer v, gconstpointer w)
+{
+  const follow_conn_key *a = v;
+  const follow_conn_key *b = w;
+
+  return a->addr_len == b->addr_len &&
+         a->port[0] == b->port[0] && a->port[1] == b->port[1] &&
+         memcmp(a->addr[0], b->addr[0], a->addr_len) == 0 &&
+         memcmp(a->addr[1], b->addr[1], a->addr_len) == 0;
+}
+
+/* Fill in the key for the connection between "src" and "dst"; returns
+   FALSE if they're not both IPv4 or both IPv6 addresses. */
+static gboolean
+follow_conn_set_key(follow_conn_key *key, address *src, guint32 srcport,
+		    address *dst, guint32 dstport)
+{
+  int cmp;
+
+  if (src->type == AT_IPv4 && dst->type == AT_IPv4)
+    key->addr_len = 4;
+  else if (src->type == AT_IPv6 && dst->type == AT_IPv6)
+    key->addr_len = 16;
+  else
+    return FALSE;
+
+  cmp = memcmp(src->data, dst->data, key->addr_len);
+  if (cmp < 0 || (cmp == 0 && srcport <= dstport)) {
+    memcpy(key->addr[0], src->data, key->addr_len);
+    key->port[0] = srcport;
+    memcpy(key->addr[1], dst->data, key->addr_len);
+    key->port[1] = dstport;
+  } else {
+    memcpy(key->addr[0], dst->data, key->addr_len);
+    key->port[0] = dstport;
+    memcpy(key->addr[1], src->data, key->addr_len);
+    key->port[1] = srcport;
+  }
+  return TRUE;
+}
+
+follow_index_t *
+follow_index_new(void)
+{
+  follow_index_t *fidx;
+
+  fidx = g_malloc(sizeof (follow_index_t));
+  fidx->conns = g_hash_table_new(follow_conn_hash, follow_conn_equal);
+  fidx->count = 0;
+  return fidx;
+}
+
+static void
+follow_conn_free(gpointer key, gpointer value, gpointer user_data)
+{
+  follow_conn *conn = value;
+
+  g_array_free(conn->frames, TRUE);
+  g_free(conn);
+}
+
+void
+follow_index_free(follow_index_t *fidx)
+{
+  g_hash_table_foreach(fidx->conns, follow_conn_free, NULL);
+  g_hash_table_destroy(fidx->conns);
+  g_free(fidx);
+}
+
+guint32
+follow_index_count(follow_index_t *fidx)
+{
+  return fidx->count;
+}
+
+void
+follow_index_add_frame(follow_index_t *fidx, packet_info *pi, guint32 num)
+{
+  follow_conn_key key;
+  follow_conn *conn;
+
+  fidx->count++;
+  if (pi->ipproto != 6 ||
+      !follow_conn_set_key(&key, &pi->net_src, pi->srcport,
+			   &pi->net_dst, pi->destport))
+    return;
+
+  conn = g_hash_table_lookup(fidx->conns, &key);
+  if (conn == NULL) {
+    conn = g_malloc(sizeof (follow_conn));
+    conn->key = key;
+    conn->frames = g_array_new(FALSE, FALSE, sizeof (guint32));
+    g_hash_table_insert(fidx->conns, &conn->key, conn);
+  }
+  g_array_append_val(conn->frames, num);
+}
+
+static void
+follow_index_set_bits(follow_index_t *fidx, follow_conn_key *key,
+		      guint32 *bits)
+{
+  follow_conn *conn;
+  guint i;
+  guint32 num;
+
+  conn = g_hash_table_lookup(fidx->conns, key);
+  if (conn == NULL)
+    return;
+  for (i = 0; i < conn->frames->len; i++) {
+    num = g_array_index(conn->frames, guint32, i) - 1;
+    bits[num / 32] |= 1U << (num % 32);
+  }
+}
+
+gboolean
+follow_index_get_frames(follow_index_t *fidx, packet_info *pi, guint32 *bits)
+{
+  follow_conn_key key;
+
+  if (pi->ipproto != 6)
+    return FALSE;
+
+  /* The filter from "build_follow_filter()" also matches the connection
+     with the ports the other way around, so include its frames, too. */
+  if (!follow_conn_set_key(&key, &pi->net_src, pi->srcport,
+			   &pi->net_dst, pi->destport))
+    return FALSE;
+  follow_index_set_bits(fidx, &key, bits);
+  if (pi->srcport != pi->destport) {
+    follow_conn_set_key(&key, &pi->net_src, pi->destport,
+			&pi->net_dst, pi->srcport);
+    follow_index_set_bits(fidx, &key, bits);
+  }
+  return TRUE;
+}
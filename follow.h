@@ -33,6 +33,11 @@
 
 extern gboolean incomplete_tcp_stream;
 
+/* If not null, "reassemble_tcp()" appends the data of the stream being
+   followed here, as a sequence of "tcp_stream_chunk"s, each followed by
+   "dlen" bytes of data. */
+extern GByteArray *follow_data;
+
 typedef struct _tcp_frag {
   u_long              seq;
   u_long              len;
@@ -61,4 +66,32 @@ typedef struct {
 
 void follow_tcp_stats(follow_tcp_stats_t* stats);
 
+/*
+ * An index of the frames in each TCP connection in a capture, built as
+ * the frames are read, so that following a TCP stream needs to look
+ * only at the frames in the stream's connection.
+ */
+typedef struct _follow_index follow_index_t;
+
+follow_index_t *follow_index_new(void);
+void follow_index_free(follow_index_t *fidx);
+
+/* Number of frames in the index, including ones not in a TCP connection. */
+guint32 follow_index_count(follow_index_t *fidx);
+
+/* Add a frame, with "pi" as filled in by dissecting it. */
+void follow_index_add_frame(follow_index_t *fidx, packet_info *pi,
+    guint32 num);
+
+/* Set bit "num - 1" of "bits" for each frame "num" in the TCP connection
+   to which "pi" belongs, or in the one with the ports swapped, which is
+   what the filter "build_follow_filter()" returns for "pi" matches; returns
+   FALSE if "pi" isn't for a TCP segment over IPv4 or IPv6.
+
+   XXX - frames with more than one IP header, such as tunneled frames or
+   ICMP errors, can match the filter on addresses from a header other than
+   the one in "pi", and won't be found. */
+gboolean follow_index_get_frames(follow_index_t *fidx, packet_info *pi,
+    guint32 *bits);
+
 #endif
@@ -394,6 +394,7 @@ color_filter_up_cb                     (GtkButton       *button,
 			filter_number-1);
 	filter_list = g_slist_remove(filter_list, colorf);
 	filter_list = g_slist_insert(filter_list, colorf, filter_number-1);
+	color_filters_changed();
 	filter->row_selected--;
   }
 }
@@ -425,6 +426,7 @@ color_filter_down_cb                   (GtkButton       *button,
 			filter_number);
 	filter_list = g_slist_remove(filter_list, colorf);
 	filter_list = g_slist_insert(filter_list, colorf, filter_number+1);
+	color_filters_changed();
 	filter->row_selected++;
   }
 }
@@ -952,6 +954,7 @@ edit_color_filter_ok_cb                (GtkButton       *button,
 	if(colorf->c_colorfilter != NULL)
 	    dfilter_free(colorf->c_colorfilter);
 	colorf->c_colorfilter = compiled_filter;
+	color_filters_changed();
 	/* gtk_clist_set_text frees old text (if any) and allocates new space */
 	gtk_clist_set_text(GTK_CLIST(color_filters),
 		cfile.colors->row_selected, 0, filter_name);
@@ -55,6 +55,12 @@ static gboolean read_filters(colfilter *filter);
 
 GSList *filter_list;
 
+/* All the compiled color filters, combined into one program, and the
+ * filters in the order in which it tests them; NULL if they have to
+ * be combined again. */
+static dfilter_t *combined_dfilter;
+static GPtrArray *combined_filters;
+
 static GdkColormap*	sys_cmap;
 static GdkColormap*	our_cmap = NULL;
 
@@ -112,6 +118,7 @@ new_color_filter(colfilter *filters,    /* The filter list (unused) */
 	colorf->c_colorfilter = NULL;
 	colorf->edit_dialog = NULL;
 	filter_list = g_slist_append(filter_list, colorf);
+	color_filters_changed();
         return colorf;
 }
 
@@ -127,6 +134,49 @@ delete_color_filter(color_filter_t *colorf)
 		dfilter_free(colorf->c_colorfilter);
 	filter_list = g_slist_remove(filter_list, colorf);
 	g_free(colorf);
+	color_filters_changed();
+}
+
+/* Discard the combined color filter program; the next packet we
+ * colorize will build it again from 'filter_list'. */
+void
+color_filters_changed(void)
+{
+	if (combined_dfilter != NULL) {
+		dfilter_free(combined_dfilter);
+		combined_dfilter = NULL;
+	}
+	if (combined_filters != NULL) {
+		g_ptr_array_free(combined_filters, TRUE);
+		combined_filters = NULL;
+	}
+}
+
+/* Combine the compiled filters in 'filter_list' into one program,
+ * so that all of them can be tested with one run of the dfilter VM. */
+static void
+combine_filters(void)
+{
+	GSList		*l;
+	color_filter_t	*colorf;
+	GPtrArray	*texts;
+
+	combined_filters = g_ptr_array_new();
+	texts = g_ptr_array_new();
+	for (l = filter_list; l != NULL; l = l->next) {
+		colorf = l->data;
+		if (colorf->c_colorfilter != NULL) {
+			g_ptr_array_add(combined_filters, colorf);
+			g_ptr_array_add(texts, colorf->filter_text);
+		}
+	}
+
+	/* Every filter has compiled on its own, so this shouldn't fail;
+	 * if it does, we fall back on applying them one at a time. */
+	if (!dfilter_compile_list((gchar **)texts->pdata, texts->len,
+	    &combined_dfilter))
+		combined_dfilter = NULL;
+	g_ptr_array_free(texts, FALSE);
 }
 
 static void
@@ -144,7 +194,40 @@ prime_edt(gpointer data, gpointer user_data)
 void
 filter_list_prime_edt(epan_dissect_t *edt)
 {
-	g_slist_foreach(filter_list, prime_edt, edt);
+	if (combined_filters == NULL)
+		combine_filters();
+	if (combined_dfilter != NULL)
+		epan_dissect_prime_dfilter(edt, combined_dfilter);
+	else
+		g_slist_foreach(filter_list, prime_edt, edt);
+}
+
+/* Return the first color filter in 'filter_list' that matches the
+ * dissected packet, or NULL if none of them do. */
+color_filter_t *
+color_filters_first_match(epan_dissect_t *edt)
+{
+	GSList		*l;
+	color_filter_t	*colorf;
+	int		match;
+
+	if (combined_filters == NULL)
+		combine_filters();
+
+	if (combined_dfilter != NULL) {
+		match = dfilter_apply_first_edt(combined_dfilter, edt);
+		if (match < 0)
+			return NULL;
+		return g_ptr_array_index(combined_filters, match);
+	}
+
+	for (l = filter_list; l != NULL; l = l->next) {
+		colorf = l->data;
+		if (colorf->c_colorfilter != NULL &&
+		    dfilter_apply_edt(colorf->c_colorfilter, edt))
+			return colorf;
+	}
+	return NULL;
 }
 
 
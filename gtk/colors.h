@@ -70,4 +70,10 @@ gboolean get_color (GdkColor *new_color);
 void
 filter_list_prime_edt(epan_dissect_t *edt);
 
+/* Must be called whenever 'filter_list', or the order of the filters
+ * in it, or one of their compiled filters, changes. */
+void color_filters_changed(void);
+
+color_filter_t *color_filters_first_match(epan_dissect_t *edt);
+
 #endif
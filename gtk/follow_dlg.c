@@ -90,7 +90,7 @@ typedef enum {
 typedef struct {
 	show_stream_t	show_stream;
 	show_type_t	show_type;
-	char		data_out_filename[128 + 1];
+	GByteArray	*data;		/* reassembled data of the stream */
 	GtkWidget	*text;
 	GtkWidget	*ascii_bt;
 	GtkWidget	*ebcdic_bt;
@@ -111,9 +111,6 @@ static void follow_stream_om_client(GtkWidget * w, gpointer data);
 static void follow_stream_om_server(GtkWidget * w, gpointer data);
 
 
-FILE *data_out_file = NULL;
-
-
 #define E_FOLLOW_INFO_KEY "follow_info_key"
 
 /* List of "follow_info_t" structures for all "Follow TCP Stream" windows,
@@ -156,7 +153,6 @@ follow_stream_cb(GtkWidget * w, gpointer data)
 	GtkWidget	*streamwindow, *vbox, *txt_scrollw, *text, *filter_te;
 	GtkWidget	*hbox, *button, *radio_bt;
 	GtkWidget	*stream_om, *stream_menu, *stream_mi;
-	int		tmp_fd;
 	gchar		*follow_filter;
 	const char	*hostname0, *hostname1;
 	char		*port0, *port1;
@@ -174,35 +170,11 @@ follow_stream_cb(GtkWidget * w, gpointer data)
 
 	follow_info = g_new0(follow_info_t, 1);
 
-	/* Create a temporary file into which to dump the reassembled data
-	   from the TCP stream, and set "data_out_file" to refer to it, so
-	   that the TCP code will write to it.
-
-	   XXX - it might be nicer to just have the TCP code directly
-	   append stuff to the text widget for the TCP stream window,
-	   if we can arrange that said window not pop up until we're
-	   done. */
-	tmp_fd = create_tempfile(follow_info->data_out_filename,
-			sizeof follow_info->data_out_filename, "follow");
-
-	if (tmp_fd == -1) {
-	    simple_dialog(ESD_TYPE_WARN, NULL,
-			  "Could not create temporary file %s: %s",
-			  follow_info->data_out_filename, strerror(errno));
-	    g_free(follow_info);
-	    return;
-	}
-
-	data_out_file = fdopen(tmp_fd, "wb");
-	if (data_out_file == NULL) {
-	    simple_dialog(ESD_TYPE_WARN, NULL,
-			  "Could not create temporary file %s: %s",
-			  follow_info->data_out_filename, strerror(errno));
-	    close(tmp_fd);
-	    unlink(follow_info->data_out_filename);
-	    g_free(follow_info);
-	    return;
-	}
+	/* Set "follow_data" to refer to the buffer in which to keep the
+	   reassembled data from the TCP stream, so that the TCP code will
+	   append to it. */
+	follow_info->data = g_byte_array_new();
+	follow_data = follow_info->data;
 
 	/* Create a new filter that matches all packets in the TCP stream,
 	   and set the display filter entry accordingly */
@@ -213,13 +185,12 @@ follow_stream_cb(GtkWidget * w, gpointer data)
 	filter_te = gtk_object_get_data(GTK_OBJECT(w), E_DFILTER_TE_KEY);
 	gtk_entry_set_text(GTK_ENTRY(filter_te), follow_filter);
 
-	/* Run the display filter so it goes in effect. */
-	filter_packets(&cfile, follow_filter);
+	/* Run the display filter so it goes in effect; dissecting the
+	   frames in the stream fills in "follow_data". */
+	filter_tcp_stream_packets(&cfile, follow_filter, &cfile.edt->pi);
+	follow_data = NULL;
 
-	/* The data_out_file should now be full of the streams information */
-	fclose(data_out_file);
-
-	/* The data_out_filename file now has all the text that was in the session */
+	/* The buffer now has all the text that was in the session */
 	streamwindow = gtk_window_new(GTK_WINDOW_TOPLEVEL);
 	gtk_widget_set_name(streamwindow, "TCP stream window");
 
@@ -387,24 +358,22 @@ follow_stream_cb(GtkWidget * w, gpointer data)
 	follow_load_text(follow_info);
 	remember_follow_info(follow_info);
 
-	data_out_file = NULL;
-
 	/* Make sure this widget gets destroyed if we quit the main loop,
-	   so that if we exit, we clean up any temporary files we have
-	   for "Follow TCP Stream" windows. */
+	   so that if we exit, we clean up any "Follow TCP Stream"
+	   windows. */
 	gtk_quit_add_destroy(gtk_main_level(), GTK_OBJECT(streamwindow));
 	gtk_widget_show_all(streamwindow);
 }
 
 /* The destroy call back has the responsibility of
- * unlinking the temporary file */
+ * freeing the reassembled data */
 static void
 follow_destroy_cb(GtkWidget *w, gpointer data)
 {
 	follow_info_t	*follow_info;
 
 	follow_info = gtk_object_get_data(GTK_OBJECT(w), E_FOLLOW_INFO_KEY);
-	unlink(follow_info->data_out_filename);
+	g_byte_array_free(follow_info->data, TRUE);
 	gtk_widget_destroy(w);
 	forget_follow_info(follow_info);
 	g_free(follow_info);
@@ -469,127 +438,121 @@ follow_read_stream(follow_info_t *follow_info,
     guint16		current_pos, global_client_pos = 0, global_server_pos = 0;
     guint16		*global_pos;
     gboolean		skip;
+    char		buffer[FLT_BUF_SIZE];
+    int			nchars;
+    guint		data_pos, data_len;
 
     iplen = (follow_info->is_ipv6) ? 16 : 4;
-     
-    data_out_file = fopen(follow_info->data_out_filename, "rb");
-    if (data_out_file) {
-	char buffer[FLT_BUF_SIZE];
-	int nchars;
-	while (fread(&sc, 1, sizeof(sc), data_out_file)) {
-	    if (client_port == 0) {
-		memcpy(client_addr, sc.src_addr, iplen);
-		client_port = sc.src_port;
-	    }
-	    skip = FALSE;
-	    if (memcmp(client_addr, sc.src_addr, iplen) == 0 &&
-		client_port == sc.src_port) {
-		is_server = FALSE;
-		global_pos = &global_client_pos;
-		if (follow_info->show_stream == FROM_SERVER) {
-			skip = TRUE;
-		}
+    data_pos = 0;
+    data_len = follow_info->data->len;
+
+    while (data_len - data_pos >= sizeof(sc)) {
+	memcpy(&sc, follow_info->data->data + data_pos, sizeof(sc));
+	data_pos += sizeof(sc);
+	if (client_port == 0) {
+	    memcpy(client_addr, sc.src_addr, iplen);
+	    client_port = sc.src_port;
+	}
+	skip = FALSE;
+	if (memcmp(client_addr, sc.src_addr, iplen) == 0 &&
+	    client_port == sc.src_port) {
+	    is_server = FALSE;
+	    global_pos = &global_client_pos;
+	    if (follow_info->show_stream == FROM_SERVER) {
+		    skip = TRUE;
 	    }
-	    else {
-		is_server = TRUE;
-		global_pos = &global_server_pos;
-		if (follow_info->show_stream == FROM_CLIENT) {
-			skip = TRUE;
-		}
+	}
+	else {
+	    is_server = TRUE;
+	    global_pos = &global_server_pos;
+	    if (follow_info->show_stream == FROM_CLIENT) {
+		    skip = TRUE;
 	    }
+	}
 
-	    while (sc.dlen > 0) {
-		bcount = (sc.dlen < FLT_BUF_SIZE) ? sc.dlen : FLT_BUF_SIZE;
-		nchars = fread(buffer, 1, bcount, data_out_file);
-		if (nchars == 0)
-		    break;
-		sc.dlen -= bcount;
-		if (!skip) {
-		    switch (follow_info->show_type) {
-			case SHOW_EBCDIC:
-			    /* If our native arch is ASCII, call: */
-			    EBCDIC_to_ASCII(buffer, nchars);
-			    (*print_line) (buffer, nchars, is_server, arg);
-			    break;
-			case SHOW_ASCII:
-			    /* If our native arch is EBCDIC, call:
-			     * ASCII_TO_EBCDIC(buffer, nchars);
-			     */
-			    (*print_line) (buffer, nchars, is_server, arg);
-			    break;
-			case SHOW_HEXDUMP:
-			    current_pos = 0;
-			    while (current_pos < nchars) {
-				gchar hexbuf[256];
-				gchar hexchars[] = "0123456789abcdef";
-				int i, cur;
-				/* is_server indentation : put 63 spaces at the begenning
-				 * of the string */
-				sprintf(hexbuf, (is_server && 
-					follow_info->show_stream == BOTH_HOSTS) ?
-					"                                 "
-					"                                             %08X  " :
-					"%08X  ", *global_pos);
-				cur = strlen(hexbuf);
-				for (i = 0; i < 16 && current_pos + i < nchars;
-				     i++) {
-				    hexbuf[cur++] =
-					hexchars[(buffer[current_pos + i] & 0xf0)
-						 >> 4];
-				    hexbuf[cur++] =
-					hexchars[buffer[current_pos + i] & 0x0f];
-				    if (i == 7) {
-					hexbuf[cur++] = ' ';
-					hexbuf[cur++] = ' ';
-				    } else if (i != 15)
-					hexbuf[cur++] = ' ';
-				}
-				/* Fill it up if column isn't complete */
-				if (i < 16) {
-				    int j;
+	while (sc.dlen > 0) {
+	    bcount = (sc.dlen < FLT_BUF_SIZE) ? sc.dlen : FLT_BUF_SIZE;
+	    /* Copy the data, as we may translate it in place. */
+	    nchars = MIN((guint)bcount, data_len - data_pos);
+	    if (nchars == 0)
+		break;
+	    memcpy(buffer, follow_info->data->data + data_pos, nchars);
+	    data_pos += nchars;
+	    sc.dlen -= bcount;
+	    if (!skip) {
+		switch (follow_info->show_type) {
+		    case SHOW_EBCDIC:
+			/* If our native arch is ASCII, call: */
+			EBCDIC_to_ASCII(buffer, nchars);
+			(*print_line) (buffer, nchars, is_server, arg);
+			break;
+		    case SHOW_ASCII:
+			/* If our native arch is EBCDIC, call:
+			 * ASCII_TO_EBCDIC(buffer, nchars);
+			 */
+			(*print_line) (buffer, nchars, is_server, arg);
+			break;
+		    case SHOW_HEXDUMP:
+			current_pos = 0;
+			while (current_pos < nchars) {
+			    gchar hexbuf[256];
+			    gchar hexchars[] = "0123456789abcdef";
+			    int i, cur;
+			    /* is_server indentation : put 63 spaces at the begenning
+			     * of the string */
+			    sprintf(hexbuf, (is_server && 
+				    follow_info->show_stream == BOTH_HOSTS) ?
+				    "                                 "
+				    "                                             %08X  " :
+				    "%08X  ", *global_pos);
+			    cur = strlen(hexbuf);
+			    for (i = 0; i < 16 && current_pos + i < nchars;
+				 i++) {
+				hexbuf[cur++] =
+				    hexchars[(buffer[current_pos + i] & 0xf0)
+					     >> 4];
+				hexbuf[cur++] =
+				    hexchars[buffer[current_pos + i] & 0x0f];
+				if (i == 7) {
+				    hexbuf[cur++] = ' ';
+				    hexbuf[cur++] = ' ';
+				} else if (i != 15)
+				    hexbuf[cur++] = ' ';
+			    }
+			    /* Fill it up if column isn't complete */
+			    if (i < 16) {
+				int j;
 					
-				    for (j = i; j < 16; j++) {
-					if (j == 7)
-					    hexbuf[cur++] = ' ';
-					hexbuf[cur++] = ' ';
-					hexbuf[cur++] = ' ';
+				for (j = i; j < 16; j++) {
+				    if (j == 7)
 					hexbuf[cur++] = ' ';
-				    }
-				} else
 				    hexbuf[cur++] = ' ';
-
-				/* Now dump bytes as text */
-				for (i = 0; i < 16 && current_pos + i < nchars;
-				     i++) {
-				    hexbuf[cur++] =
-				        (isprint((guchar)buffer[current_pos + i]) ?
-				        buffer[current_pos + i] : '.' );
-				    if (i == 7) {
-					hexbuf[cur++] = ' ';
-				    } 
+				    hexbuf[cur++] = ' ';
+				    hexbuf[cur++] = ' ';
 				}
-				current_pos += i;
-				(*global_pos) += i;
-				hexbuf[cur++] = '\n';
-				hexbuf[cur] = 0;
-				(*print_line) (hexbuf, strlen(hexbuf), is_server, arg);
+			    } else
+				hexbuf[cur++] = ' ';
+
+			    /* Now dump bytes as text */
+			    for (i = 0; i < 16 && current_pos + i < nchars;
+				 i++) {
+				hexbuf[cur++] =
+				    (isprint((guchar)buffer[current_pos + i]) ?
+				    buffer[current_pos + i] : '.' );
+				if (i == 7) {
+				    hexbuf[cur++] = ' ';
+				} 
 			    }
-			    break;
-		    }
+			    current_pos += i;
+			    (*global_pos) += i;
+			    hexbuf[cur++] = '\n';
+			    hexbuf[cur] = 0;
+			    (*print_line) (hexbuf, strlen(hexbuf), is_server, arg);
+			}
+			break;
 		}
 	    }
 	}
-	if (ferror(data_out_file)) {
-	    simple_dialog(ESD_TYPE_WARN, NULL,
-			  "Error reading temporary file %s: %s", follow_info->data_out_filename,
-			  strerror(errno));
-	}
-	fclose(data_out_file);
-	data_out_file = NULL;
-    } else {
-	simple_dialog(ESD_TYPE_WARN, NULL,
-		      "Could not open temporary file %s: %s", follow_info->data_out_filename,
-		      strerror(errno));
     }
 }
 
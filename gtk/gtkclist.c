@@ -448,6 +448,19 @@ static GList *gtk_clist_merge      (GtkCList      *clist,
 static GList *gtk_clist_mergesort  (GtkCList      *clist,
 				    GList         *list,
 				    gint           num);
+/* Filling in rows on demand */
+typedef struct _FillRowInfo FillRowInfo;
+static FillRowInfo *fill_row_info     (GtkCList    *clist);
+static void fill_row_info_free        (gpointer     data);
+static void fill_row                  (GtkCList    *clist,
+				       FillRowInfo *info,
+				       GtkCListRow *clist_row);
+static void unfill_row                (GtkCList    *clist,
+				       FillRowInfo *info,
+				       GtkCListRow *clist_row);
+static void unfill_excess_rows        (GtkCList    *clist,
+				       FillRowInfo *info);
+
 /* Misc */
 static gboolean title_focus           (GtkCList  *clist,
 			               gint       dir);
@@ -2239,6 +2252,7 @@ gtk_clist_get_text (GtkCList  *clist,
     return 0;
 
   clist_row = ROW_ELEMENT (clist, row)->data;
+  fill_row (clist, fill_row_info (clist), clist_row);
 
   if (clist_row->cell[column].type != GTK_CELL_TEXT)
     return 0;
@@ -2652,6 +2666,10 @@ real_insert_row (GtkCList *clist,
       GTK_CLIST_CLASS_FW (clist)->set_cell_contents
 	(clist, clist_row, i, GTK_CELL_TEXT, text[i], 0, NULL ,NULL);
 
+  /* leave the rest for the fill function, if there is one */
+  if (fill_row_info (clist))
+    clist_row->needs_fill = TRUE;
+
   if (!clist->rows)
     {
       clist->row_list = g_list_append (clist->row_list, clist_row);
@@ -3033,6 +3051,13 @@ gtk_clist_set_row_data_full (GtkCList         *clist,
   
   clist_row->data = data;
   clist_row->destroy = destroy;
+
+  /* a row that's filled in on demand may have been drawn before it
+   * had the data needed to fill it in */
+  if (fill_row_info (clist) && clist_row->needs_fill &&
+      CLIST_UNFROZEN (clist) &&
+      gtk_clist_row_is_visible (clist, row) != GTK_VISIBILITY_NONE)
+    GTK_CLIST_CLASS_FW (clist)->draw_row (clist, NULL, row, clist_row);
 }
 
 gpointer
@@ -5681,6 +5706,8 @@ draw_row (GtkCList     *clist,
   if (!clist_row)
     clist_row = ROW_ELEMENT (clist, row)->data;
 
+  fill_row (clist, fill_row_info (clist), clist_row);
+
   /* rectangle of the entire row */
   row_rectangle.x = 0;
   row_rectangle.y = ROW_TOP_YPIXEL (clist, row);
@@ -6489,6 +6516,8 @@ row_new (GtkCList *clist)
   clist_row->bg_set = FALSE;
   clist_row->style = NULL;
   clist_row->selectable = TRUE;
+  clist_row->needs_fill = FALSE;
+  clist_row->filled = FALSE;
   clist_row->state = GTK_STATE_NORMAL;
   clist_row->data = NULL;
   clist_row->destroy = NULL;
@@ -6500,8 +6529,12 @@ static void
 row_delete (GtkCList    *clist,
 	    GtkCListRow *clist_row)
 {
+  FillRowInfo *info;
   gint i;
 
+  if (clist_row->filled && (info = fill_row_info (clist)))
+    unfill_row (clist, info, clist_row);
+
   for (i = 0; i < clist->columns; i++)
     {
       GTK_CLIST_CLASS_FW (clist)->set_cell_contents
@@ -7243,6 +7276,293 @@ gtk_clist_set_sort_column (GtkCList *clist,
   clist->sort_column = column;
 }
 
+void
+gtk_clist_set_fill_row_func (GtkCList            *clist,
+			     GtkCListFillRowFunc  fill_func,
+			     gpointer             data,
+			     guint                max_filled)
+{
+  FillRowInfo *info;
+
+  g_return_if_fail (clist != NULL);
+  g_return_if_fail (GTK_IS_CLIST (clist));
+  g_return_if_fail (fill_func != NULL);
+
+  info = fill_row_info (clist);
+  if (!info)
+    {
+      info = g_new0 (FillRowInfo, 1);
+      info->nodes = g_hash_table_new (g_direct_hash, g_direct_equal);
+      gtk_object_set_data_full (GTK_OBJECT (clist), "fill_row_info", info,
+				fill_row_info_free);
+    }
+  info->func = fill_func;
+  info->data = data;
+  info->max_filled = max_filled;
+  unfill_excess_rows (clist, info);
+}
+
+void
+gtk_clist_set_fill_row_limit (GtkCList *clist,
+			      guint     max_filled)
+{
+  FillRowInfo *info;
+
+  g_return_if_fail (clist != NULL);
+  g_return_if_fail (GTK_IS_CLIST (clist));
+
+  info = fill_row_info (clist);
+  if (!info)
+    return;
+
+  info->max_filled = max_filled;
+  unfill_excess_rows (clist, info);
+}
+
+void
+gtk_clist_set_row_contents (GtkCList    *clist,
+			    GtkCListRow *clist_row,
+			    gchar       *text[],
+			    GdkColor    *foreground,
+			    GdkColor    *background)
+{
+  gboolean blocked;
+  gint i;
+
+  g_return_if_fail (clist != NULL);
+  g_return_if_fail (GTK_IS_CLIST (clist));
+  g_return_if_fail (clist_row != NULL);
+  g_return_if_fail (text != NULL);
+
+  /* rows get filled in while they're being drawn; resizing a column
+   * then would mean redrawing the rows in the middle of drawing one */
+  blocked = GTK_CLIST_AUTO_RESIZE_BLOCKED (clist);
+  GTK_CLIST_SET_FLAG (clist, CLIST_AUTO_RESIZE_BLOCKED);
+  for (i = 0; i < clist->columns; i++)
+    GTK_CLIST_CLASS_FW (clist)->set_cell_contents
+      (clist, clist_row, i, GTK_CELL_TEXT, text[i], 0, NULL, NULL);
+  if (!blocked)
+    GTK_CLIST_UNSET_FLAG (clist, CLIST_AUTO_RESIZE_BLOCKED);
+
+  if (foreground)
+    {
+      clist_row->foreground = *foreground;
+      clist_row->fg_set = TRUE;
+      if (GTK_WIDGET_REALIZED (clist))
+	gdk_color_alloc (gtk_widget_get_colormap (GTK_WIDGET (clist)),
+			 &clist_row->foreground);
+    }
+  else
+    clist_row->fg_set = FALSE;
+
+  if (background)
+    {
+      clist_row->background = *background;
+      clist_row->bg_set = TRUE;
+      if (GTK_WIDGET_REALIZED (clist))
+	gdk_color_alloc (gtk_widget_get_colormap (GTK_WIDGET (clist)),
+			 &clist_row->background);
+    }
+  else
+    clist_row->bg_set = FALSE;
+
+  clist_row->needs_fill = FALSE;
+}
+
+void
+gtk_clist_fill_row (GtkCList    *clist,
+		    GtkCListRow *clist_row)
+{
+  g_return_if_fail (clist != NULL);
+  g_return_if_fail (GTK_IS_CLIST (clist));
+  g_return_if_fail (clist_row != NULL);
+
+  fill_row (clist, fill_row_info (clist), clist_row);
+}
+
+void
+gtk_clist_fill_rows (GtkCList *clist,
+		     gint      row,
+		     gint      count)
+{
+  FillRowInfo *info;
+  GList *list;
+
+  g_return_if_fail (clist != NULL);
+  g_return_if_fail (GTK_IS_CLIST (clist));
+
+  info = fill_row_info (clist);
+  if (!info || row < 0 || row >= clist->rows)
+    return;
+
+  for (list = ROW_ELEMENT (clist, row); list && count > 0;
+       list = list->next, count--)
+    fill_row (clist, info, GTK_CLIST_ROW (list));
+}
+
+void
+gtk_clist_unfill_row (GtkCList *clist,
+		      gint      row)
+{
+  FillRowInfo *info;
+  GtkCListRow *clist_row;
+
+  g_return_if_fail (clist != NULL);
+  g_return_if_fail (GTK_IS_CLIST (clist));
+
+  info = fill_row_info (clist);
+  if (!info || row < 0 || row >= clist->rows)
+    return;
+
+  clist_row = ROW_ELEMENT (clist, row)->data;
+  if (!clist_row->filled)
+    return;
+
+  unfill_row (clist, info, clist_row);
+
+  if (CLIST_UNFROZEN (clist) &&
+      gtk_clist_row_is_visible (clist, row) != GTK_VISIBILITY_NONE)
+    GTK_CLIST_CLASS_FW (clist)->draw_row (clist, NULL, row, clist_row);
+}
+
+void
+gtk_clist_unfill_rows (GtkCList *clist)
+{
+  FillRowInfo *info;
+
+  g_return_if_fail (clist != NULL);
+  g_return_if_fail (GTK_IS_CLIST (clist));
+
+  info = fill_row_info (clist);
+  if (!info)
+    return;
+
+  while (info->filled)
+    unfill_row (clist, info, info->filled->data);
+
+  CLIST_REFRESH (clist);
+}
+
+/* PRIVATE ROW FILLING FUNCTIONS
+ *   fill_row_info
+ *   fill_row_info_free
+ *   fill_row
+ *   unfill_row
+ *   unfill_excess_rows
+ */
+struct _FillRowInfo
+{
+  GtkCListFillRowFunc func;
+  gpointer data;
+  guint max_filled;
+
+  /* the rows that are filled in, most recently needed first, and
+   * the list element for each row */
+  GList *filled;
+  GList *last_filled;
+  GHashTable *nodes;
+};
+
+static FillRowInfo *
+fill_row_info (GtkCList *clist)
+{
+  return gtk_object_get_data (GTK_OBJECT (clist), "fill_row_info");
+}
+
+static void
+fill_row_info_free (gpointer data)
+{
+  FillRowInfo *info = data;
+
+  g_list_free (info->filled);
+  g_hash_table_destroy (info->nodes);
+  g_free (info);
+}
+
+static void
+fill_row (GtkCList    *clist,
+	  FillRowInfo *info,
+	  GtkCListRow *clist_row)
+{
+  GList *node;
+
+  if (!info)
+    return;
+
+  if (clist_row->filled)
+    {
+      /* move it to the front of the list */
+      node = g_hash_table_lookup (info->nodes, clist_row);
+      if (node == info->filled)
+	return;
+      if (node == info->last_filled)
+	info->last_filled = node->prev;
+      info->filled = g_list_remove_link (info->filled, node);
+      node->next = info->filled;
+      info->filled->prev = node;
+      info->filled = node;
+      return;
+    }
+
+  if (!clist_row->needs_fill)
+    return;
+
+  info->func (clist, clist_row, info->data);
+  if (clist_row->needs_fill)
+    return;	/* the fill function couldn't fill it in */
+
+  clist_row->filled = TRUE;
+  info->filled = g_list_prepend (info->filled, clist_row);
+  if (!info->last_filled)
+    info->last_filled = info->filled;
+  g_hash_table_insert (info->nodes, clist_row, info->filled);
+
+  unfill_excess_rows (clist, info);
+}
+
+static void
+unfill_row (GtkCList    *clist,
+	    FillRowInfo *info,
+	    GtkCListRow *clist_row)
+{
+  GList *node;
+  gboolean blocked;
+  gint i;
+
+  node = g_hash_table_lookup (info->nodes, clist_row);
+  g_hash_table_remove (info->nodes, clist_row);
+  if (node == info->last_filled)
+    info->last_filled = node->prev;
+  info->filled = g_list_remove_link (info->filled, node);
+  g_list_free_1 (node);
+
+  /* emptying a cell as wide as its column would make the column
+   * look at every row to see if it can shrink */
+  blocked = GTK_CLIST_AUTO_RESIZE_BLOCKED (clist);
+  GTK_CLIST_SET_FLAG (clist, CLIST_AUTO_RESIZE_BLOCKED);
+  for (i = 0; i < clist->columns; i++)
+    GTK_CLIST_CLASS_FW (clist)->set_cell_contents
+      (clist, clist_row, i, GTK_CELL_EMPTY, NULL, 0, NULL, NULL);
+  if (!blocked)
+    GTK_CLIST_UNSET_FLAG (clist, CLIST_AUTO_RESIZE_BLOCKED);
+
+  clist_row->fg_set = FALSE;
+  clist_row->bg_set = FALSE;
+  clist_row->filled = FALSE;
+  clist_row->needs_fill = TRUE;
+}
+
+static void
+unfill_excess_rows (GtkCList    *clist,
+		    FillRowInfo *info)
+{
+  if (info->max_filled == 0)
+    return;
+
+  while (g_hash_table_size (info->nodes) > info->max_filled)
+    unfill_row (clist, info, info->last_filled->data);
+}
+
 /* PRIVATE SORTING FUNCTIONS
  *   default_compare
  *   real_sort_list
@@ -7260,6 +7580,9 @@ default_compare (GtkCList      *clist,
   GtkCListRow *row1 = (GtkCListRow *) ptr1;
   GtkCListRow *row2 = (GtkCListRow *) ptr2;
 
+  gtk_clist_fill_row (clist, row1);
+  gtk_clist_fill_row (clist, row2);
+
   switch (row1->cell[clist->sort_column].type)
     {
     case GTK_CELL_TEXT:
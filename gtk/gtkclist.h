@@ -126,6 +126,9 @@ typedef struct _GtkCellWidget GtkCellWidget;
 typedef gint (*GtkCListCompareFunc) (GtkCList     *clist,
 				     gconstpointer ptr1,
 				     gconstpointer ptr2);
+typedef void (*GtkCListFillRowFunc) (GtkCList     *clist,
+				     GtkCListRow  *clist_row,
+				     gpointer      data);
 
 typedef struct _GtkCListCellInfo GtkCListCellInfo;
 typedef struct _GtkCListDestInfo GtkCListDestInfo;
@@ -352,6 +355,8 @@ struct _GtkCListRow
   guint fg_set     : 1;
   guint bg_set     : 1;
   guint selectable : 1;
+  guint needs_fill : 1;
+  guint filled     : 1;
 };
 
 /* Cell Structures */
@@ -777,6 +782,41 @@ void gtk_clist_sort (GtkCList *clist);
 void gtk_clist_set_auto_sort (GtkCList *clist,
 			      gboolean  auto_sort);
 
+/* Fill in the contents of rows only when they're needed.  Rows inserted
+ * after this is called are left empty; when one is drawn, sorted, or its
+ * text is asked for, "fill_func" is called to set its contents with
+ * "gtk_clist_set_row_contents ()".  No more than "max_filled" rows are
+ * kept filled in; the ones least recently needed are emptied again to
+ * make room.  A "max_filled" of 0 means there's no limit. */
+void gtk_clist_set_fill_row_func (GtkCList            *clist,
+				  GtkCListFillRowFunc  fill_func,
+				  gpointer             data,
+				  guint                max_filled);
+
+/* change the number of rows kept filled in */
+void gtk_clist_set_fill_row_limit (GtkCList *clist,
+				   guint     max_filled);
+
+/* set the text and colors of a row; called by the fill function */
+void gtk_clist_set_row_contents (GtkCList    *clist,
+				 GtkCListRow *clist_row,
+				 gchar       *text[],
+				 GdkColor    *foreground,
+				 GdkColor    *background);
+
+/* fill in a row, or "count" rows starting at "row", if they're empty */
+void gtk_clist_fill_row (GtkCList    *clist,
+			 GtkCListRow *clist_row);
+void gtk_clist_fill_rows (GtkCList *clist,
+			  gint      row,
+			  gint      count);
+
+/* empty a row, or all rows, so that they're filled in again when
+ * they're next needed */
+void gtk_clist_unfill_row (GtkCList *clist,
+			   gint      row);
+void gtk_clist_unfill_rows (GtkCList *clist);
+
 
 #ifdef __cplusplus
 }
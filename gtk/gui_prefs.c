@@ -65,6 +65,7 @@ static void fetch_colors(void);
 #define HEX_DUMP_HIGHLIGHT_STYLE_KEY	"hex_dump_highlight_style"
 #define GEOMETRY_POSITION_KEY		"geometry_position"
 #define GEOMETRY_SIZE_KEY		"geometry_size"
+#define INDEX_FIELDS_KEY		"index_fields"
 
 #define FONT_DIALOG_PTR_KEY	"font_dialog_ptr"
 #define FONT_CALLER_PTR_KEY	"font_caller_ptr"
@@ -123,7 +124,7 @@ static gboolean font_changed;
    has been set to the name of the font the user selected. */
 static gchar *new_font_name;
 
-#define GUI_TABLE_ROWS 8
+#define GUI_TABLE_ROWS 9
 GtkWidget*
 gui_prefs_show(void)
 {
@@ -132,6 +133,7 @@ gui_prefs_show(void)
 	GtkWidget	*ptree_browse_om, *line_style_om;
 	GtkWidget	*expander_style_om, *highlight_style_om;
 	GtkWidget	*save_position_cb, *save_size_cb;
+	GtkWidget	*index_fields_cb;
 
 	/* The colors or font haven't been changed yet. */
 	colors_changed = FALSE;
@@ -206,6 +208,13 @@ gui_prefs_show(void)
 	gtk_object_set_data(GTK_OBJECT(main_vb), GEOMETRY_SIZE_KEY,
 	    save_size_cb);
 
+	/* Field index */
+	index_fields_cb = create_preference_check_button(main_tb,
+	    8, "Index common fields for fast filtering:", NULL,
+	    prefs.gui_index_fields);
+	gtk_object_set_data(GTK_OBJECT(main_vb), INDEX_FIELDS_KEY,
+	    index_fields_cb);
+
 	/* "Font..." button - click to open a font selection dialog box. */
 	font_bt = gtk_button_new_with_label("Font...");
 	gtk_signal_connect(GTK_OBJECT(font_bt), "clicked",
@@ -413,6 +422,9 @@ gui_prefs_fetch(GtkWidget *w)
 	prefs.gui_geometry_save_size = 
 	    gtk_toggle_button_get_active(gtk_object_get_data(GTK_OBJECT(w),
 	    	GEOMETRY_SIZE_KEY));
+	prefs.gui_index_fields =
+	    gtk_toggle_button_get_active(gtk_object_get_data(GTK_OBJECT(w),
+	    	INDEX_FIELDS_KEY));
 
 	if (font_changed) {
 		if (prefs.gui_font_name != NULL)
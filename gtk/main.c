@@ -577,21 +577,63 @@ filter_reset_cb(GtkWidget *w, gpointer data)
   filter_packets(&cfile, NULL);
 }
 
+/* How often, in milliseconds, to check for host names found by the
+   background resolver. */
+#define RESOLV_UPDATE_PERIOD	500
+
+static gint
+resolv_update_cb(gpointer data)
+{
+  static gboolean names_found = FALSE;
+
+  if (host_name_lookup_process())
+    names_found = TRUE;
+
+  /* Don't rebuild the packet list while it's being built. */
+  if (names_found && cfile.state == FILE_READ_DONE) {
+    names_found = FALSE;
+    update_packet_names(&cfile);
+  }
+  return TRUE;
+}
+
 /* GTKClist compare routine, overrides default to allow numeric comparison */
 static gint
 packet_list_compare(GtkCList *clist, gconstpointer  ptr1, gconstpointer  ptr2)
 {
+  GtkCListRow *row1 = (GtkCListRow *)ptr1;
+  GtkCListRow *row2 = (GtkCListRow *)ptr2;
+  char   *text1, *text2;
+  double  num1, num2;
+  gint  col_fmt = cfile.cinfo.col_fmt[clist->sort_column];
+
+  /* The frame number is in the row data; don't bother filling in the
+     rows to get it. */
+  if (col_fmt == COL_NUMBER) {
+    guint32 fnum1 = ((frame_data *)row1->data)->num;
+    guint32 fnum2 = ((frame_data *)row2->data)->num;
+
+    if (fnum1 < fnum2)
+      return -1;
+    else if (fnum1 > fnum2)
+      return 1;
+    else
+      return 0;
+  }
+
   /* Get row text strings */
-  char *text1 = GTK_CELL_TEXT (((GtkCListRow *)ptr1)->cell[clist->sort_column])->text;
-  char *text2 = GTK_CELL_TEXT (((GtkCListRow *)ptr2)->cell[clist->sort_column])->text;
+  gtk_clist_fill_row(clist, row1);
+  gtk_clist_fill_row(clist, row2);
+  text1 = (row1->cell[clist->sort_column].type == GTK_CELL_TEXT) ?
+    GTK_CELL_TEXT (row1->cell[clist->sort_column])->text : NULL;
+  text2 = (row2->cell[clist->sort_column].type == GTK_CELL_TEXT) ?
+    GTK_CELL_TEXT (row2->cell[clist->sort_column])->text : NULL;
 
   /* Attempt to convert to numbers */
-  double  num1 = atof(text1);
-  double  num2 = atof(text2);
-  
-  gint  col_fmt = cfile.cinfo.col_fmt[clist->sort_column];
+  num1 = (text1 != NULL) ? atof(text1) : 0;
+  num2 = (text2 != NULL) ? atof(text2) : 0;
   
-  if ((col_fmt == COL_NUMBER) || (col_fmt == COL_REL_TIME) || (col_fmt == COL_DELTA_TIME) ||
+  if ((col_fmt == COL_REL_TIME) || (col_fmt == COL_DELTA_TIME) ||
       ((col_fmt == COL_CLS_TIME) && (timestamp_type == RELATIVE)) ||
       ((col_fmt == COL_CLS_TIME) && (timestamp_type == DELTA))    ||
       (col_fmt == COL_UNRES_SRC_PORT) || (col_fmt == COL_UNRES_DST_PORT) ||
@@ -652,28 +694,29 @@ packet_list_click_column_cb(GtkCList *clist, gint column, gpointer data)
   }
   gtk_clist_thaw(clist);
 
+  /* Sorting on anything but the frame number needs the text of every
+     row, so keep all the rows filled in while we sort, rather than
+     filling them in over and over again. */
+  if (cfile.cinfo.col_fmt[column] != COL_NUMBER)
+    gtk_clist_set_fill_row_limit(clist, 0);
   gtk_clist_sort(clist);
+  if (cfile.cinfo.col_fmt[column] != COL_NUMBER)
+    gtk_clist_set_fill_row_limit(clist, PACKET_LIST_FILLED_ROWS);
 }
 
 /* mark packets */
 static void 
 set_frame_mark(gboolean set, frame_data *frame, gint row) {
-  GdkColor fg, bg;
-
   if (row == -1)
     return;
-  if (set) {
+  if (set)
     mark_frame(&cfile, frame);
-    color_t_to_gdkcolor(&fg, &prefs.gui_marked_fg);
-    color_t_to_gdkcolor(&bg, &prefs.gui_marked_bg);
-  } else {
+  else
     unmark_frame(&cfile, frame);
-    fg = BLACK;
-    bg = WHITE;
-  }
   file_set_save_marked_sensitive();
-  gtk_clist_set_background(GTK_CLIST(packet_list), row, &bg);
-  gtk_clist_set_foreground(GTK_CLIST(packet_list), row, &fg);
+
+  /* Have the row filled in again, with the colors for its new state. */
+  gtk_clist_unfill_row(GTK_CLIST(packet_list), row);
 }
 
 static void
@@ -704,8 +747,10 @@ void mark_frame_cb(GtkWidget *w, gpointer data) {
 }
 
 static void mark_all_frames(gboolean set) {
+  guint32 framenum;
   frame_data *fdata;
-  for (fdata = cfile.plist; fdata != NULL; fdata = fdata->next) {
+  for (framenum = 1; (fdata = cf_get_frame(&cfile, framenum)) != NULL;
+       framenum++) {
     set_frame_mark(set,
 		   fdata,
 		   gtk_clist_find_row_from_data(GTK_CLIST(packet_list), fdata));    
@@ -713,9 +758,11 @@ static void mark_all_frames(gboolean set) {
 }
 
 void update_marked_frames(void) {
+  guint32 framenum;
   frame_data *fdata;
-  if (cfile.plist == NULL) return;
-  for (fdata = cfile.plist; fdata != NULL; fdata = fdata->next) {
+  if (cfile.count == 0) return;
+  for (framenum = 1; (fdata = cf_get_frame(&cfile, framenum)) != NULL;
+       framenum++) {
     if (fdata->flags.marked)
       set_frame_mark(TRUE,
 		     fdata,
@@ -1322,8 +1369,7 @@ main(int argc, char *argv[])
   read_filter_list(DFILTER_LIST, &df_path, &df_open_errno);
 
   /* Initialize the capture file struct */
-  cfile.plist		= NULL;
-  cfile.plist_end	= NULL;
+  cfile.plist_chunks	= NULL;
   cfile.wth		= NULL;
   cfile.filename	= NULL;
   cfile.user_saved	= FALSE;
@@ -1331,6 +1377,8 @@ main(int argc, char *argv[])
   cfile.rfcode		= NULL;
   cfile.dfilter		= NULL;
   cfile.dfcode		= NULL;
+  cfile.dfresults	= NULL;
+  cfile.findex		= NULL;
 #ifdef HAVE_LIBPCAP
   cfile.cfilter		= g_strdup(EMPTY_FILTER);
 #endif
@@ -1411,7 +1459,7 @@ main(int argc, char *argv[])
 #endif
 
   /* Now get our args */
-  while ((opt = getopt(argc, argv, "a:b:B:c:f:hi:klm:nN:o:pP:Qr:R:Ss:t:T:w:W:vZ:")) !=  EOF) {
+  while ((opt = getopt(argc, argv, "a:b:B:c:f:hi:klm:nN:o:pP:Qr:R:Ss:t:T:w:W:vY:Z:")) !=  EOF) {
     switch (opt) {
       case 'a':        /* autostop criteria */
 #ifdef HAVE_LIBPCAP
@@ -1604,6 +1652,14 @@ main(int argc, char *argv[])
 #else
         capture_option_specified = TRUE;
         arg_error = TRUE;
+#endif
+	break;
+      case 'Y':        /* Copy captured packets to live feed FD xxx */
+#ifdef HAVE_LIBPCAP
+        live_feed_fd = atoi(optarg);
+#else
+        capture_option_specified = TRUE;
+        arg_error = TRUE;
 #endif
 	break;
 
@@ -1820,8 +1876,14 @@ main(int argc, char *argv[])
      to a file that our parent will read? */
   if (!capture_child) {
 #endif
-    /* No.  Pop up the main window, and read in a capture file if
-       we were told to. */
+    /* No.  Look up host names in the background, rather than waiting
+       for each of them while reading packets, and update the packet
+       list as they're found. */
+    if (host_name_lookup_init())
+      gtk_timeout_add(RESOLV_UPDATE_PERIOD, resolv_update_cb, NULL);
+
+    /* Pop up the main window, and read in a capture file if we were
+       told to. */
 
     create_main_window(pl_size, tv_size, bv_size, prefs);
     set_menus_for_capture_file(FALSE);
@@ -2003,6 +2065,7 @@ main(int argc, char *argv[])
 		}
 	}
 	
+  host_name_lookup_cleanup();
   epan_cleanup();
   g_free(rc_file);
 
@@ -2268,6 +2331,7 @@ create_main_window (gint pl_size, gint tv_size, gint bv_size, e_prefs *prefs)
   gtk_signal_connect(GTK_OBJECT(packet_list), "button_press_event",
 		     GTK_SIGNAL_FUNC(packet_list_button_pressed_cb), NULL);
   gtk_clist_set_compare_func(GTK_CLIST(packet_list), packet_list_compare);
+  set_packet_list_fill_func(&cfile);
   gtk_widget_show(packet_list);
 
   /* Tree view */
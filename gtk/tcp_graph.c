@@ -1736,6 +1736,7 @@ static void graph_destroy (struct graph *g)
 /* here we collect all the external data we will ever need */
 static void graph_segment_list_get (struct graph *g)
 {
+	guint32 framenum;
 	frame_data *ptr;
 	char pd[4096];
 	struct segment *segment=NULL, *last=NULL;
@@ -1749,7 +1750,7 @@ static void graph_segment_list_get (struct graph *g)
 	else
 		condition = COMPARE_ANY_DIR;
 
-	for (ptr=cfile.plist; ptr; ptr=ptr->next) {
+	for (framenum=1; (ptr=cf_get_frame(&cfile, framenum)); framenum++) {
 		wtap_seek_read (cfile.wth, ptr->file_off, &cfile.pseudo_header,
 							pd, 4096);
 		if (!segment)
@@ -130,26 +130,52 @@ is_earlier(struct timeval *l, struct timeval *r) {
 
 
 /*
- * returns index of earliest timestamp in set of input files
- * or -1 if no valid files remain
+ * returns TRUE if the frame read from the first input file should be
+ * written before the one read from the second
  */
-static int
-earliest(int count, in_file_t in_files[]) {
-  int i;
-  int ei = -1;
-  struct timeval tv = {LONG_MAX, LONG_MAX};
+static gboolean
+frame_earlier(in_file_t in_files[], int l, int r)
+{
+  struct timeval *lts = &(wtap_phdr(in_files[l].wth)->ts);
+  struct timeval *rts = &(wtap_phdr(in_files[r].wth)->ts);
 
-  for (i = 0; i < count; i++) {
-    struct wtap_pkthdr *phdr = wtap_phdr(in_files[i].wth);
+  if (lts->tv_sec != rts->tv_sec || lts->tv_usec != rts->tv_usec)
+    return is_earlier(lts, rts);
+  /* frames with the same timestamp come from the last file first */
+  return l > r;
+}
 
-    if (in_files[i].ok && is_earlier(&(phdr->ts), &tv)) {
-      tv = phdr->ts;
-      ei = i;
-    }
+
+/*
+ * The input files that still have frames are kept in a heap, ordered
+ * by the timestamp of the frame last read from each, so that the file
+ * with the earliest frame is at the top; finding it takes constant
+ * time, and putting it back after reading its next frame takes time
+ * logarithmic in the number of files, rather than linear.
+ *
+ * If that next frame is still the earliest, as it is for all but the
+ * last frame of each file when the files don't overlap in time (e.g.,
+ * a set of files from a ring buffer capture), putting the file back
+ * takes only a comparison with the top's two children, so merging such
+ * files costs about as much as appending them.
+ */
+static void
+sift_down(int heap[], int n, int pos, in_file_t in_files[])
+{
+  int top = heap[pos];
+  int child;
+
+  while ((child = 2*pos + 1) < n) {
+    if (child + 1 < n && frame_earlier(in_files, heap[child + 1], heap[child]))
+      child++;
+    if (!frame_earlier(in_files, heap[child], top))
+      break;
+    heap[pos] = heap[child];
+    pos = child;
   }
-  return ei;
+  heap[pos] = top;
 }
- 
+
 /*
  * actually merge the files
  */
@@ -157,16 +183,32 @@ static void
 merge(int count, in_file_t in_files[], out_file_t *out_file)
 {
   int i;
+  int *heap;
+  int n;
+  int heap_size = count * sizeof(int);
+
+  heap = malloc(heap_size);
+  if (!heap) {
+    fprintf(stderr, "mergecap: error allocating %d bytes of memory\n",
+            heap_size);
+    exit(1);
+  }
 
   /* prime the pump (read in first frame from each file) */
+  n = 0;
   for (i = 0; i < count; i++) {
     in_files[i].ok = wtap_read(in_files[i].wth, &(in_files[i].err),
                                &(in_files[i].data_offset));
+    if (in_files[i].ok)
+      heap[n++] = i;
   }
+  for (i = n/2 - 1; i >= 0; i--)
+    sift_down(heap, n, i, in_files);
 
   /* now keep writing the earliest frame until we're out of frames */
-  while ( -1 != (i = earliest(count, in_files))) {
-    
+  while (n > 0) {
+    i = heap[0];
+
     /* write out earliest frame, and fetch another from its
      * input file
      */
@@ -177,7 +219,12 @@ merge(int count, in_file_t in_files[], out_file_t *out_file)
                 wtap_buf_ptr(in_files[i].wth));
     in_files[i].ok = wtap_read(in_files[i].wth, &(in_files[i].err),
                                 &(in_files[i].data_offset));
+    if (!in_files[i].ok)
+      heap[0] = heap[--n];
+    sift_down(heap, n, 0, in_files);
   }
+
+  free(heap);
 }
 
 
@@ -67,8 +67,6 @@ static gboolean tcp_summary_in_tree = TRUE;
  */
 static gboolean tcp_check_checksum = TRUE;
 
-extern FILE* data_out_file;
-
 static int proto_tcp = -1;
 static int hf_tcp_srcport = -1;
 static int hf_tcp_dstport = -1;
@@ -1191,7 +1189,7 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)
     }
   }
  
-  if( data_out_file ) {
+  if( follow_data ) {
     reassemble_tcp( th_seq,		/* sequence number */
         seglen,				/* data length */
         tvb_get_ptr(tvb, offset, length_remaining),	/* data */
@@ -800,6 +800,8 @@ read_prefs(int *gpf_errno_return, char **gpf_path_return,
     prefs.gui_geometry_main_y        =        20;
     prefs.gui_geometry_main_width    = DEF_WIDTH;
     prefs.gui_geometry_main_height   =        -1;
+    prefs.gui_index_fields           =     FALSE;
+    prefs.gui_reassembly_mem_limit   =         0;
 
 /* set the default values for the capture dialog box */
     prefs.capture_device      = NULL;
@@ -1063,6 +1065,8 @@ prefs_set_pref(char *prefarg)
 #define PRS_GUI_GEOMETRY_MAIN_Y        "gui.geometry.main.y"
 #define PRS_GUI_GEOMETRY_MAIN_WIDTH    "gui.geometry.main.width"
 #define PRS_GUI_GEOMETRY_MAIN_HEIGHT   "gui.geometry.main.height"
+#define PRS_GUI_INDEX_FIELDS           "gui.index_fields"
+#define PRS_GUI_REASSEMBLY_MEM_LIMIT   "gui.reassembly_memory_limit"
 
 /*
  * This applies to more than just captures, so it's not "capture.name_resolve";
@@ -1323,6 +1327,10 @@ set_pref(gchar *pref_name, gchar *value)
     prefs.gui_geometry_main_width = strtol(value, NULL, 10);
   } else if (strcmp(pref_name, PRS_GUI_GEOMETRY_MAIN_HEIGHT) == 0) {
     prefs.gui_geometry_main_height = strtol(value, NULL, 10);
+  } else if (strcmp(pref_name, PRS_GUI_INDEX_FIELDS) == 0) {
+    prefs.gui_index_fields = ((strcasecmp(value, "true") == 0)?TRUE:FALSE);
+  } else if (strcmp(pref_name, PRS_GUI_REASSEMBLY_MEM_LIMIT) == 0) {
+    prefs.gui_reassembly_mem_limit = strtoul(value, NULL, 10);
 
 /* handle the capture options */ 
   } else if (strcmp(pref_name, PRS_CAP_DEVICE) == 0) {
@@ -1752,6 +1760,15 @@ write_prefs(const char **pf_path_return)
   fprintf(pf, PRS_GUI_GEOMETRY_MAIN_HEIGHT ": %d\n",
   		  prefs.gui_geometry_main_height);
 
+  fprintf(pf, "\n# Index commonly-filtered-on fields when reading a capture file? TRUE/FALSE\n");
+  fprintf(pf, PRS_GUI_INDEX_FIELDS ": %s\n",
+		  prefs.gui_index_fields == TRUE ? "TRUE" : "FALSE");
+
+  fprintf(pf, "\n# Kilobytes of reassembled data to keep in memory; 0 means no limit.\n");
+  fprintf(pf, "# Reassembled data beyond the limit is read again from the capture file when needed.\n");
+  fprintf(pf, PRS_GUI_REASSEMBLY_MEM_LIMIT ": %u\n",
+		  prefs.gui_reassembly_mem_limit);
+
   fprintf(pf, "\n# Resolve addresses to names? TRUE/FALSE/{list of address types to resolve}\n");
   fprintf(pf, PRS_NAME_RESOLVE ": %s\n",
 		  name_resolve_to_string(prefs.name_resolve));
@@ -1824,6 +1841,8 @@ copy_prefs(e_prefs *dest, e_prefs *src)
   dest->gui_geometry_main_y = src->gui_geometry_main_y;
   dest->gui_geometry_main_width = src->gui_geometry_main_width;
   dest->gui_geometry_main_height = src->gui_geometry_main_height;
+  dest->gui_index_fields = src->gui_index_fields;
+  dest->gui_reassembly_mem_limit = src->gui_reassembly_mem_limit;
 /*  values for the capture dialog box */
   dest->capture_device = g_strdup(src->capture_device);
   dest->capture_prom_mode = src->capture_prom_mode;
@@ -67,6 +67,8 @@ typedef struct _e_prefs {
   gint     gui_geometry_main_y;
   gint     gui_geometry_main_width;
   gint     gui_geometry_main_height;
+  gboolean gui_index_fields;
+  guint32  gui_reassembly_mem_limit;
   guint32  name_resolve;
   gchar   *capture_device;
   gboolean capture_prom_mode;
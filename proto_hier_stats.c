@@ -127,14 +127,15 @@ process_frame(frame_data *frame, column_info *cinfo, ph_stats_t* ps)
 	epan_dissect_t			*edt;
 	union wtap_pseudo_header	phdr;
 	guint8				pd[WTAP_MAX_PACKET_SIZE];
+	const guint8			*data;
 
 	/* Load the frame from the capture file */
-	wtap_seek_read(cfile.wth, frame->file_off, &phdr,
+	data = wtap_seek_read_data(cfile.wth, frame->file_off, &phdr,
 			pd, frame->cap_len);
 
 	/* Dissect the frame */
 	edt = epan_dissect_new(TRUE, FALSE);
-    epan_dissect_run(edt, &phdr, pd, frame, cinfo);
+    epan_dissect_run(edt, &phdr, data, frame, cinfo);
 
 	/* Get stats from this protocol tree */
 	process_tree(edt->tree, ps, frame->pkt_len);
@@ -149,6 +150,7 @@ ph_stats_t*
 ph_stats_new(void)
 {
 	ph_stats_t	*ps;
+	guint32		framenum;
 	frame_data	*frame;
 	guint		tot_packets, tot_bytes;
 	progdlg_t	*progbar;
@@ -178,7 +180,8 @@ ph_stats_new(void)
 	tot_packets = 0;
 	tot_bytes = 0;
 
-	for (frame = cfile.plist; frame != NULL; frame = frame->next) {
+	for (framenum = 1; (frame = cf_get_frame(&cfile, framenum)) != NULL;
+	    framenum++) {
 		/* Update the progress bar, but do it only N_PROGBAR_UPDATES
 		   times; when we update it, we have to run the GTK+ main
 		   loop to get it to repaint what's pending, and doing so
@@ -96,6 +96,298 @@ fragment_hash(gconstpointer k)
 	return hash_val;
 }
 
+/*
+ * Reassembled packets whose data can be freed, to stay within the memory
+ * limit, and made up again from the fragments in the capture file.
+ *
+ * Those whose data is in memory are on a list, most recently used first.
+ * Each dissection that's handed a reassembled packet holds a reference
+ * to it until the dissection is freed, as tvbuffs created by the
+ * dissection might point to the data; the data for a packet is freed
+ * only if there are no references to it.
+ */
+typedef struct _reassembled_pdu {
+	fragment_data *fd_head;	/* NULL if the packet was deleted */
+	guint32	size;		/* size of the reassembled data */
+	guint	refcount;	/* number of dissections using it */
+	struct _reassembled_pdu *prev;
+	struct _reassembled_pdu *next;
+} reassembled_pdu;
+
+static reassemble_frame_reader frame_reader = NULL;
+static gpointer frame_reader_data;
+
+static guint32 pdu_mem_limit = 0;
+static guint32 pdu_mem_used = 0;
+
+/* fd_head -> reassembled_pdu */
+static GHashTable *reassembled_pdus = NULL;
+
+/* packet_info for a dissection -> list of the reassembled_pdus it uses */
+static GHashTable *pdu_refs = NULL;
+
+static reassembled_pdu *pdu_lru_first = NULL;
+static reassembled_pdu *pdu_lru_last = NULL;
+
+static void
+pdu_lru_unlink(reassembled_pdu *pdu)
+{
+	if (pdu->prev != NULL)
+		pdu->prev->next = pdu->next;
+	else
+		pdu_lru_first = pdu->next;
+	if (pdu->next != NULL)
+		pdu->next->prev = pdu->prev;
+	else
+		pdu_lru_last = pdu->prev;
+	pdu->prev = pdu->next = NULL;
+}
+
+static void
+pdu_lru_push(reassembled_pdu *pdu)
+{
+	pdu->prev = NULL;
+	pdu->next = pdu_lru_first;
+	if (pdu_lru_first != NULL)
+		pdu_lru_first->prev = pdu;
+	else
+		pdu_lru_last = pdu;
+	pdu_lru_first = pdu;
+}
+
+/*
+ * Free the data of least recently used packets that no dissection is
+ * using until we're within the limit.
+ */
+static void
+pdu_evict(void)
+{
+	reassembled_pdu *pdu, *prev;
+
+	if (pdu_mem_limit == 0)
+		return;
+	for (pdu = pdu_lru_last; pdu != NULL && pdu_mem_used > pdu_mem_limit;
+	    pdu = prev) {
+		prev = pdu->prev;
+		if (pdu->refcount != 0)
+			continue;
+		g_free(pdu->fd_head->data);
+		pdu->fd_head->data = NULL;
+		pdu_mem_used -= pdu->size;
+		pdu_lru_unlink(pdu);
+	}
+}
+
+/*
+ * Make up the data for a packet again, from the fragments in the frames
+ * in which they arrived.  This is done the same way "fragment_add()" and
+ * "fragment_add_seq()" did it, using only the fragments they used.
+ *
+ * XXX - if a frame can't be read, that part of the data is left zeroed.
+ */
+static void
+pdu_rebuild(reassembled_pdu *pdu)
+{
+	fragment_data *fd_head = pdu->fd_head;
+	fragment_data *fd_i, *last_fd;
+	const guint8 *frame;
+	guint32 dfpos, skip, len;
+
+	fd_head->data = g_malloc0(pdu->size);
+	last_fd = NULL;
+	for (dfpos = 0, fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		if (fd_i->len == 0 || fd_i->flags & FD_AFTER_DEFRAGMENTED)
+			continue;
+		if (fd_head->flags & FD_BLOCKSEQUENCE) {
+			if (last_fd != NULL && last_fd->offset == fd_i->offset)
+				continue;
+			last_fd = fd_i;
+			skip = 0;
+		} else {
+			if (fd_i->offset + fd_i->len <= dfpos)
+				continue;
+			skip = dfpos - fd_i->offset;
+		}
+		len = MIN(fd_i->len - skip, pdu->size - dfpos);
+		frame = (*frame_reader)(fd_i->frame, frame_reader_data);
+		if (frame != NULL) {
+			memcpy(fd_head->data + dfpos,
+			    frame + fd_i->frame_offset + skip, len);
+		}
+		dfpos += len;
+		if (dfpos == pdu->size)
+			break;
+	}
+	pdu_mem_used += pdu->size;
+	pdu_lru_push(pdu);
+}
+
+/*
+ * Start keeping track of a packet that's just been defragmented, with
+ * "size" bytes of data, if its data can be made up again from the
+ * frames.
+ */
+static void
+pdu_track(fragment_data *fd_head, guint32 size)
+{
+	fragment_data *fd_i;
+	reassembled_pdu *pdu;
+
+	if (frame_reader == NULL)
+		return;
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		if (fd_i->len != 0 && fd_i->frame_offset == FRAME_OFFSET_UNKNOWN
+		    && !(fd_i->flags & FD_AFTER_DEFRAGMENTED))
+			return;
+	}
+	pdu = g_new(reassembled_pdu, 1);
+	pdu->fd_head = fd_head;
+	pdu->size = size;
+	pdu->refcount = 0;
+	g_hash_table_insert(reassembled_pdus, fd_head, pdu);
+	pdu_mem_used += size;
+	pdu_lru_push(pdu);
+}
+
+/*
+ * Stop keeping track of a packet, because it's being deleted or
+ * reassembled again; its data is made up again if it was freed.
+ */
+static void
+pdu_forget(fragment_data *fd_head)
+{
+	reassembled_pdu *pdu;
+
+	if (frame_reader == NULL)
+		return;
+	pdu = g_hash_table_lookup(reassembled_pdus, fd_head);
+	if (pdu == NULL)
+		return;
+	if (fd_head->data == NULL)
+		pdu_rebuild(pdu);
+	g_hash_table_remove(reassembled_pdus, fd_head);
+	pdu_mem_used -= pdu->size;
+	pdu_lru_unlink(pdu);
+	if (pdu->refcount != 0) {
+		/* Dissections still refer to it; "pdu_release()" frees it. */
+		pdu->fd_head = NULL;
+	} else
+		g_free(pdu);
+}
+
+/*
+ * A defragmented packet is being handed to a dissection; make sure its
+ * data is in memory, and keep it there until the dissection is freed.
+ */
+static fragment_data *
+pdu_use(fragment_data *fd_head, packet_info *pinfo)
+{
+	reassembled_pdu *pdu;
+	GSList *refs;
+
+	if (frame_reader == NULL)
+		return fd_head;
+	pdu = g_hash_table_lookup(reassembled_pdus, fd_head);
+	if (pdu == NULL)
+		return fd_head;
+	if (fd_head->data == NULL)
+		pdu_rebuild(pdu);
+	else if (pdu != pdu_lru_first) {
+		pdu_lru_unlink(pdu);
+		pdu_lru_push(pdu);
+	}
+	pdu->refcount++;
+	refs = g_hash_table_lookup(pdu_refs, pinfo);
+	g_hash_table_insert(pdu_refs, pinfo, g_slist_prepend(refs, pdu));
+	pdu_evict();
+	return fd_head;
+}
+
+static void
+pdu_unref(gpointer data, gpointer user_data)
+{
+	reassembled_pdu *pdu = data;
+
+	pdu->refcount--;
+	if (pdu->refcount == 0 && pdu->fd_head == NULL)
+		g_free(pdu);
+}
+
+/*
+ * Called when a dissection is freed; drop its references.
+ */
+static void
+pdu_release(packet_info *pinfo)
+{
+	GSList *refs;
+
+	if (pdu_refs == NULL)
+		return;
+	refs = g_hash_table_lookup(pdu_refs, pinfo);
+	if (refs == NULL)
+		return;
+	g_hash_table_remove(pdu_refs, pinfo);
+	g_slist_foreach(refs, pdu_unref, NULL);
+	g_slist_free(refs);
+	pdu_evict();
+}
+
+static gboolean
+free_pdu_refs(gpointer key, gpointer value, gpointer user_data)
+{
+	g_slist_foreach(value, pdu_unref, NULL);
+	g_slist_free(value);
+	return TRUE;
+}
+
+static gboolean
+free_pdu(gpointer key, gpointer value, gpointer user_data)
+{
+	g_free(value);
+	return TRUE;
+}
+
+void
+reassemble_set_frame_reader(reassemble_frame_reader reader, gpointer data)
+{
+	frame_reader = reader;
+	frame_reader_data = data;
+}
+
+void
+reassemble_set_memory_limit(guint32 limit)
+{
+	pdu_mem_limit = limit;
+	pdu_evict();
+}
+
+/*
+ * Find where a fragment's data is in the raw data for the frame, if
+ * it's there, so that it can be read again from the capture file.
+ */
+static guint32
+fragment_frame_offset(tvbuff_t *tvb, int offset, guint32 len,
+    packet_info *pinfo)
+{
+	tvbuff_t *frame_tvb;
+	const guint8 *frame_data, *frag_data;
+	guint frame_len;
+
+	if (frame_reader == NULL || pinfo->fd->data_src == NULL)
+		return FRAME_OFFSET_UNKNOWN;
+	if (len == 0 || !tvb_bytes_exist(tvb, offset, len))
+		return FRAME_OFFSET_UNKNOWN;
+	frame_tvb = pinfo->fd->data_src->data;
+	frame_len = tvb_length(frame_tvb);
+	if (frame_len == 0)
+		return FRAME_OFFSET_UNKNOWN;
+	frame_data = tvb_get_ptr(frame_tvb, 0, frame_len);
+	frag_data = tvb_get_ptr(tvb, offset, len);
+	if (frag_data < frame_data || frag_data + len > frame_data + frame_len)
+		return FRAME_OFFSET_UNKNOWN;
+	return frag_data - frame_data;
+}
+
 /*
  * For a hash table entry, free the address data to which the key refers
  * and the fragment data to which the value refers.
@@ -162,6 +454,22 @@ fragment_table_init(GHashTable **fragment_table)
 void
 reassemble_init(void)
 {
+	/*
+	 * The data for the reassembled packets has been freed along
+	 * with the fragment tables, so forget about all of them.
+	 */
+	if (pdu_refs != NULL) {
+		g_hash_table_foreach_remove(pdu_refs, free_pdu_refs, NULL);
+		g_hash_table_foreach_remove(reassembled_pdus, free_pdu, NULL);
+	} else {
+		pdu_refs = g_hash_table_new(g_direct_hash, g_direct_equal);
+		reassembled_pdus = g_hash_table_new(g_direct_hash,
+		    g_direct_equal);
+		register_dissect_free_routine(pdu_release);
+	}
+	pdu_lru_first = pdu_lru_last = NULL;
+	pdu_mem_used = 0;
+
 	if (fragment_key_chunk != NULL)
 		g_mem_chunk_destroy(fragment_key_chunk);
 	if (fragment_data_chunk != NULL)
@@ -207,6 +515,7 @@ fragment_delete(packet_info *pinfo, guint32 id, GHashTable *fragment_table)
 		return NULL;
 	}
 
+	pdu_forget(fd_head);
 	data=fd_head->data;
 	/* loop over all partial fragments and free any buffers */
 	for(fd=fd_head->next;fd;){
@@ -239,6 +548,8 @@ fragment_get(packet_info *pinfo, guint32 id, GHashTable *fragment_table)
 	key.id  = id;
 
 	fd_head = g_hash_table_lookup(fragment_table, &key);
+	if (fd_head != NULL && fd_head->flags & FD_DEFRAGMENTED)
+		pdu_use(fd_head, pinfo);
 	
 	return fd_head;
 }
@@ -347,12 +658,16 @@ fragment_add(tvbuff_t *tvb, int offset, packet_info *pinfo, guint32 id,
 	/* have we already seen this frame ?*/
 	if (pinfo->fd->flags.visited) {
 		if (fd_head != NULL && fd_head->flags & FD_DEFRAGMENTED) {
-			return fd_head;
+			return pdu_use(fd_head, pinfo);
 		} else {
 			return NULL;
 		}
 	}
 
+	/* make sure the defragmented data is there to be checked against */
+	if (fd_head != NULL && fd_head->flags & FD_DEFRAGMENTED)
+		pdu_use(fd_head, pinfo);
+
 	if (fd_head==NULL){
 		/* not found, this must be the first snooped fragment for this
                  * packet. Create list-head.
@@ -390,6 +705,8 @@ fragment_add(tvbuff_t *tvb, int offset, packet_info *pinfo, guint32 id,
 	fd->offset = frag_offset;
 	fd->len  = frag_data_len;
 	fd->data = NULL;
+	fd->frame_offset = fragment_frame_offset(tvb, offset, frag_data_len,
+	    pinfo);
 
 	/*
 	 * If it was already defragmented and this new fragment goes beyond
@@ -397,12 +714,14 @@ fragment_add(tvbuff_t *tvb, int offset, packet_info *pinfo, guint32 id,
  	 */
 	if(fd_head->flags & FD_DEFRAGMENTED && (frag_offset+frag_data_len) >= fd_head->datalen &&
 		fd_head->flags & FD_PARTIAL_REASSEMBLY){
+		pdu_forget(fd_head);
 		for(fd_i=fd_head->next; fd_i; fd_i=fd_i->next){
 			if( !fd_i->data ) {
 				fd_i->data = fd_head->data + fd_i->offset;
 				fd_i->flags |= FD_NOT_MALLOCED;
 			}
-			fd_i->flags &= (~FD_TOOLONGFRAGMENT) & (~FD_MULTIPLETAILS);
+			fd_i->flags &= (~FD_TOOLONGFRAGMENT) & (~FD_MULTIPLETAILS)
+			    & (~FD_AFTER_DEFRAGMENTED);
 		}
 		fd_head->flags ^= FD_DEFRAGMENTED|FD_PARTIAL_REASSEMBLY;
 		fd_head->flags &= (~FD_TOOLONGFRAGMENT) & (~FD_MULTIPLETAILS);
@@ -441,7 +760,7 @@ fragment_add(tvbuff_t *tvb, int offset, packet_info *pinfo, guint32 id,
 	 * check it. Someone might play overlap and TTL games.
          */
 	if (fd_head->flags & FD_DEFRAGMENTED) {
-		fd->flags      |= FD_OVERLAP;
+		fd->flags      |= FD_OVERLAP|FD_AFTER_DEFRAGMENTED;
 		fd_head->flags |= FD_OVERLAP;
 		/* make sure its not too long */
 		if (fd->offset + fd->len > fd_head->datalen) {
@@ -551,7 +870,8 @@ fragment_add(tvbuff_t *tvb, int offset, packet_info *pinfo, guint32 id,
            allows us to skip any trailing fragments */
 	fd_head->flags |= FD_DEFRAGMENTED;
 
-	return fd_head;
+	pdu_track(fd_head, max);
+	return pdu_use(fd_head, pinfo);
 }
 
 
@@ -592,12 +912,16 @@ fragment_add_seq(tvbuff_t *tvb, int offset, packet_info *pinfo, guint32 id,
 	/* have we already seen this frame ?*/
 	if (pinfo->fd->flags.visited) {
 		if (fd_head != NULL && fd_head->flags & FD_DEFRAGMENTED) {
-			return fd_head;
+			return pdu_use(fd_head, pinfo);
 		} else {
 			return NULL;
 		}
 	}
 
+	/* make sure the defragmented data is there to be checked against */
+	if (fd_head != NULL && fd_head->flags & FD_DEFRAGMENTED)
+		pdu_use(fd_head, pinfo);
+
 	if (fd_head==NULL){
 		/* not found, this must be the first snooped fragment for this
                  * packet. Create list-head.
@@ -635,6 +959,8 @@ fragment_add_seq(tvbuff_t *tvb, int offset, packet_info *pinfo, guint32 id,
 	fd->offset = frag_offset;
 	fd->len  = frag_data_len;
 	fd->data = NULL;
+	fd->frame_offset = fragment_frame_offset(tvb, offset, frag_data_len,
+	    pinfo);
 
 	if (!more_frags) {  
 		/*
@@ -665,7 +991,7 @@ fragment_add_seq(tvbuff_t *tvb, int offset, packet_info *pinfo, guint32 id,
 	 * check it. Someone might play overlap and TTL games.
          */
 	if (fd_head->flags & FD_DEFRAGMENTED) {
-		fd->flags      |= FD_OVERLAP;
+		fd->flags      |= FD_OVERLAP|FD_AFTER_DEFRAGMENTED;
 		fd_head->flags |= FD_OVERLAP;
 
 		/* make sure its not too long */
@@ -785,5 +1111,6 @@ fragment_add_seq(tvbuff_t *tvb, int offset, packet_info *pinfo, guint32 id,
            allows us to skip any trailing fragments */
 	fd_head->flags |= FD_DEFRAGMENTED;
 
-	return fd_head;
+	pdu_track(fd_head, size);
+	return pdu_use(fd_head, pinfo);
 }
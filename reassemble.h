@@ -51,6 +51,10 @@
    into the defragmented packet */
 #define FD_BLOCKSEQUENCE        0x0100
 
+/* only in fragments: fragment arrived after the packet was defragmented,
+   so it isn't part of the defragmented data */
+#define FD_AFTER_DEFRAGMENTED   0x0200
+
 typedef struct _fragment_data {
 	struct _fragment_data *next;
 	guint32 frame;
@@ -59,8 +63,12 @@ typedef struct _fragment_data {
 	guint32 datalen; /*Only valid in first item of list */
 	guint32 flags;
 	unsigned char *data;
+	guint32 frame_offset; /* offset of the fragment's data in the frame, or
+				 FRAME_OFFSET_UNKNOWN */
 } fragment_data;
 
+#define FRAME_OFFSET_UNKNOWN	0xFFFFFFFF
+
 /*
  * Initialize a fragment table.
  */
@@ -71,6 +79,33 @@ void fragment_table_init(GHashTable **fragment_table);
  */
 void reassemble_init(void);
 
+/*
+ * Routine to get the raw data of frame "frame", as read from the
+ * capture file; it returns NULL if the data can't be read.  The data
+ * need only stay valid until the routine is next called.
+ */
+typedef const guint8 *(*reassemble_frame_reader)(guint32 frame,
+    gpointer data);
+
+/*
+ * Set the routine used to read frames when reassembled data that has
+ * been freed to stay within the memory limit is needed again.  Unless
+ * there's such a routine, reassembled data is never freed before
+ * "reassemble_init()" is called.
+ */
+void reassemble_set_frame_reader(reassemble_frame_reader reader,
+    gpointer data);
+
+/*
+ * Set the number of bytes of reassembled data to keep in memory; 0
+ * means no limit.  Beyond the limit, the data for the least recently
+ * used reassembled packets that no dissection is using is freed, and
+ * made up again from the fragments in the capture file when needed.
+ * Reassembled packets with fragments that aren't in the raw frame data
+ * (e.g., fragments of a reassembled packet) are always kept.
+ */
+void reassemble_set_memory_limit(guint32 limit);
+
 /*
  * This function adds a new fragment to the fragment hash table.
  * If this is the first fragment seen for this datagram, a new entry
@@ -65,6 +65,10 @@
 #define O_BINARY	0
 #endif
 
+/* Size of the buffer for writes to each ringbuffer file; packets are
+   copied into it, and written to the file only when it fills up. */
+#define RINGBUF_WRITE_BUFSIZE	(256*1024)
+
 /* Ringbuffer file structure */
 typedef struct _rb_file {
   gchar*        name;
@@ -74,6 +78,7 @@ typedef struct _rb_file {
   guint16       number;
   wtap_dumper*  pdh;
   long          start_pos;
+  char*         write_buf;      /* buffer for writes to the file */
 } rb_file;
 
 /* Ringbuffer data structure */
@@ -83,6 +88,9 @@ typedef struct _ringbuf_data {
   guint         curr_file_num;  /* Number of the current file */
   gchar*        fprefix;        /* Filename prefix */
   gchar*        fsuffix;        /* Filename suffix */
+  long          file_size;      /* Expected size of a file, or 0 */
+  int           flush_file_num; /* File to flush when idle, or -1 */
+  ringbuf_stats stats;          /* File switch statistics */
 } ringbuf_data; 
 
 /* Create the ringbuffer data structure */
@@ -92,7 +100,7 @@ static ringbuf_data rb_data;
  * Initialize the ringbuffer data structure
  */
 int 
-ringbuf_init(const char *capfile_name, guint num_files)
+ringbuf_init(const char *capfile_name, guint num_files, long file_size)
 {
   int          save_file_fd;
   unsigned int i;
@@ -130,9 +138,13 @@ ringbuf_init(const char *capfile_name, guint num_files)
   /* initialize */
   rb_data.fprefix = NULL;
   rb_data.fsuffix = NULL;
+  rb_data.file_size = file_size;
+  rb_data.flush_file_num = -1;
+  memset(&rb_data.stats, 0, sizeof rb_data.stats);
   for (i=0; i<rb_data.num_files; i++) {
     rb_data.files[i].name = NULL;
     rb_data.files[i].fd = -1;
+    rb_data.files[i].write_buf = NULL;
   }
 
   /* get file name prefix/suffix */
@@ -196,8 +208,10 @@ ringbuf_init_wtap_dump_fdopen(int filetype, int linktype,
   FILE         *fh;
 
   for (i=0; i<rb_data.num_files; i++) {
-    rb_data.files[i].pdh = wtap_dump_fdopen(rb_data.files[i].fd, filetype,
-      linktype, snaplen, err);
+    rb_data.files[i].write_buf = g_malloc(RINGBUF_WRITE_BUFSIZE);
+    rb_data.files[i].pdh = wtap_dump_fdopen_buffered(rb_data.files[i].fd,
+      filetype, linktype, snaplen, rb_data.files[i].write_buf,
+      RINGBUF_WRITE_BUFSIZE, err);
     if (rb_data.files[i].pdh == NULL) {
       /* could not open file */
       return NULL;
@@ -214,6 +228,21 @@ ringbuf_init_wtap_dump_fdopen(int filetype, int linktype,
       fflush(fh);
       rb_data.files[i].start_pos = ftell(fh);
       clearerr(fh);
+#ifdef HAVE_POSIX_FALLOCATE
+      /*
+       * Allocate the space for the packets now, so that the file
+       * system doesn't have to find it while we're capturing.
+       *
+       * XXX - on file systems that don't support that, the C library
+       * may do it by writing zeroes to the file; that takes a while,
+       * but we haven't started capturing yet.  We don't care if it
+       * fails; we'll just allocate the space as we write.
+       */
+      if (rb_data.file_size > rb_data.files[i].start_pos) {
+        posix_fallocate(rb_data.files[i].fd, rb_data.files[i].start_pos,
+          rb_data.file_size - rb_data.files[i].start_pos);
+      }
+#endif
     }
   }
   /* done */
@@ -229,18 +258,25 @@ ringbuf_switch_file(capture_file *cf, wtap_dumper **pdh, int *err)
 {
   int   next_file_num;
   FILE *fh;
-
-  /* flush the current file */
-  fh = wtap_dump_file(rb_data.files[rb_data.curr_file_num].pdh);
-  clearerr(fh);
-  fflush(fh);
+  GTimeVal start_time, end_time;
+  gulong switch_usec;
+
+  g_get_current_time(&start_time);
+  /* The current file will be flushed by "ringbuf_flush_idle()" when
+     there are no packets to capture, rather than now; it's flushed
+     anyway if we get back around to it before that happens. */
+  rb_data.flush_file_num = rb_data.curr_file_num;
   /* get the next file number */
   next_file_num = (rb_data.curr_file_num + 1) % rb_data.num_files;
   /* prepare the file if it was already used */
   if (!rb_data.files[next_file_num].is_new) {
-    /* rewind to the position after the file header */
+    /* rewind to the position after the file header; this writes
+       out anything we haven't yet flushed from our last use of it */
     fh = wtap_dump_file(rb_data.files[next_file_num].pdh);
+    clearerr(fh);
     fseek(fh, rb_data.files[next_file_num].start_pos, SEEK_SET);
+    if (rb_data.flush_file_num == next_file_num)
+      rb_data.flush_file_num = -1;
     wtap_set_bytes_dumped(rb_data.files[next_file_num].pdh,
       rb_data.files[next_file_num].start_pos);
     /* set the absolute file number */
@@ -259,9 +295,44 @@ ringbuf_switch_file(capture_file *cf, wtap_dumper **pdh, int *err)
   /* finally set the current file number */
   rb_data.curr_file_num = next_file_num;
 
+  /* update the statistics */
+  g_get_current_time(&end_time);
+  switch_usec = (end_time.tv_sec - start_time.tv_sec) * 1000000 +
+    (end_time.tv_usec - start_time.tv_usec);
+  rb_data.stats.switches++;
+  rb_data.stats.total_usec += switch_usec;
+  if (switch_usec > rb_data.stats.max_usec)
+    rb_data.stats.max_usec = switch_usec;
+
   return TRUE;
 }
 
+/* 
+ * Flushes the file we last switched away from, if that hasn't been
+ * done yet
+ */
+void
+ringbuf_flush_idle(void)
+{
+  FILE *fh;
+
+  if (rb_data.files == NULL || rb_data.flush_file_num == -1)
+    return;
+  fh = wtap_dump_file(rb_data.files[rb_data.flush_file_num].pdh);
+  clearerr(fh);
+  fflush(fh);
+  rb_data.flush_file_num = -1;
+}
+
+/* 
+ * Returns the file switch statistics
+ */
+void
+ringbuf_get_stats(ringbuf_stats *stats)
+{
+  *stats = rb_data.stats;
+}
+
 /* 
  * Calls wtap_dump_close() for all ringbuffer files
  */
@@ -346,6 +417,8 @@ ringbuf_free()
     for (i=0; i < rb_data.num_files; i++) {
       g_free(rb_data.files[i].name);
       rb_data.files[i].name = NULL;
+      g_free(rb_data.files[i].write_buf);
+      rb_data.files[i].write_buf = NULL;
     }
     free(rb_data.files);
     rb_data.files = NULL;
@@ -35,10 +35,19 @@
 /* maximum number of ringbuffer files */
 #define RINGBUFFER_MAX_NUM_FILES MIN(10,FOPEN_MAX) 
 
-int ringbuf_init(const char *capture_name, guint num_files);
+/* statistics for switches between ringbuffer files */
+typedef struct {
+  guint   switches;     /* number of switches */
+  gulong  max_usec;     /* longest switch, in microseconds */
+  gulong  total_usec;   /* time spent in all switches, in microseconds */
+} ringbuf_stats;
+
+int ringbuf_init(const char *capture_name, guint num_files, long file_size);
 wtap_dumper* ringbuf_init_wtap_dump_fdopen(int filetype, int linktype, 
   int snaplen, int *err);
 gboolean ringbuf_switch_file(capture_file *cf, wtap_dumper **pdh, int *err);
+void ringbuf_flush_idle(void);
+void ringbuf_get_stats(ringbuf_stats *stats);
 gboolean ringbuf_wtap_dump_close(capture_file *cf, int *err);
 void ringbuf_free(void);
 void ringbuf_error_cleanup(void);
@@ -64,7 +64,6 @@ summary_fill_in(summary_tally *st)
 
   frame_data    *first_frame, *cur_frame;
   int 		i;
-  frame_data    *cur_glist;
 
   st->start_time = 0;
   st->stop_time = 0;
@@ -73,16 +72,14 @@ summary_fill_in(summary_tally *st)
   st->marked_count = 0;
 
   /* initialize the tally */
-  if (cfile.plist != NULL) {
-    first_frame = cfile.plist;
+  if (cfile.count != 0) {
+    first_frame = cf_get_frame(&cfile, 1);
     st->start_time = secs_usecs(first_frame->abs_secs,first_frame->abs_usecs);
     st->stop_time = secs_usecs(first_frame->abs_secs,first_frame->abs_usecs);
-    cur_glist = cfile.plist;
 
-    for (i = 0; i < cfile.count; i++) {
-      cur_frame = cur_glist;
+    for (i = 1; i <= cfile.count; i++) {
+      cur_frame = cf_get_frame(&cfile, i);
       tally_frame_data(cur_frame, st);
-      cur_glist = cur_glist->next;
     }
   }
 
@@ -60,6 +60,10 @@
 #include <setjmp.h>
 #endif
 
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
 #ifdef HAVE_LIBZ
 #include <zlib.h>	/* to get the libz version number */
 #endif
@@ -108,17 +112,35 @@
 #include "conditions.h"
 #include "capture_stop_conditions.h"
 #include "ringbuffer.h"
+#include "capture_ring.h"
 #include <epan/epan_dissect.h>
 
 #ifdef WIN32
 #include "capture-wpcap.h"
 #endif
 
+#if defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__bsdi__)
+#ifndef BSD
+#define BSD
+#endif /* BSD */
+#endif /* defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__bsdi__) */
+
+/*
+ * With a capture ring, we have to find out whether libpcap has packets
+ * for us without blocking, which means doing a "select()" on the pcap_t's
+ * file descriptor; see the comment in "capture.c" for why we can't do
+ * that on BSD or Windows.
+ */
+#if defined(HAVE_LIBPCAP) && !defined(BSD) && !defined(_WIN32)
+# define CAN_USE_CAPTURE_RING
+#endif
+
 static guint32 firstsec, firstusec;
 static guint32 prevsec, prevusec;
 static GString *comp_info_str;
 static gboolean verbose;
 static gboolean print_hex;
+static gboolean print_heur_stats;
 static gboolean line_buffered;
 
 #ifdef HAVE_LIBPCAP
@@ -127,6 +149,7 @@ typedef struct _loop_data {
   gint           linktype;
   pcap_t        *pch;
   wtap_dumper   *pdh;
+  capture_ring_t *ring;        /* ring of packets waiting to be processed, or NULL */
   jmp_buf        stopenv;
 } loop_data;
 
@@ -135,6 +158,13 @@ static loop_data ld;
 static int capture(volatile int, int);
 static void capture_pcap_cb(u_char *, const struct pcap_pkthdr *,
   const u_char *);
+static void process_captured_packet(loop_data *, const struct wtap_pkthdr *,
+  const u_char *);
+#ifdef CAN_USE_CAPTURE_RING
+static void capture_ring_cb(u_char *, const struct pcap_pkthdr *,
+  const u_char *);
+static int capture_ring_dispatch(loop_data *, int);
+#endif
 static void capture_cleanup(int);
 #endif
 
@@ -149,15 +179,21 @@ static void wtap_dispatch_cb_write(u_char *, const struct wtap_pkthdr *, long,
 static void show_capture_file_io_error(const char *, int, gboolean);
 static void wtap_dispatch_cb_print(u_char *, const struct wtap_pkthdr *, long,
     union wtap_pseudo_header *, const u_char *);
+static void print_heur_stat(const char *, const char *, guint32, guint32,
+    gpointer);
 
 capture_file cfile;
-FILE        *data_out_file = NULL;
 ts_type timestamp_type = RELATIVE;
 #ifdef HAVE_LIBPCAP
 static int snaplen = WTAP_MAX_PACKET_SIZE;
 static int promisc_mode = TRUE;
+static int capture_ring_size = 0;	/* in kilobytes; 0 means no ring */
 #endif
 
+/* With a capture ring, the most packets we process from the ring before
+   going back to see whether libpcap has more packets for us. */
+#define CAPTURE_RING_BATCH	32
+
 static void 
 print_usage(void)
 {
@@ -166,15 +202,16 @@ print_usage(void)
   fprintf(stderr, "This is GNU t%s %s, compiled %s\n", PACKAGE, VERSION,
 	comp_info_str->str);
 #ifdef HAVE_LIBPCAP
-  fprintf(stderr, "t%s [ -DvVhlp ] [ -a <capture autostop condition> ] ...\n",
+  fprintf(stderr, "t%s [ -DvVhHlp ] [ -a <capture autostop condition> ] ...\n",
 	  PACKAGE);
-  fprintf(stderr, "\t[ -b <number of ring buffer files> ] [ -c <count> ]\n");
+  fprintf(stderr, "\t[ -b <number of ring buffer files> ] [ -B <capture ring size> ]\n");
+  fprintf(stderr, "\t[ -c <count> ]\n");
   fprintf(stderr, "\t[ -f <capture filter> ] [ -F <capture file type> ]\n");
   fprintf(stderr, "\t[ -i <interface> ] [ -n ] [ -N <resolving> ]\n");
   fprintf(stderr, "\t[ -o <preference setting> ] ... [ -r <infile> ] [ -R <read filter> ]\n");
   fprintf(stderr, "\t[ -s <snaplen> ] [ -t <time stamp format> ] [ -w <savefile> ] [ -x ]\n");
 #else
-  fprintf(stderr, "t%s [ -vVhl ] [ -F <capture file type> ] [ -n ] [ -N <resolving> ]\n", PACKAGE);
+  fprintf(stderr, "t%s [ -vVhHl ] [ -F <capture file type> ] [ -n ] [ -N <resolving> ]\n", PACKAGE);
   fprintf(stderr, "\t[ -o <preference setting> ] ... [ -r <infile> ] [ -R <read filter> ]\n");
   fprintf(stderr, "\t[ -t <time stamp format> ] [ -w <savefile> ] [ -x ]\n");
 #endif
@@ -335,8 +372,7 @@ main(int argc, char *argv[])
 #endif
     
   /* Initialize the capture file struct */
-  cfile.plist		= NULL;
-  cfile.plist_end	= NULL;
+  cfile.plist_chunks	= NULL;
   cfile.wth		= NULL;
   cfile.filename	= NULL;
   cfile.user_saved	= FALSE;
@@ -415,7 +451,7 @@ main(int argc, char *argv[])
 #endif
     
   /* Now get our args */
-  while ((opt = getopt(argc, argv, "a:b:c:Df:F:hi:lnN:o:pr:R:s:t:vw:Vx")) != EOF) {
+  while ((opt = getopt(argc, argv, "a:b:B:c:Df:F:hHi:lnN:o:pr:R:s:t:vw:Vx")) != EOF) {
     switch (opt) {
       case 'a':        /* autostop criteria */
 #ifdef HAVE_LIBPCAP
@@ -432,6 +468,19 @@ main(int argc, char *argv[])
 #ifdef HAVE_LIBPCAP
         cfile.ringbuffer_on = TRUE;
         cfile.ringbuffer_num_files = get_positive_int(optarg, "number of ring buffer files");
+#else
+        capture_option_specified = TRUE;
+        arg_error = TRUE;
+#endif
+        break;
+      case 'B':        /* Capture ring size, in kilobytes */
+#ifdef HAVE_LIBPCAP
+#ifdef CAN_USE_CAPTURE_RING
+        capture_ring_size = get_positive_int(optarg, "capture ring size");
+#else
+        fprintf(stderr, "tethereal: Capture rings aren't supported on this platform\n");
+        exit(1);
+#endif
 #else
         capture_option_specified = TRUE;
         arg_error = TRUE;
@@ -596,6 +645,9 @@ main(int argc, char *argv[])
       case 'x':        /* Print packet data in hex (and ASCII) */
         print_hex = TRUE;
         break;
+      case 'H':        /* Print heuristic dissector statistics */
+        print_heur_stats = TRUE;
+        break;
     }
   }
   
@@ -773,11 +825,26 @@ main(int argc, char *argv[])
 #endif
   }
 
+  if (print_heur_stats)
+    heur_dissector_stats_foreach(print_heur_stat, NULL);
+
   epan_cleanup();
 
   return 0;
 }
 
+/* Print how often a heuristic dissector was tried, and how often it
+   recognized the packet, if it was tried at all. */
+static void
+print_heur_stat(const char *list_name, const char *proto_name,
+    guint32 tries, guint32 hits, gpointer user_data)
+{
+  if (tries == 0)
+    return;
+  fprintf(stderr, "%-12s %-16s %10u tries %10u hits\n", list_name,
+    proto_name, tries, hits);
+}
+
 #ifdef HAVE_LIBPCAP
 /* Do the low-level work of a capture.
    Returns TRUE if it succeeds, FALSE otherwise. */
@@ -800,6 +867,11 @@ capture(volatile int packet_count, int out_file_type)
 #endif
   struct pcap_stat stats;
   gboolean    dump_ok;
+  ringbuf_stats rb_stats;
+#ifdef CAN_USE_CAPTURE_RING
+  struct wtap_pkthdr whdr;
+  guint32     unprocessed;
+#endif
 
   /* Initialize the table of conversations. */
   epan_conversation_init();
@@ -815,6 +887,7 @@ capture(volatile int packet_count, int out_file_type)
 
   ld.linktype       = WTAP_ENCAP_UNKNOWN;
   ld.pdh            = NULL;
+  ld.ring           = NULL;
 
   /* Open the network interface to capture from it.
      Some versions of libpcap may put warnings into the error buffer
@@ -902,7 +975,7 @@ capture(volatile int packet_count, int out_file_type)
     }
     if (cfile.ringbuffer_on) {
       cfile.save_file_fd = ringbuf_init(cfile.save_file,
-        cfile.ringbuffer_num_files);
+        cfile.ringbuffer_num_files, (long)cfile.autostop_filesize * 1000);
       if (cfile.save_file_fd != -1) {
         ld.pdh = ringbuf_init_wtap_dump_fdopen(out_file_type, ld.linktype,
           pcap_snapshot(ld.pch), &err);
@@ -949,6 +1022,14 @@ capture(volatile int packet_count, int out_file_type)
   cnd_stop_timeout = cnd_new((char*)CND_CLASS_TIMEOUT,
                              (gint32)cfile.autostop_duration);
 
+#ifdef CAN_USE_CAPTURE_RING
+  /* If asked to, copy packets into a ring as they arrive, and process
+     them from there, so that we keep reading packets from the kernel
+     even if processing them falls behind. */
+  if (capture_ring_size != 0)
+    ld.ring = capture_ring_new(capture_ring_size * 1024);
+#endif
+
   if (packet_count == 0)
     packet_count = -1; /* infinite capturng */
   if (!setjmp(ld.stopenv))
@@ -956,9 +1037,25 @@ capture(volatile int packet_count, int out_file_type)
   else
     ld.go = FALSE;
   while (ld.go) {
-    if (packet_count > 0)
-      packet_count--;
-    inpkts = pcap_dispatch(ld.pch, 1, capture_pcap_cb, (u_char *) &ld);
+#ifdef CAN_USE_CAPTURE_RING
+    if (ld.ring != NULL) {
+      inpkts = capture_ring_dispatch(&ld,
+          (packet_count > 0 && packet_count < CAPTURE_RING_BATCH) ?
+            packet_count : CAPTURE_RING_BATCH);
+      if (packet_count > 0 && inpkts > 0)
+        packet_count -= inpkts;
+    } else
+#endif
+    {
+      if (packet_count > 0)
+        packet_count--;
+      inpkts = pcap_dispatch(ld.pch, 1, capture_pcap_cb, (u_char *) &ld);
+    }
+    if (inpkts == 0 && cfile.ringbuffer_on) {
+      /* Nothing to capture right now; catch up on writing out the
+         ringbuffer file we last switched away from. */
+      ringbuf_flush_idle();
+    }
     if (packet_count == 0 || inpkts < 0) {
       ld.go = FALSE;
     } else if (cnd_eval(cnd_stop_timeout) == TRUE) {
@@ -1013,11 +1110,43 @@ capture(volatile int packet_count, int out_file_type)
 	pcap_geterr(ld.pch));
   }
 
+#ifdef CAN_USE_CAPTURE_RING
+  if (ld.ring != NULL) {
+    /* Report the packets we didn't process, and why. */
+    if (ld.ring->dropped != 0) {
+      fprintf(stderr, "%u packets dropped because the capture ring was full\n",
+	ld.ring->dropped);
+    }
+    if (packet_count != 0) {
+      unprocessed = 0;
+      while (capture_ring_get(ld.ring, &whdr, NULL) != NULL) {
+        capture_ring_release(ld.ring);
+        unprocessed++;
+      }
+      if (unprocessed != 0) {
+        fprintf(stderr, "%u packets in the capture ring not processed\n",
+	  unprocessed);
+      }
+    }
+    capture_ring_free(ld.ring);
+    ld.ring = NULL;
+  }
+#endif
+
   pcap_close(ld.pch);
 
   if (cfile.save_file != NULL) {
     /* We're saving to a file or files; close all files. */
     if (cfile.ringbuffer_on) {
+      /* Report how long switching files took, as a long switch can
+         make us drop packets. */
+      ringbuf_get_stats(&rb_stats);
+      if (rb_stats.switches != 0) {
+        fprintf(stderr,
+	  "%u ring buffer file switches, longest %lu us, average %lu us\n",
+	  rb_stats.switches, rb_stats.max_usec,
+	  rb_stats.total_usec / rb_stats.switches);
+      }
       dump_ok = ringbuf_wtap_dump_close(&cfile, &err);
     } else {
       dump_ok = wtap_dump_close(ld.pdh, &err);
@@ -1047,7 +1176,6 @@ capture_pcap_cb(u_char *user, const struct pcap_pkthdr *phdr,
 {
   struct wtap_pkthdr whdr;
   loop_data *ld = (loop_data *) user;
-  cb_args_t args;
 
   whdr.ts.tv_sec = phdr->ts.tv_sec;
   whdr.ts.tv_usec = phdr->ts.tv_usec;
@@ -1055,16 +1183,88 @@ capture_pcap_cb(u_char *user, const struct pcap_pkthdr *phdr,
   whdr.len = phdr->len;
   whdr.pkt_encap = ld->linktype;
 
+  process_captured_packet(ld, &whdr, pd);
+}
+
+/* Write or print a captured packet. */
+static void
+process_captured_packet(loop_data *ld, const struct wtap_pkthdr *whdr,
+  const u_char *pd)
+{
+  cb_args_t args;
+
   args.cf = &cfile;
   args.pdh = ld->pdh;
   if (ld->pdh) {
-    wtap_dispatch_cb_write((u_char *)&args, &whdr, 0, NULL, pd);
+    wtap_dispatch_cb_write((u_char *)&args, whdr, 0, NULL, pd);
     fprintf(stderr, "\r%u ", cfile.count);
     fflush(stdout);
   } else {
-    wtap_dispatch_cb_print((u_char *)&args, &whdr, 0, NULL, pd);
+    wtap_dispatch_cb_print((u_char *)&args, whdr, 0, NULL, pd);
+  }
+}
+
+#ifdef CAN_USE_CAPTURE_RING
+static void
+capture_ring_cb(u_char *user, const struct pcap_pkthdr *phdr,
+  const u_char *pd)
+{
+  struct wtap_pkthdr whdr;
+  loop_data *ld = (loop_data *) user;
+
+  whdr.ts.tv_sec = phdr->ts.tv_sec;
+  whdr.ts.tv_usec = phdr->ts.tv_usec;
+  whdr.caplen = phdr->caplen;
+  whdr.len = phdr->len;
+  whdr.pkt_encap = ld->linktype;
+
+  /* If the ring is full, this drops the packet, and counts it. */
+  capture_ring_put(ld->ring, &whdr, pd, 0);
+}
+
+/*
+ * Copy all the packets libpcap has for us into the capture ring, waiting
+ * for some only if there are none in the ring, and then process up to
+ * "max_packets" packets from the ring.  Returns the number of packets
+ * processed, or -1 on an error from libpcap.
+ */
+static int
+capture_ring_dispatch(loop_data *ld, int max_packets)
+{
+  int pcap_fd = pcap_fileno(ld->pch);
+  fd_set set1;
+  struct timeval timeout;
+  struct wtap_pkthdr whdr;
+  const u_char *pd;
+  int n;
+
+  for (;;) {
+    if (!capture_ring_is_empty(ld->ring)) {
+      /* We have packets to process; don't wait for more. */
+      FD_ZERO(&set1);
+      FD_SET(pcap_fd, &set1);
+      timeout.tv_sec = 0;
+      timeout.tv_usec = 0;
+      if (select(pcap_fd+1, &set1, NULL, NULL, &timeout) <= 0)
+        break;
+    }
+    n = pcap_dispatch(ld->pch, -1, capture_ring_cb, (u_char *) ld);
+    if (n < 0)
+      return -1;
+    if (n == 0)
+      break;	/* the read timed out */
+  }
+
+  for (n = 0; n < max_packets; n++) {
+    pd = capture_ring_get(ld->ring, &whdr, NULL);
+    if (pd == NULL)
+      break;
+    process_captured_packet(ld, &whdr, pd);
+    capture_ring_release(ld->ring);
   }
+  return n;
 }
+#endif /* CAN_USE_CAPTURE_RING */
 
 static void
 capture_cleanup(int signum)
@@ -1204,8 +1404,6 @@ fill_in_fdata(frame_data *fdata, capture_file *cf,
 {
   int i;
 
-  fdata->next = NULL;
-  fdata->prev = NULL;
   fdata->pfd = NULL;
   fdata->data_src = NULL;
   fdata->num = cf->count;
@@ -301,6 +301,7 @@ int etherpeek_open(wtap *wth, int *err)
 		wth->file_encap = WTAP_ENCAP_PER_PACKET;
 		wth->subtype_read = etherpeek_read_v56;
 		wth->subtype_seek_read = wtap_def_seek_read;
+		wth->subtype_seek_read_mapped = wtap_def_seek_read_mapped;
 		break;
 
 	case 7:
@@ -308,6 +309,7 @@ int etherpeek_open(wtap *wth, int *err)
 		wth->file_encap = file_encap;
 		wth->subtype_read = etherpeek_read_v7;
 		wth->subtype_seek_read = wtap_def_seek_read;
+		wth->subtype_seek_read_mapped = wtap_def_seek_read_mapped;
 		break;
 
 	default:
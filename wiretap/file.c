@@ -46,6 +46,10 @@
 #include <io.h>	/* open/close on win32 */
 #endif
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #include "wtap-int.h"
 #include "file_wrappers.h"
 #include "buffer.h"
@@ -130,6 +134,102 @@ int wtap_def_seek_read(wtap *wth, long seek_off,
 	return file_read(pd, sizeof(guint8), len, wth->random_fh);
 }
 
+const guint8 *wtap_def_seek_read_mapped(wtap *wth, long seek_off,
+	union wtap_pseudo_header *pseudo_header, int len)
+{
+	return wtap_map_range(wth, seek_off, len);
+}
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+typedef struct {
+	guint8	*map;
+	long	map_len;
+} old_map_t;
+
+/* Map all of the file, as it is now; the file might be a capture
+   that's still being written to, so it may have grown since we
+   last mapped it.  Mappings we've already handed out pointers into
+   are kept until the file is closed. */
+static gboolean wtap_remap(wtap *wth)
+{
+	struct stat statb;
+	guint8	*map;
+	old_map_t *old_map;
+
+	if (fstat(wth->map_fd, &statb) < 0 || statb.st_size <= wth->map_len)
+		return FALSE;
+
+	map = mmap(NULL, statb.st_size, PROT_READ, MAP_SHARED, wth->map_fd, 0);
+	if (map == MAP_FAILED)
+		goto give_up;
+
+	if (wth->map == NULL) {
+		/* If the file's compressed, the records aren't in the
+		   file as they are in the mapping; we can't use it. */
+		if (statb.st_size >= 2 && map[0] == 0x1f && map[1] == 0x8b) {
+			munmap(map, statb.st_size);
+			goto give_up;
+		}
+	} else {
+		old_map = g_malloc(sizeof (old_map_t));
+		old_map->map = wth->map;
+		old_map->map_len = wth->map_len;
+		wth->old_maps = g_slist_prepend(wth->old_maps, old_map);
+	}
+	wth->map = map;
+	wth->map_len = statb.st_size;
+	return TRUE;
+
+give_up:
+	close(wth->map_fd);
+	wth->map_fd = -1;
+	return FALSE;
+}
+
+const guint8 *wtap_map_range(wtap *wth, long offset, int len)
+{
+	if (wth->map_fd < 0 || offset < 0 || len < 0)
+		return NULL;
+	if (offset + len > wth->map_len) {
+		if (!wtap_remap(wth) || offset + len > wth->map_len)
+			return NULL;
+	}
+	return wth->map + offset;
+}
+
+void wtap_unmap(wtap *wth)
+{
+	GSList *l;
+	old_map_t *old_map;
+
+	for (l = wth->old_maps; l != NULL; l = l->next) {
+		old_map = l->data;
+		munmap(old_map->map, old_map->map_len);
+		g_free(old_map);
+	}
+	g_slist_free(wth->old_maps);
+	wth->old_maps = NULL;
+	if (wth->map != NULL) {
+		munmap(wth->map, wth->map_len);
+		wth->map = NULL;
+		wth->map_len = 0;
+	}
+	if (wth->map_fd >= 0) {
+		close(wth->map_fd);
+		wth->map_fd = -1;
+	}
+}
+#else /* HAVE_MMAP && HAVE_SYS_MMAN_H */
+const guint8 *wtap_map_range(wtap *wth, long offset, int len)
+{
+	return NULL;
+}
+
+void wtap_unmap(wtap *wth)
+{
+}
+#endif /* HAVE_MMAP && HAVE_SYS_MMAN_H */
+
 /*
  * Visual C++ on Win32 systems doesn't define these.  (Old UNIX systems don't
  * define them either.)
@@ -195,6 +295,11 @@ wtap* wtap_open_offline(const char *filename, int *err, gboolean do_random)
 		g_free(wth);
 		return NULL;
 	}
+#ifdef HAVE_POSIX_FADVISE
+	/* We read this descriptor from beginning to end; let the OS read
+	   ahead more aggressively. */
+	posix_fadvise(wth->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 	if (!(wth->fh = filed_open(wth->fd, "rb"))) {
 		*err = errno;
 		g_free(wth);
@@ -211,9 +316,35 @@ wtap* wtap_open_offline(const char *filename, int *err, gboolean do_random)
 	} else
 		wth->random_fh = NULL;
 
+	/* If we're doing random access, have both streams share a list of
+	   access points into the file, so that, if it's compressed, the
+	   ones made by the sequential pass through the file let random
+	   reads avoid decompressing it from the beginning. */
+	wth->fast_seek = NULL;
+#ifdef HAVE_LIBZ
+	if (do_random) {
+		wth->fast_seek = g_ptr_array_new();
+		file_set_fast_seek(wth->fh, wth->fast_seek);
+		file_set_fast_seek(wth->random_fh, wth->fast_seek);
+	}
+#endif
+
+	/* If we're doing random access, and we can map the file into
+	   memory, random reads of file types whose records are the raw
+	   packet data can just return a pointer into the mapping. */
+	wth->map_fd = -1;
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+	if (do_random && S_ISREG(statb.st_mode))
+		wth->map_fd = open(filename, O_RDONLY|O_BINARY);
+#endif
+	wth->map = NULL;
+	wth->map_len = 0;
+	wth->old_maps = NULL;
+
 	/* initialization */
 	wth->file_encap = WTAP_ENCAP_UNKNOWN;
 	wth->data_offset = 0;
+	wth->subtype_seek_read_mapped = NULL;
 	wth->subtype_sequential_close = NULL;
 	wth->subtype_close = NULL;
 
@@ -234,7 +365,10 @@ wtap* wtap_open_offline(const char *filename, int *err, gboolean do_random)
 			/* I/O error - give up */
 			if (wth->random_fh != NULL)
 				file_close(wth->random_fh);
+			wtap_unmap(wth);
 			file_close(wth->fh);
+			if (wth->fast_seek != NULL)
+				file_fast_seek_free(wth->fast_seek);
 			g_free(wth);
 			return NULL;
 
@@ -251,7 +385,10 @@ wtap* wtap_open_offline(const char *filename, int *err, gboolean do_random)
 	/* Well, it's not one of the types of file we know about. */
 	if (wth->random_fh != NULL)
 		file_close(wth->random_fh);
+	wtap_unmap(wth);
 	file_close(wth->fh);
+	if (wth->fast_seek != NULL)
+		file_fast_seek_free(wth->fast_seek);
 	g_free(wth);
 	*err = WTAP_ERR_FILE_UNKNOWN_FORMAT;
 	return NULL;
@@ -490,6 +627,18 @@ wtap_dumper* wtap_dump_open(const char *filename, int filetype, int encap,
 
 wtap_dumper* wtap_dump_fdopen(int fd, int filetype, int encap, int snaplen,
 				int *err)
+{
+	return wtap_dump_fdopen_buffered(fd, filetype, encap, snaplen,
+	    NULL, 0, err);
+}
+
+/* Like "wtap_dump_fdopen()", but, if "buf" isn't null, have the standard
+   I/O stream use the "bufsize" bytes at "buf" as its buffer, so that
+   data is written to the file in chunks of that size; the buffer must
+   stay around until the dumper is closed. */
+wtap_dumper* wtap_dump_fdopen_buffered(int fd, int filetype, int encap,
+				int snaplen, char *buf, size_t bufsize,
+				int *err)
 {
 	wtap_dumper *wdh;
 	FILE *fh;
@@ -512,6 +661,8 @@ wtap_dumper* wtap_dump_fdopen(int fd, int filetype, int encap, int snaplen,
 		*err = errno;
 		return NULL;	/* can't create standard I/O stream */
 	}
+	if (buf != NULL)
+		setvbuf(fh, buf, _IOFBF, bufsize);
 	wdh->fh = fh;
 
 	if (!wtap_dump_open_finish(wdh, filetype, encap, snaplen, err))
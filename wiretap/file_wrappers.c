@@ -89,6 +89,18 @@
  * "wtap.h" and get "gzseek()" misdeclared, and include just "zlib.h"
  * in this file - *after* undefining HAVE_UNISTD_H.
  */
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_IO_H
+#include <io.h>	/* open/read/lseek/close on win32 */
+#endif
+
 #ifdef __OpenBSD__
 #ifndef HAVE_UNISTD_H
 #define HAVE_UNISTD_H
@@ -99,20 +111,754 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include "wtap-int.h"
 #include "file_wrappers.h"
 
 #ifdef HAVE_LIBZ
+
+/* Win32 needs the O_BINARY flag for open() */
+#ifndef O_BINARY
+#define O_BINARY	0
+#endif
+
+/*
+ * zlib's "gzseek()" can only seek backwards in a compressed file by
+ * going back to the beginning of the file and decompressing everything
+ * up to the new offset, so random access to a compressed capture file
+ * takes time proportional to the size of the file for every packet.
+ *
+ * So we read files ourselves, with "inflate()" doing the decompression
+ * for gzipped files.  As a stream decompresses a file, it saves an
+ * "access point" every FAST_SEEK_SPAN bytes of uncompressed data, at
+ * the beginning of a deflate block: the offsets in the compressed and
+ * uncompressed data, and the 32K of uncompressed data before it, which
+ * is all the state "inflate()" needs to start decompressing there.
+ * A seek then only has to decompress the data between the nearest
+ * access point before the offset and the offset.  (The idea is from
+ * Mark Adler's "zran.c", in the zlib distribution.)
+ *
+ * The access points are kept in a list that the sequential and random
+ * streams for a file share, so that the ones made when the file is
+ * first read are used for random access to it.
+ *
+ * Access points need "Z_BLOCK" and "inflatePrime()", which appeared
+ * in zlib 1.2.x; with older versions of zlib, seeking backwards always
+ * starts from the beginning of the file, as it did with "gzseek()".
+ */
+#if defined(Z_BLOCK) && defined(ZLIB_VERNUM) && ZLIB_VERNUM >= 0x1230
+#define HAVE_FAST_SEEK
+#endif
+
+#define IN_BUF_SIZE	65536
+#define OUT_BUF_SIZE	65536
+#define WINDOW_SIZE	32768		/* largest deflate window */
+#define FAST_SEEK_SPAN	(4*1024*1024)	/* uncompressed bytes between access points */
+
+/* gzip header flags */
+#define GZ_FHCRC	0x02
+#define GZ_FEXTRA	0x04
+#define GZ_FNAME	0x08
+#define GZ_FCOMMENT	0x10
+
+typedef enum {
+	UNKNOWN,		/* haven't looked at the file yet */
+	UNCOMPRESSED,		/* not gzipped; read it as is */
+	GZIP,			/* gzipped; inflate it */
+	GZIP_DONE		/* gzipped, and we've read all of it */
+} compression_t;
+
+typedef struct {
+	long	in;		/* offset in the file of the deflate block */
+	long	out;		/* offset of the block's data in the uncompressed data */
+	int	bits;		/* bits of the byte before "in" in the block, or 0 */
+	unsigned int	window_len;
+	unsigned char	window[WINDOW_SIZE];	/* uncompressed data before "out" */
+} fast_seek_point_t;
+
+struct wtap_reader {
+	int		fd;
+	compression_t	compression;
+	int		err;		/* Wiretap error code, or 0 */
+	gboolean	eof;		/* we've read all of the file */
+	long		raw_pos;	/* offset in the file of the end of "in" */
+	long		pos;		/* offset in the uncompressed data of "next" */
+	unsigned char	*in;		/* data read from the file */
+	unsigned char	*out;		/* uncompressed data */
+	unsigned char	*next;		/* next uncompressed byte to hand out */
+	unsigned int	have;		/* number of bytes at "next" */
+
+	/* For gzipped files */
+	z_stream	strm;
+	gboolean	strm_inited;
+	gboolean	check_crc;	/* decompressing the member from its start */
+	uLong		crc;		/* CRC of the member's uncompressed data */
+	uLong		member_len;	/* length of the member's uncompressed data */
+
+	/* For making access points */
+	GPtrArray	*fast_seek;
+	unsigned char	*window;	/* last WINDOW_SIZE bytes of uncompressed data */
+	unsigned int	window_next;	/* where the next byte goes in "window" */
+	unsigned int	window_len;	/* number of bytes in "window" */
+};
+
+/* Read more of the file into the input buffer, if it's empty; returns
+   -1 on error, 0 otherwise. */
+static int
+fill_in_buffer(FILE_T state)
+{
+	int n;
+
+	if (state->strm.avail_in != 0 || state->eof)
+		return 0;
+	n = read(state->fd, state->in, IN_BUF_SIZE);
+	if (n < 0) {
+		state->err = errno;
+		return -1;
+	}
+	if (n == 0)
+		state->eof = TRUE;
+	state->raw_pos += n;
+	state->strm.next_in = state->in;
+	state->strm.avail_in = n;
+	return 0;
+}
+
+/* Get the next byte of the file; returns -1 at the end of the file
+   or on an error. */
+static int
+next_byte(FILE_T state)
+{
+	if (state->strm.avail_in == 0) {
+		if (fill_in_buffer(state) < 0 || state->strm.avail_in == 0)
+			return -1;
+	}
+	state->strm.avail_in--;
+	return *state->strm.next_in++;
+}
+
+/* Skip the rest of a gzip header, after the magic number; returns -1
+   if it's not a header we understand, or the file ends in it. */
+static int
+skip_gzip_header(FILE_T state)
+{
+	int	flags, len, c, i;
+
+	/* Compression method (must be deflate), then the flags. */
+	if (next_byte(state) != Z_DEFLATED)
+		return -1;
+	if ((flags = next_byte(state)) == -1)
+		return -1;
+
+	/* Modification time, extra flags, and OS. */
+	for (i = 0; i < 6; i++) {
+		if (next_byte(state) == -1)
+			return -1;
+	}
+	if (flags & GZ_FEXTRA) {
+		if ((c = next_byte(state)) == -1)
+			return -1;
+		len = c;
+		if ((c = next_byte(state)) == -1)
+			return -1;
+		len += c << 8;
+		while (len-- > 0) {
+			if (next_byte(state) == -1)
+				return -1;
+		}
+	}
+	if (flags & GZ_FNAME) {
+		while ((c = next_byte(state)) != 0) {
+			if (c == -1)
+				return -1;
+		}
+	}
+	if (flags & GZ_FCOMMENT) {
+		while ((c = next_byte(state)) != 0) {
+			if (c == -1)
+				return -1;
+		}
+	}
+	if (flags & GZ_FHCRC) {
+		if (next_byte(state) == -1 || next_byte(state) == -1)
+			return -1;
+	}
+	return 0;
+}
+
+/* Start decompressing a gzip member, whose header we've just read. */
+static int
+start_member(FILE_T state)
+{
+	if (!state->strm_inited) {
+		state->strm.zalloc = Z_NULL;
+		state->strm.zfree = Z_NULL;
+		state->strm.opaque = Z_NULL;
+		/* Raw deflate data; we handle the gzip header and trailer. */
+		if (inflateInit2(&state->strm, -MAX_WBITS) != Z_OK) {
+			state->err = WTAP_ERR_ZLIB + Z_MEM_ERROR;
+			return -1;
+		}
+		state->strm_inited = TRUE;
+	} else
+		inflateReset(&state->strm);
+	state->compression = GZIP;
+	state->check_crc = TRUE;
+	state->crc = crc32(0L, Z_NULL, 0);
+	state->member_len = 0;
+	return 0;
+}
+
+/* Look at the beginning of the file to see whether it's gzipped. */
+static int
+look_for_gzip(FILE_T state)
+{
+	unsigned char *p;
+
+	if (fill_in_buffer(state) < 0)
+		return -1;
+	p = state->strm.next_in;
+	if (state->strm.avail_in >= 2 && p[0] == 0x1f && p[1] == 0x8b) {
+		state->strm.next_in += 2;
+		state->strm.avail_in -= 2;
+		if (skip_gzip_header(state) < 0) {
+			/* XXX - treat a bad or truncated header as the end
+			   of the data, as we do a truncated member. */
+			state->compression = GZIP_DONE;
+			return 0;
+		}
+		return start_member(state);
+	}
+	state->compression = UNCOMPRESSED;
+	return 0;
+}
+
+/* Read the trailer of a gzip member, and, if another member follows it,
+   start decompressing that; otherwise, the data ends here. */
+static int
+end_member(FILE_T state)
+{
+	unsigned char	trailer[8];
+	uLong		crc, len;
+	int		c, i;
+
+	for (i = 0; i < 8; i++) {
+		if ((c = next_byte(state)) == -1) {
+			state->compression = GZIP_DONE;
+			return state->err != 0 ? -1 : 0;
+		}
+		trailer[i] = c;
+	}
+	if (state->check_crc) {
+		crc = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) |
+		    ((uLong)trailer[3] << 24);
+		len = trailer[4] | (trailer[5] << 8) | (trailer[6] << 16) |
+		    ((uLong)trailer[7] << 24);
+		if (crc != state->crc ||
+		    len != (state->member_len & 0xffffffffUL)) {
+			state->err = WTAP_ERR_ZLIB + Z_DATA_ERROR;
+			return -1;
+		}
+	}
+
+	/* Anything other than another gzip member after this one is
+	   ignored, as "gzread()" does. */
+	if (next_byte(state) == 0x1f && next_byte(state) == 0x8b &&
+	    skip_gzip_header(state) == 0)
+		return start_member(state);
+	state->compression = GZIP_DONE;
+	return state->err != 0 ? -1 : 0;
+}
+
+#ifdef HAVE_FAST_SEEK
+/* Remember the uncompressed data we've just made, in case we make an
+   access point after it. */
+static void
+save_window(FILE_T state, unsigned char *data, unsigned int len)
+{
+	unsigned int n;
+
+	if (len >= WINDOW_SIZE) {
+		memcpy(state->window, data + len - WINDOW_SIZE, WINDOW_SIZE);
+		state->window_next = 0;
+		state->window_len = WINDOW_SIZE;
+		return;
+	}
+	n = WINDOW_SIZE - state->window_next;
+	if (n > len)
+		n = len;
+	memcpy(state->window + state->window_next, data, n);
+	memcpy(state->window, data + n, len - n);
+	state->window_next = (state->window_next + len) % WINDOW_SIZE;
+	state->window_len += len;
+	if (state->window_len > WINDOW_SIZE)
+		state->window_len = WINDOW_SIZE;
+}
+
+/* If we're at the beginning of a deflate block far enough past the last
+   access point, add an access point here; "out" is the offset in the
+   uncompressed data of the end of what we've decompressed so far. */
+static void
+add_fast_seek_point(FILE_T state, long out)
+{
+	fast_seek_point_t *point;
+	long last_out;
+	unsigned int n;
+
+	/* "data_type" has bit 7 set at the end of a block, and bit 6 set
+	   if that's the end of the last block. */
+	if (!(state->strm.data_type & 128) || (state->strm.data_type & 64))
+		return;
+
+	if (state->fast_seek->len != 0) {
+		point = g_ptr_array_index(state->fast_seek,
+		    state->fast_seek->len - 1);
+		last_out = point->out;
+	} else
+		last_out = 0;
+	if (out - last_out < FAST_SEEK_SPAN)
+		return;
+
+	point = g_malloc(sizeof (fast_seek_point_t));
+	point->in = state->raw_pos - state->strm.avail_in;
+	point->out = out;
+	point->bits = state->strm.data_type & 7;
+
+	/* Save the window, oldest byte first. */
+	point->window_len = state->window_len;
+	if (state->window_len < WINDOW_SIZE)
+		memcpy(point->window, state->window, state->window_len);
+	else {
+		n = WINDOW_SIZE - state->window_next;
+		memcpy(point->window, state->window + state->window_next, n);
+		memcpy(point->window + n, state->window, state->window_next);
+	}
+	g_ptr_array_add(state->fast_seek, point);
+}
+
+/* Start decompressing at an access point. */
+static int
+seek_to_point(FILE_T state, fast_seek_point_t *point)
+{
+	long	offset;
+	int	c;
+
+	offset = point->in - (point->bits ? 1 : 0);
+	if (lseek(state->fd, offset, SEEK_SET) == -1) {
+		state->err = errno;
+		return -1;
+	}
+	state->raw_pos = offset;
+	state->eof = FALSE;
+	state->strm.avail_in = 0;
+	state->have = 0;
+	state->pos = point->out;
+
+	inflateReset(&state->strm);
+	state->compression = GZIP;
+	state->check_crc = FALSE;	/* we don't have the CRC so far */
+	if (point->bits) {
+		if ((c = next_byte(state)) == -1) {
+			if (state->err == 0)
+				state->err = WTAP_ERR_SHORT_READ;
+			return -1;
+		}
+		inflatePrime(&state->strm, point->bits, c >> (8 - point->bits));
+	}
+	inflateSetDictionary(&state->strm, point->window, point->window_len);
+
+	memcpy(state->window, point->window, point->window_len);
+	state->window_len = point->window_len;
+	state->window_next = point->window_len % WINDOW_SIZE;
+	return 0;
+}
+
+/* Find the last access point at or before "offset", if any. */
+static fast_seek_point_t *
+find_point(FILE_T state, long offset)
+{
+	fast_seek_point_t *point;
+	int low, high, mid;
+
+	if (state->fast_seek == NULL || state->fast_seek->len == 0)
+		return NULL;
+	low = 0;
+	high = state->fast_seek->len - 1;
+	point = g_ptr_array_index(state->fast_seek, 0);
+	if (point->out > offset)
+		return NULL;
+	while (low < high) {
+		mid = (low + high + 1) / 2;
+		point = g_ptr_array_index(state->fast_seek, mid);
+		if (point->out <= offset)
+			low = mid;
+		else
+			high = mid - 1;
+	}
+	return g_ptr_array_index(state->fast_seek, low);
+}
+#endif /* HAVE_FAST_SEEK */
+
+/* Decompress some more of a gzipped file into the output buffer. */
+static int
+inflate_some(FILE_T state)
+{
+	int	ret;
+	unsigned char	*start;
+	unsigned int	len;
+
+	state->strm.next_out = state->out;
+	state->strm.avail_out = OUT_BUF_SIZE;
+	do {
+		if (fill_in_buffer(state) < 0)
+			return -1;
+		if (state->strm.avail_in == 0) {
+			/* The file ends in the middle of the member;
+			   treat that as the end of the data, and let
+			   our caller report a short read. */
+			state->compression = GZIP_DONE;
+			break;
+		}
+		start = state->strm.next_out;
+#ifdef HAVE_FAST_SEEK
+		ret = inflate(&state->strm,
+		    state->fast_seek != NULL ? Z_BLOCK : Z_NO_FLUSH);
+#else
+		ret = inflate(&state->strm, Z_NO_FLUSH);
+#endif
+		if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+			state->err = WTAP_ERR_ZLIB +
+			    (ret == Z_NEED_DICT ? Z_DATA_ERROR : ret);
+			return -1;
+		}
+		len = state->strm.next_out - start;
+		if (state->check_crc)
+			state->crc = crc32(state->crc, start, len);
+		state->member_len += len;
+#ifdef HAVE_FAST_SEEK
+		if (state->fast_seek != NULL) {
+			save_window(state, start, len);
+			add_fast_seek_point(state, state->pos +
+			    (state->strm.next_out - state->out));
+		}
+#endif
+		if (ret == Z_STREAM_END) {
+			/* Hand out what we have before going on to the
+			   next member, if there is one. */
+			if (end_member(state) < 0)
+				return -1;
+			break;
+		}
+	} while (state->strm.avail_out != 0);
+
+	state->next = state->out;
+	state->have = OUT_BUF_SIZE - state->strm.avail_out;
+	return 0;
+}
+
+/* Fill the output buffer; on return, "have" is 0 only at the end of
+   the data or on an error, in which case we return -1. */
+static int
+fill_out_buffer(FILE_T state)
+{
+	int n;
+
+	if (state->compression == UNKNOWN) {
+		if (look_for_gzip(state) < 0)
+			return -1;
+	}
+
+	switch (state->compression) {
+
+	case UNCOMPRESSED:
+		/* Hand out whatever we read while looking for a gzip
+		   header before reading any more. */
+		if (state->strm.avail_in != 0) {
+			memcpy(state->out, state->strm.next_in,
+			    state->strm.avail_in);
+			n = state->strm.avail_in;
+			state->strm.avail_in = 0;
+		} else {
+			n = read(state->fd, state->out, OUT_BUF_SIZE);
+			if (n < 0) {
+				state->err = errno;
+				return -1;
+			}
+			state->raw_pos += n;
+		}
+		state->next = state->out;
+		state->have = n;
+		break;
+
+	case GZIP:
+		/* An empty deflate block, or a member with no data,
+		   decompresses to nothing; keep going. */
+		state->have = 0;
+		while (state->have == 0 && state->compression == GZIP) {
+			if (inflate_some(state) < 0)
+				return -1;
+		}
+		break;
+
+	case GZIP_DONE:
+		state->have = 0;
+		break;
+
+	default:
+		g_assert_not_reached();
+	}
+	return 0;
+}
+
+/* Go back to the beginning of the file. */
+static int
+rewind_file(FILE_T state)
+{
+	if (lseek(state->fd, 0, SEEK_SET) == -1) {
+		state->err = errno;
+		return -1;
+	}
+	state->compression = UNKNOWN;
+	state->raw_pos = 0;
+	state->pos = 0;
+	state->eof = FALSE;
+	state->strm.avail_in = 0;
+	state->have = 0;
+	state->window_next = 0;
+	state->window_len = 0;
+	return 0;
+}
+
+FILE_T
+filed_open(int fd, const char *mode)
+{
+	FILE_T state;
+
+	state = g_malloc(sizeof (struct wtap_reader));
+	state->fd = fd;
+	state->compression = UNKNOWN;
+	state->err = 0;
+	state->eof = FALSE;
+	state->raw_pos = 0;
+	state->pos = 0;
+	state->in = g_malloc(IN_BUF_SIZE);
+	state->out = g_malloc(OUT_BUF_SIZE);
+	state->next = state->out;
+	state->have = 0;
+	state->strm.next_in = state->in;
+	state->strm.avail_in = 0;
+	state->strm_inited = FALSE;
+	state->fast_seek = NULL;
+	state->window = NULL;
+	state->window_next = 0;
+	state->window_len = 0;
+	return state;
+}
+
+FILE_T
+file_open(const char *path, const char *mode)
+{
+	int fd;
+	FILE_T state;
+
+	fd = open(path, O_RDONLY|O_BINARY);
+	if (fd == -1)
+		return NULL;
+	state = filed_open(fd, mode);
+	return state;
+}
+
+void
+file_set_fast_seek(FILE_T state, GPtrArray *fast_seek)
+{
+#ifdef HAVE_FAST_SEEK
+	state->fast_seek = fast_seek;
+	if (state->window == NULL)
+		state->window = g_malloc(WINDOW_SIZE);
+#endif
+}
+
+void
+file_fast_seek_free(GPtrArray *fast_seek)
+{
+	unsigned int i;
+
+	for (i = 0; i < fast_seek->len; i++)
+		g_free(g_ptr_array_index(fast_seek, i));
+	g_ptr_array_free(fast_seek, TRUE);
+}
+
+/* Ask the OS to start reading the next "len" bytes of the file, if it
+   can, so that they're in memory by the time we want them. */
+void
+file_prefetch(FILE_T state, long len)
+{
+#ifdef HAVE_POSIX_FADVISE
+	posix_fadvise(state->fd, state->raw_pos, len, POSIX_FADV_WILLNEED);
+#endif
+}
+
+int
+file_read(void *buf, unsigned int bsize, unsigned int count, FILE_T state)
+{
+	unsigned char *p = buf;
+	unsigned int len = bsize * count;
+	unsigned int n, got = 0;
+
+	while (got < len) {
+		if (state->have == 0) {
+			if (fill_out_buffer(state) < 0 || state->have == 0)
+				break;
+		}
+		n = len - got;
+		if (n > state->have)
+			n = state->have;
+		memcpy(p + got, state->next, n);
+		state->next += n;
+		state->have -= n;
+		state->pos += n;
+		got += n;
+	}
+	if (got == 0 && state->err != 0)
+		return -1;
+	return got;
+}
+
+int
+file_getc(FILE_T state)
+{
+	unsigned char c;
+
+	if (state->have != 0) {
+		state->have--;
+		state->pos++;
+		return *state->next++;
+	}
+	if (file_read(&c, 1, 1, state) != 1)
+		return EOF;
+	return c;
+}
+
+char *
+file_gets(char *buf, int len, FILE_T state)
+{
+	int i, c;
+
+	if (len <= 0)
+		return NULL;
+	for (i = 0; i < len - 1; ) {
+		if ((c = file_getc(state)) == EOF)
+			break;
+		buf[i++] = c;
+		if (c == '\n')
+			break;
+	}
+	if (i == 0)
+		return NULL;
+	buf[i] = '\0';
+	return buf;
+}
+
 long
-file_seek(void *stream, long offset, int whence)
+file_seek(FILE_T state, long offset, int whence)
 {
-	return gzseek(stream, (z_off_t)offset, whence);
+	long	skip;
+	unsigned int n;
+#ifdef HAVE_FAST_SEEK
+	fast_seek_point_t *point;
+#endif
+
+	if (whence == SEEK_CUR)
+		offset += state->pos;
+	else if (whence != SEEK_SET)
+		return -1;	/* "gzseek()" can't do SEEK_END either */
+	if (offset < 0)
+		return -1;
+
+	/* A seek within what's in the output buffer is easy. */
+	if (offset >= state->pos && offset - state->pos <= (long)state->have) {
+		n = offset - state->pos;
+		state->next += n;
+		state->have -= n;
+		state->pos = offset;
+		return offset;
+	}
+	state->err = 0;
+
+	/* Find out whether the file's compressed before deciding how to
+	   get there; a handle that hasn't read anything yet, such as a
+	   random-access handle on its first seek, doesn't know. */
+	if (state->compression == UNKNOWN) {
+		if (look_for_gzip(state) < 0)
+			return -1;
+	}
+
+	if (state->compression == UNCOMPRESSED) {
+		if (lseek(state->fd, offset, SEEK_SET) == -1) {
+			state->err = errno;
+			return -1;
+		}
+		state->raw_pos = offset;
+		state->pos = offset;
+		state->eof = FALSE;
+		state->strm.avail_in = 0;
+		state->have = 0;
+		return offset;
+	}
+
+	/* The file's compressed.  Go to the closest place before the
+	   offset that we can start decompressing from, unless that's
+	   behind where we are, and decompress up to the offset. */
+#ifdef HAVE_FAST_SEEK
+	point = find_point(state, offset);
+	if (point != NULL && state->strm_inited &&
+	    (offset < state->pos || point->out > state->pos)) {
+		if (seek_to_point(state, point) < 0)
+			return -1;
+	} else
+#endif
+	if (offset < state->pos) {
+		if (rewind_file(state) < 0)
+			return -1;
+	}
+
+	skip = offset - state->pos;
+	while (skip > 0) {
+		if (state->have == 0) {
+			if (fill_out_buffer(state) < 0 || state->have == 0)
+				return -1;
+		}
+		n = state->have;
+		if ((long)n > skip)
+			n = skip;
+		state->next += n;
+		state->have -= n;
+		state->pos += n;
+		skip -= n;
+	}
+	return offset;
 }
 
 long
-file_tell(void *stream)
+file_tell(FILE_T state)
 {
-	return (long)gztell(stream);
+	return state->pos;
+}
+
+int
+file_close(FILE_T state)
+{
+	int ret;
+
+	if (state->strm_inited)
+		inflateEnd(&state->strm);
+	ret = close(state->fd);
+	g_free(state->in);
+	g_free(state->out);
+	if (state->window != NULL)
+		g_free(state->window);
+	g_free(state);
+	return ret;
 }
 #endif /* HAVE_LIBZ */
 
@@ -123,25 +869,9 @@ file_tell(void *stream)
  */
 #ifdef HAVE_LIBZ
 int
-file_error(void *fh)
+file_error(FILE_T state)
 {
-	int errnum;
-
-	gzerror(fh, &errnum);
-	switch (errnum) {
-
-	case Z_OK:		/* no error */
-		return 0;
-
-	case Z_STREAM_END:	/* EOF - not an error */
-		return 0;
-
-	case Z_ERRNO:		/* file I/O error */
-		return errno;
-
-	default:
-		return WTAP_ERR_ZLIB + errnum;
-	}
+	return state->err;
 }
 #else /* HAVE_LIBZ */
 int
@@ -152,4 +882,12 @@ file_error(FILE *fh)
 	else
 		return 0;
 }
+
+void
+file_prefetch(FILE *fh, long len)
+{
+#ifdef HAVE_POSIX_FADVISE
+	posix_fadvise(fileno(fh), ftell(fh), len, POSIX_FADV_WILLNEED);
+#endif
+}
 #endif /* HAVE_LIBZ */
@@ -25,16 +25,31 @@
 #define __FILE_H__
 
 #ifdef HAVE_LIBZ
-#define file_open gzopen
-#define filed_open gzdopen
-extern long file_seek(void *stream, long offset, int whence);
-#define file_read(buf, bsize, count, file) gzread((file),(buf),((count)*(bsize)))
-#define file_write(buf, bsize, count, file) gzwrite((file),(buf),((count)*(bsize)))
-#define file_close gzclose
-extern long file_tell(void *stream);
-#define file_getc gzgetc
-#define file_gets(buf, len, file) gzgets((file), (buf), (len))
-extern int file_error(void *fh);
+/*
+ * With zlib, we read files ourselves, rather than through zlib's "gz"
+ * routines, so that we can seek backwards in a compressed file without
+ * decompressing it from the beginning; see "file_wrappers.c".
+ */
+extern FILE_T file_open(const char *path, const char *mode);
+extern FILE_T filed_open(int fd, const char *mode);
+extern long file_seek(FILE_T stream, long offset, int whence);
+extern int file_read(void *buf, unsigned int bsize, unsigned int count,
+    FILE_T file);
+extern int file_close(FILE_T file);
+extern long file_tell(FILE_T stream);
+extern int file_getc(FILE_T stream);
+extern char *file_gets(char *buf, int len, FILE_T stream);
+extern int file_error(FILE_T fh);
+
+/*
+ * Share a list of access points into a compressed file between the
+ * streams reading it; a stream adds an access point every few megabytes
+ * as it reads the file, and seeks to the nearest one before the offset
+ * it's asked to seek to.
+ */
+extern void file_set_fast_seek(FILE_T file, GPtrArray *fast_seek);
+extern void file_fast_seek_free(GPtrArray *fast_seek);
+extern void file_prefetch(FILE_T file, long len);
 
 #else /* No zLib */
 #define file_open fopen
@@ -47,6 +62,9 @@ extern int file_error(FILE *fh);
 #define file_tell ftell
 #define file_getc fgetc
 #define file_gets fgets
+#define file_set_fast_seek(file, fast_seek)
+#define file_fast_seek_free(fast_seek)
+extern void file_prefetch(FILE *fh, long len);
 #endif /* HAVE_LIBZ */
 
 #endif /* __FILE_H__ */
@@ -85,6 +85,7 @@ int lanalyzer_open(wtap *wth, int *err)
 	wth->capture.lanalyzer = g_malloc(sizeof(lanalyzer_t));
 	wth->subtype_read = lanalyzer_read;
 	wth->subtype_seek_read = wtap_def_seek_read;
+	wth->subtype_seek_read_mapped = wtap_def_seek_read_mapped;
 	wth->subtype_close = lanalyzer_close;
 	wth->snapshot_length = 0;
 
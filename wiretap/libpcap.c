@@ -531,6 +531,7 @@ int libpcap_open(wtap *wth, int *err)
 	wth->capture.pcap->version_minor = hdr.version_minor;
 	wth->subtype_read = libpcap_read;
 	wth->subtype_seek_read = wtap_def_seek_read;
+	wth->subtype_seek_read_mapped = wtap_def_seek_read_mapped;
 	wth->subtype_close = libpcap_close;
 	wth->file_encap = file_encap;
 	wth->snapshot_length = hdr.snaplen;
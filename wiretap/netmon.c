@@ -107,6 +107,10 @@ struct netmon_atm_hdr {
 };
 
 static gboolean netmon_read(wtap *wth, int *err, long *data_offset);
+static const guint8 *netmon_seek_read_mapped(wtap *wth, long seek_off,
+    union wtap_pseudo_header *pseudo_header, int length);
+static void netmon_fill_atm_pseudoheader(const struct netmon_atm_hdr *atm_phdr,
+    union wtap_pseudo_header *pseudo_header);
 static int netmon_seek_read(wtap *wth, long seek_off,
     union wtap_pseudo_header *pseudo_header, u_char *pd, int length);
 static int netmon_read_atm_pseudoheader(FILE_T fh,
@@ -203,6 +207,7 @@ int netmon_open(wtap *wth, int *err)
 	wth->capture.netmon = g_malloc(sizeof(netmon_t));
 	wth->subtype_read = netmon_read;
 	wth->subtype_seek_read = netmon_seek_read;
+	wth->subtype_seek_read_mapped = netmon_seek_read_mapped;
 	wth->subtype_close = netmon_close;
 	wth->file_encap = netmon_encap[hdr.network];
 	wth->snapshot_length = 0;	/* not available in header */
@@ -462,6 +467,31 @@ netmon_seek_read(wtap *wth, long seek_off,
 	return netmon_read_rec_data(wth->random_fh, pd, length, &err);
 }
 
+/*
+ * If the file is mapped into memory, return a pointer to the packet
+ * data in the mapping, decoding the ATM pseudo-header, if there is one,
+ * from the mapping as well.
+ */
+static const guint8 *
+netmon_seek_read_mapped(wtap *wth, long seek_off,
+    union wtap_pseudo_header *pseudo_header, int length)
+{
+	const guint8	*rec;
+	struct netmon_atm_hdr atm_phdr;
+
+	if (wth->file_encap == WTAP_ENCAP_ATM_SNIFFER) {
+		rec = wtap_map_range(wth, seek_off,
+		    sizeof (struct netmon_atm_hdr) + length);
+		if (rec == NULL)
+			return NULL;
+		/* The header in the mapping might not be aligned. */
+		memcpy(&atm_phdr, rec, sizeof (struct netmon_atm_hdr));
+		netmon_fill_atm_pseudoheader(&atm_phdr, pseudo_header);
+		return rec + sizeof (struct netmon_atm_hdr);
+	}
+	return wtap_map_range(wth, seek_off, length);
+}
+
 static int
 netmon_read_atm_pseudoheader(FILE_T fh, union wtap_pseudo_header *pseudo_header,
     int *err)
@@ -478,8 +508,16 @@ netmon_read_atm_pseudoheader(FILE_T fh, union wtap_pseudo_header *pseudo_header,
 		return -1;
 	}
 
-	pseudo_header->ngsniffer_atm.Vpi = ntohs(atm_phdr.vpi);
-	pseudo_header->ngsniffer_atm.Vci = ntohs(atm_phdr.vci);
+	netmon_fill_atm_pseudoheader(&atm_phdr, pseudo_header);
+	return 0;
+}
+
+static void
+netmon_fill_atm_pseudoheader(const struct netmon_atm_hdr *atm_phdr,
+    union wtap_pseudo_header *pseudo_header)
+{
+	pseudo_header->ngsniffer_atm.Vpi = ntohs(atm_phdr->vpi);
+	pseudo_header->ngsniffer_atm.Vci = ntohs(atm_phdr->vci);
 
 	/* We don't have this information */
 	pseudo_header->ngsniffer_atm.channel = 0;
@@ -493,8 +531,6 @@ netmon_read_atm_pseudoheader(FILE_T fh, union wtap_pseudo_header *pseudo_header,
 	 */
 	pseudo_header->ngsniffer_atm.AppTrafType = ATT_AAL5|ATT_HL_UNKNOWN;
 	pseudo_header->ngsniffer_atm.AppHLType = AHLT_UNKNOWN;
-
-	return 0;
 }
 
 static int
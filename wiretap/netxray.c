@@ -204,6 +204,7 @@ int netxray_open(wtap *wth, int *err)
 	wth->capture.netxray = g_malloc(sizeof(netxray_t));
 	wth->subtype_read = netxray_read;
 	wth->subtype_seek_read = wtap_def_seek_read;
+	wth->subtype_seek_read_mapped = wtap_def_seek_read_mapped;
 	wth->subtype_close = netxray_close;
 	wth->file_encap = netxray_encap[hdr.network];
 	wth->snapshot_length = 0;	/* not available in header */
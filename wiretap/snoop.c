@@ -57,6 +57,10 @@ struct snooprec_hdr {
 };
 
 static gboolean snoop_read(wtap *wth, int *err, long *data_offset);
+static const guint8 *snoop_seek_read_mapped(wtap *wth, long seek_off,
+    union wtap_pseudo_header *pseudo_header, int length);
+static void snoop_fill_atm_pseudoheader(const guint8 *atm_phdr,
+    union wtap_pseudo_header *pseudo_header);
 static int snoop_seek_read(wtap *wth, long seek_off,
     union wtap_pseudo_header *pseudo_header, u_char *pd, int length);
 static int snoop_read_atm_pseudoheader(FILE_T fh,
@@ -288,6 +292,7 @@ int snoop_open(wtap *wth, int *err)
 	wth->file_type = WTAP_FILE_SNOOP;
 	wth->subtype_read = snoop_read;
 	wth->subtype_seek_read = snoop_seek_read;
+	wth->subtype_seek_read_mapped = snoop_seek_read_mapped;
 	wth->file_encap = file_encap;
 	wth->snapshot_length = 0;	/* not available in header */
 	return 1;
@@ -426,11 +431,32 @@ snoop_seek_read(wtap *wth, long seek_off,
 	return snoop_read_rec_data(wth->random_fh, pd, length, &err);
 }
 
+/*
+ * If the file is mapped into memory, return a pointer to the packet
+ * data in the mapping, decoding the ATM pseudo-header, if there is one,
+ * from the mapping as well.
+ */
+static const guint8 *
+snoop_seek_read_mapped(wtap *wth, long seek_off,
+    union wtap_pseudo_header *pseudo_header, int length)
+{
+	const guint8	*rec;
+
+	if (wth->file_encap == WTAP_ENCAP_ATM_SNIFFER) {
+		rec = wtap_map_range(wth, seek_off, 4 + length);
+		if (rec == NULL)
+			return NULL;
+		snoop_fill_atm_pseudoheader(rec, pseudo_header);
+		return rec + 4;
+	}
+	return wtap_map_range(wth, seek_off, length);
+}
+
 static int
 snoop_read_atm_pseudoheader(FILE_T fh, union wtap_pseudo_header *pseudo_header,
     int *err)
 {
-	char	atm_phdr[4];
+	guint8	atm_phdr[4];
 	int	bytes_read;
 
 	errno = WTAP_ERR_CANT_READ;
@@ -442,6 +468,14 @@ snoop_read_atm_pseudoheader(FILE_T fh, union wtap_pseudo_header *pseudo_header,
 		return -1;
 	}
 
+	snoop_fill_atm_pseudoheader(atm_phdr, pseudo_header);
+	return 0;
+}
+
+static void
+snoop_fill_atm_pseudoheader(const guint8 *atm_phdr,
+    union wtap_pseudo_header *pseudo_header)
+{
 	pseudo_header->ngsniffer_atm.channel = (atm_phdr[0] & 0x80) ? 1 : 0;
 	pseudo_header->ngsniffer_atm.Vpi = atm_phdr[1];
 	pseudo_header->ngsniffer_atm.Vci = pntohs(&atm_phdr[2]);
@@ -463,8 +497,6 @@ snoop_read_atm_pseudoheader(FILE_T fh, union wtap_pseudo_header *pseudo_header,
 	 */
 	pseudo_header->ngsniffer_atm.AppTrafType = ATT_AAL5|ATT_HL_UNKNOWN;
 	pseudo_header->ngsniffer_atm.AppHLType = AHLT_UNKNOWN;
-
-	return 0;
 }
 
 static int
@@ -42,7 +42,7 @@
 
 #ifdef HAVE_LIBZ
 #include "zlib.h"
-#define FILE_T	gzFile
+#define FILE_T	struct wtap_reader *
 #else /* No zLib */
 #define FILE_T	FILE *
 #endif /* HAVE_LIBZ */
@@ -123,10 +123,17 @@ typedef struct {
 typedef int (*subtype_read_func)(struct wtap*, int*, long*);
 typedef int (*subtype_seek_read_func)(struct wtap*, long, union wtap_pseudo_header*,
 					guint8*, int);
+typedef const guint8 *(*subtype_seek_read_mapped_func)(struct wtap*, long,
+					union wtap_pseudo_header*, int);
 struct wtap {
 	FILE_T			fh;
         int                     fd;           /* File descriptor for cap file */
 	FILE_T			random_fh;    /* Secondary FILE_T for random access */
+	int			map_fd;	      /* descriptor for mapping the file, or -1 */
+	guint8			*map;	      /* file mapped for random access, or NULL */
+	long			map_len;
+	GSList			*old_maps;    /* earlier mappings, unmapped on close */
+	GPtrArray		*fast_seek;   /* access points into a compressed file */
 	int			file_type;
 	int			snapshot_length;
 	struct Buffer		*frame_buffer;
@@ -151,6 +158,7 @@ struct wtap {
 
 	subtype_read_func	subtype_read;
 	subtype_seek_read_func	subtype_seek_read;
+	subtype_seek_read_mapped_func	subtype_seek_read_mapped;
 	void			(*subtype_sequential_close)(struct wtap*);
 	void			(*subtype_close)(struct wtap*);
 	int			file_encap;	/* per-file, for those
@@ -159,6 +167,19 @@ struct wtap {
 						   types */
 };
 
+/* Return a pointer to "len" bytes of the file, starting at "offset",
+ * in a memory mapping of the file, or NULL if the file can't be mapped
+ * or doesn't have that many bytes. */
+const guint8 *wtap_map_range(struct wtap *wth, long offset, int len);
+
+/* Unmap all mappings of the file. */
+void wtap_unmap(struct wtap *wth);
+
+/* For file types whose records are stored as raw packet data, with
+ * no pseudo-header, at the offset "wtap_def_seek_read()" reads from. */
+const guint8 *wtap_def_seek_read_mapped(struct wtap *wth, long seek_off,
+	union wtap_pseudo_header *pseudo_header, int len);
+
 struct wtap_dumper;
 
 typedef gboolean (*subtype_write_func)(struct wtap_dumper*,
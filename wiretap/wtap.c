@@ -261,6 +261,11 @@ wtap_close(wtap *wth)
 	if (wth->random_fh != NULL)
 		file_close(wth->random_fh);
 
+	wtap_unmap(wth);
+
+	if (wth->fast_seek != NULL)
+		file_fast_seek_free(wth->fast_seek);
+
 	g_free(wth);
 }
 
@@ -270,6 +275,86 @@ wtap_read(wtap *wth, int *err, long *data_offset)
 	return wth->subtype_read(wth, err, data_offset);
 }
 
+/* Stop filling a batch once it has this much packet data in it. */
+#define BATCH_MAX_BYTES	(1024*1024)
+
+struct wtap_batch *
+wtap_batch_new(int max_packets)
+{
+	struct wtap_batch *batch;
+
+	batch = g_malloc(sizeof (struct wtap_batch));
+	batch->max_packets = max_packets;
+	batch->count = 0;
+	batch->phdrs = g_malloc(max_packets * sizeof (struct wtap_pkthdr));
+	batch->pseudo_headers =
+	    g_malloc(max_packets * sizeof (union wtap_pseudo_header));
+	batch->data_offsets = g_malloc(max_packets * sizeof (long));
+	batch->data = g_malloc(max_packets * sizeof (guint8 *));
+	batch->block_size = 65536;
+	batch->block = g_malloc(batch->block_size);
+	batch->block_len = 0;
+	return batch;
+}
+
+void
+wtap_batch_free(struct wtap_batch *batch)
+{
+	g_free(batch->phdrs);
+	g_free(batch->pseudo_headers);
+	g_free(batch->data_offsets);
+	g_free(batch->data);
+	g_free(batch->block);
+	g_free(batch);
+}
+
+gboolean
+wtap_read_batch(wtap *wth, struct wtap_batch *batch, int *err)
+{
+	guint32 caplen;
+	size_t off;
+	int i;
+
+	*err = 0;
+	batch->count = 0;
+	batch->block_len = 0;
+	while (batch->count < batch->max_packets &&
+	    batch->block_len < BATCH_MAX_BYTES) {
+		if (!wth->subtype_read(wth, err,
+		    &batch->data_offsets[batch->count]))
+			break;
+
+		caplen = wth->phdr.caplen;
+		if (batch->block_len + caplen > batch->block_size) {
+			do
+				batch->block_size *= 2;
+			while (batch->block_len + caplen > batch->block_size);
+			batch->block = g_realloc(batch->block,
+			    batch->block_size);
+		}
+		memcpy(batch->block + batch->block_len,
+		    buffer_start_ptr(wth->frame_buffer), caplen);
+		batch->block_len += caplen;
+		batch->phdrs[batch->count] = wth->phdr;
+		batch->pseudo_headers[batch->count] = wth->pseudo_header;
+		batch->count++;
+	}
+
+	/* Now that the block can't move, point to each packet's data. */
+	off = 0;
+	for (i = 0; i < batch->count; i++) {
+		batch->data[i] = batch->block + off;
+		off += batch->phdrs[i].caplen;
+	}
+
+	/* Have the OS start reading the next batch's worth of the file
+	   while our caller works on this one. */
+	if (batch->count != 0 && *err == 0 && wth->fh != NULL)
+		file_prefetch(wth->fh, (long)batch->block_len);
+
+	return batch->count != 0;
+}
+
 struct wtap_pkthdr*
 wtap_phdr(wtap *wth)
 {
@@ -288,20 +373,43 @@ wtap_buf_ptr(wtap *wth)
 	return buffer_start_ptr(wth->frame_buffer);
 }
 
+/* Number of packets "wtap_loop()" reads at a time. */
+#define LOOP_BATCH_PACKETS	256
+
 gboolean
 wtap_loop(wtap *wth, int count, wtap_handler callback, u_char* user, int *err)
 {
 	long		data_offset;
 	int		loop = 0;
+	struct wtap_batch *batch;
+	int		i;
 
 	/* Start by clearing error flag */
 	*err = 0;
 
-	while ( (wtap_read(wth, err, &data_offset)) ) {
-		callback(user, &wth->phdr, data_offset,
-		    &wth->pseudo_header, buffer_start_ptr(wth->frame_buffer));
-		if (count > 0 && ++loop >= count)
-			break;
+	if (count <= 0) {
+		/* Read the whole file, a batch at a time, so that the
+		   OS can read ahead while the callback runs. */
+		batch = wtap_batch_new(LOOP_BATCH_PACKETS);
+		while (wtap_read_batch(wth, batch, err)) {
+			for (i = 0; i < batch->count; i++) {
+				callback(user, &batch->phdrs[i],
+				    batch->data_offsets[i],
+				    &batch->pseudo_headers[i],
+				    batch->data[i]);
+			}
+			if (*err != 0)
+				break;
+		}
+		wtap_batch_free(batch);
+	} else {
+		while ( (wtap_read(wth, err, &data_offset)) ) {
+			callback(user, &wth->phdr, data_offset,
+			    &wth->pseudo_header,
+			    buffer_start_ptr(wth->frame_buffer));
+			if (++loop >= count)
+				break;
+		}
 	}
 
 	if (*err == 0)
@@ -316,3 +424,32 @@ wtap_seek_read(wtap *wth, long seek_off,
 {
 	return wth->subtype_seek_read(wth, seek_off, pseudo_header, pd, len);
 }
+
+const guint8 *
+wtap_seek_read_data(wtap *wth, long seek_off,
+	union wtap_pseudo_header *pseudo_header, guint8 *pd, int len)
+{
+	const guint8	*data;
+
+	if (wth->subtype_seek_read_mapped != NULL) {
+		data = wth->subtype_seek_read_mapped(wth, seek_off,
+		    pseudo_header, len);
+		if (data != NULL)
+			return data;
+	}
+	wth->subtype_seek_read(wth, seek_off, pseudo_header, pd, len);
+	return pd;
+}
+
+gboolean
+wtap_seek_sequential(wtap *wth, long seek_off, int *err)
+{
+	if (file_seek(wth->fh, seek_off, SEEK_SET) == -1) {
+		*err = file_error(wth->fh);
+		if (*err == 0)
+			*err = errno;
+		return FALSE;
+	}
+	wth->data_offset = seek_off;
+	return TRUE;
+}
@@ -321,6 +321,34 @@ gboolean wtap_loop(wtap *wth, int, wtap_handler, u_char*, int *err);
  * located. */
 gboolean wtap_read(wtap *wth, int *err, long *data_offset);
 
+/*
+ * A batch of packets, as read by "wtap_read_batch()".  The data for all
+ * the packets is in one contiguous block; "data[i]" points to the data
+ * for packet "i", and is valid until the next read into the batch.
+ */
+struct wtap_batch {
+	int	max_packets;	/* room for this many packets */
+	int	count;		/* number of packets read */
+	struct wtap_pkthdr *phdrs;
+	union wtap_pseudo_header *pseudo_headers;
+	long	*data_offsets;	/* offset in the file of each packet */
+	guint8	**data;
+	guint8	*block;		/* data for all the packets */
+	size_t	block_len;	/* bytes of data in "block" */
+	size_t	block_size;	/* bytes allocated for "block" */
+};
+
+struct wtap_batch *wtap_batch_new(int max_packets);
+void wtap_batch_free(struct wtap_batch *batch);
+
+/* Reads up to "batch->max_packets" packets into "batch", and asks the
+ * OS to start reading the data after them, so that it can be read in
+ * while the caller processes these packets.  Returns TRUE if any packets
+ * were read, FALSE at the end of the file or on a read failure.  If a
+ * read fails after some packets have been read, TRUE is returned, with
+ * err set; the caller should process the packets read and then stop. */
+gboolean wtap_read_batch(wtap *wth, struct wtap_batch *batch, int *err);
+
 struct wtap_pkthdr *wtap_phdr(wtap *wth);
 union wtap_pseudo_header *wtap_pseudoheader(wtap *wth);
 guint8 *wtap_buf_ptr(wtap *wth);
@@ -346,12 +374,28 @@ int wtap_seek_read (wtap *wth, long seek_off,
 int wtap_def_seek_read (wtap *wth, long seek_off,
 	union wtap_pseudo_header *pseudo_header, guint8 *pd, int len);
 
+/* Like "wtap_seek_read()", but, if the file can be memory-mapped and
+ * its records hold the raw packet data, returns a pointer to the data
+ * in the mapping, without reading or copying it; otherwise, reads the
+ * data into "pd" and returns "pd".  The pointer remains valid until
+ * the file is closed. */
+const guint8 *wtap_seek_read_data (wtap *wth, long seek_off,
+	union wtap_pseudo_header *pseudo_header, guint8 *pd, int len);
+
+/* Move the sequential read position to "seek_off", which must be the
+ * offset of the start of a record; "wtap_read()" will next read that
+ * record.  Only meaningful for file types whose sequential read keeps no
+ * state beyond the file offset, such as libpcap. */
+gboolean wtap_seek_sequential (wtap *wth, long seek_off, int *err);
+
 gboolean wtap_dump_can_open(int filetype);
 gboolean wtap_dump_can_write_encap(int filetype, int encap);
 wtap_dumper* wtap_dump_open(const char *filename, int filetype, int encap,
 	int snaplen, int *err);
 wtap_dumper* wtap_dump_fdopen(int fd, int filetype, int encap, int snaplen,
 	int *err);
+wtap_dumper* wtap_dump_fdopen_buffered(int fd, int filetype, int encap,
+	int snaplen, char *buf, size_t bufsize, int *err);
 gboolean wtap_dump(wtap_dumper *, const struct wtap_pkthdr *,
 	const union wtap_pseudo_header *pseudo_header, const u_char *, int *err);
 FILE* wtap_dump_file(wtap_dumper *);